@@ -0,0 +1,412 @@
+// Benchmarks for the simulator's hot paths. Build from the repository root with
+//   g++ -std=c++17 -O2 -pthread benchmarks/Benchmark.cpp $(ls cpp_files/*.cpp | grep -v Main.cpp) -o benchmark
+// and run ./benchmark --help for options. Results are written as CSV, one row per measurement;
+// --baseline compares against an earlier CSV and exits non-zero when a case got slower.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <map>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include "../h_files/Complex.h"
+#include "../h_files/Matrix.h"
+#include "../h_files/Gates.h"
+#include "../h_files/Circuit.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    int maxQubits = 20;
+    int denseQubits = 10;     // calculateTotalMatrix and Dense mode are O(8^n)
+    int maxThreads = int(std::max(1u, std::thread::hardware_concurrency()));
+    double minSeconds = 0.2;  // each case repeats until it has run this long
+    std::string output = "benchmark_results.csv";
+    std::string baseline;
+    double tolerance = 0.10;  // allowed slowdown against the baseline
+};
+
+struct Result {
+    std::string benchmark;
+    std::string workload;
+    int qubits;
+    int threads;
+    long iterations;
+    double secondsPerIteration;
+    double gates;       // gates (or element operations) per iteration
+    double stateBytes;  // bytes of state read and written per iteration, 0 when not meaningful
+};
+
+volatile double sink;
+
+// Repeats body until minSeconds have passed and returns seconds per call
+std::pair<long, double> timeIt(double minSeconds, const std::function<void()>& body) {
+    body();  // warm-up: first-touch allocation and lazy state
+    long iterations = 0;
+    const auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        body();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return {iterations, elapsed / iterations};
+}
+
+std::shared_ptr<QuantumComponent> gate(const std::string& name) {
+    return QuantumComponentFactory::create(name);
+}
+
+Circuit ghz(int n) {
+    Circuit circuit(n);
+    circuit.addGate(gate("Hadamard"), 0, 0);
+    for (int q = 1; q < n; ++q) {
+        circuit.addControlledGate(gate("Pauli-X"), {q - 1}, q, q);
+    }
+    return circuit;
+}
+
+Circuit qft(int n) {
+    const double pi = std::acos(-1.0);
+    Circuit circuit(n);
+    int timestep = 0;
+    for (int target = n - 1; target >= 0; --target) {
+        circuit.addGate(gate("Hadamard"), target, timestep++);
+        for (int control = target - 1; control >= 0; --control) {
+            const double angle = pi / double(1 << (target - control));
+            circuit.addControlledGate(QuantumComponentFactory::create("Phase", {angle}), {control}, target, timestep++);
+        }
+    }
+    for (int q = 0; q < n / 2; ++q) {
+        const int other = n - 1 - q;
+        circuit.addControlledGate(gate("Pauli-X"), {q}, other, timestep++);
+        circuit.addControlledGate(gate("Pauli-X"), {other}, q, timestep++);
+        circuit.addControlledGate(gate("Pauli-X"), {q}, other, timestep++);
+    }
+    return circuit;
+}
+
+// Alternating layers of random single-qubit gates on every qubit and CNOTs on random disjoint pairs
+Circuit randomCircuit(int n, int depth, unsigned seed) {
+    std::mt19937 rng(seed);
+    const char* fixed[] = {"Hadamard", "Pauli-X", "Pauli-Y", "Pauli-Z", "S-Gate", "T-Gate"};
+    std::uniform_real_distribution<double> angle(0, 2 * std::acos(-1.0));
+    Circuit circuit(n);
+    std::vector<int> order(n);
+    for (int layer = 0; layer < depth; ++layer) {
+        for (int q = 0; q < n; ++q) {
+            if (rng() % 4 == 0) {
+                circuit.addGate(QuantumComponentFactory::create("Ry", {angle(rng)}), q, 2 * layer);
+            } else {
+                circuit.addGate(gate(fixed[rng() % 6]), q, 2 * layer);
+            }
+        }
+        for (int q = 0; q < n; ++q) {
+            order[q] = q;
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int p = 0; p + 1 < n; p += 2) {
+            circuit.addControlledGate(gate("Pauli-X"), {order[p]}, order[p + 1], 2 * layer + 1);
+        }
+    }
+    return circuit;
+}
+
+// Grover search for |1...1>: the oracle and the diffusion reflection are both n-1 controlled Zs
+Circuit grover(int n, int maxIterations) {
+    Circuit circuit(n);
+    std::vector<int> controls;
+    for (int q = 0; q + 1 < n; ++q) {
+        controls.push_back(q);
+    }
+    int timestep = 0;
+    auto layer = [&](const char* name) {
+        for (int q = 0; q < n; ++q) {
+            circuit.addGate(gate(name), q, timestep);
+        }
+        ++timestep;
+    };
+    layer("Hadamard");
+    const int optimal = std::max(1, int(std::acos(-1.0) / 4 * std::sqrt(double(1 << n))));
+    for (int iteration = 0; iteration < std::min(optimal, maxIterations); ++iteration) {
+        circuit.addControlledGate(gate("Pauli-Z"), controls, n - 1, timestep++);
+        layer("Hadamard");
+        layer("Pauli-X");
+        circuit.addControlledGate(gate("Pauli-Z"), controls, n - 1, timestep++);
+        layer("Pauli-X");
+        layer("Hadamard");
+    }
+    return circuit;
+}
+
+Circuit workload(const std::string& name, int n) {
+    if (name == "ghz") return ghz(n);
+    if (name == "qft") return qft(n);
+    if (name == "random") return randomCircuit(n, 20, 1234);
+    return grover(n, 8);
+}
+
+class Suite {
+public:
+    explicit Suite(const Options& options) : options(options) {}
+
+    void add(Result result) {
+        std::cout << result.benchmark << " " << result.workload << " n=" << result.qubits << " t=" << result.threads
+                  << ": " << result.secondsPerIteration * 1e6 << " us";
+        if (result.gates > 0) {
+            std::cout << ", " << result.secondsPerIteration * 1e9 / result.gates << " ns/gate";
+        }
+        if (result.stateBytes > 0) {
+            std::cout << ", " << result.stateBytes / result.secondsPerIteration / 1e9 << " GB/s";
+        }
+        std::cout << '\n';
+        results.push_back(result);
+    }
+
+    void complexArithmetic() {
+        const int n = 1 << 16;
+        std::vector<Complex> a(n, Complex(0.5, 0.25)), b(n, Complex(0.999, 0.01));
+        auto [iterations, seconds] = timeIt(options.minSeconds, [&] {
+            Complex acc(0, 0);
+            for (int i = 0; i < n; ++i) {
+                acc = acc + a[i] * b[i];
+            }
+            sink = acc.get_real();
+        });
+        add({"complex_multiply_add", "vector", 0, 1, iterations, seconds, double(n), 0});
+    }
+
+    void matrixProduct() {
+        for (int size = 16; size <= 256; size *= 2) {
+            Matrix a = randomMatrix(size, size), b = randomMatrix(size, size);
+            for (int threads : threadCounts()) {
+                ThreadPool pool(threads);
+                auto [iterations, seconds] = timeIt(options.minSeconds, [&] {
+                    Matrix c = Matrix::multiply(a, b, threads > 1 ? &pool : nullptr);
+                    sink = c(1, 1).get_real();
+                });
+                add({"matrix_multiply", std::to_string(size), 0, threads, iterations, seconds, double(size) * size * size, 0});
+            }
+        }
+    }
+
+    void kroneckerChain() {
+        const Matrix& h = gate("Hadamard")->getMatrixRef();
+        for (int n = 4; n <= options.denseQubits; n += 2) {
+            auto [iterations, seconds] = timeIt(options.minSeconds, [&] {
+                Matrix result = Matrix::identityMatrix(1);
+                for (int q = 0; q < n; ++q) {
+                    result = Matrix::kroneckerProduct(h, result);
+                }
+                sink = result(1, 1).get_real();
+            });
+            const double elements = double(1 << n) * (1 << n);
+            add({"kronecker_product", "hadamard_chain", n, 1, iterations, seconds, 0, elements * sizeof(Complex)});
+        }
+        // (H (x) ... (x) H) v through the lazy product, which never forms the 2^n x 2^n matrix
+        for (int n = 4; n <= options.maxQubits; n += 4) {
+            const KroneckerExpression<double> chain(std::vector<const Matrix*>(n, &h));
+            Matrix v(1 << n, 1);
+            v(1, 1) = Complex(1, 0);
+            auto [iterations, seconds] = timeIt(options.minSeconds, [&] {
+                Matrix result = chain * v;
+                sink = result(1, 1).get_real();
+            });
+            add({"kronecker_apply", "hadamard_chain", n, 1, iterations, seconds, 0, double(1 << n) * sizeof(Complex)});
+        }
+    }
+
+    void denseMatrices(const std::string& name) {
+        for (int n = 2; n <= options.denseQubits; n += 2) {
+            Circuit circuit = workload(name, n);
+            // Without the unitary cache every iteration after the first would be a lookup
+            circuit.setUnitaryCacheCapacity(0);
+            auto [stepIterations, stepSeconds] = timeIt(options.minSeconds, [&] {
+                sink = circuit.calculateTimestepMatrix(0)(1, 1).get_real();
+            });
+            add({"calculate_timestep_matrix", name, n, 1, stepIterations, stepSeconds, 0, 0});
+            if (n > 8) {
+                continue;  // the full product multiplies a 2^n x 2^n matrix per timestep
+            }
+            auto [totalIterations, totalSeconds] = timeIt(options.minSeconds, [&] {
+                sink = circuit.calculateTotalMatrix()(1, 1).get_real();
+            });
+            add({"calculate_total_matrix", name, n, 1, totalIterations, totalSeconds,
+                 double(circuit.getOperations().size()), 0});
+            // A fresh cache per iteration: only the reuse of repeated layers within one product counts
+            auto [cachedIterations, cachedSeconds] = timeIt(options.minSeconds, [&] {
+                circuit.setUnitaryCacheCapacity(std::size_t(256) << 20);
+                sink = circuit.calculateTotalMatrix()(1, 1).get_real();
+            });
+            add({"calculate_total_matrix_cached", name, n, 1, cachedIterations, cachedSeconds,
+                 double(circuit.getOperations().size()), 0});
+            circuit.setUnitaryCacheCapacity(0);
+        }
+    }
+
+    void applyCircuit(const std::string& name) {
+        for (int n = 4; n <= options.maxQubits; n += 2) {
+            runApply(name, n, 1, SimulationMode::StateVector);
+            runApply(name, n, 1, SimulationMode::StateVector, Precision::Single);
+            if (n <= 8) {
+                runApply(name, n, 1, SimulationMode::Dense);
+            }
+        }
+        // Thread scaling curve at the largest size
+        for (int threads : threadCounts()) {
+            if (threads > 1) {
+                runApply(name, options.maxQubits, threads, SimulationMode::StateVector);
+            }
+        }
+    }
+
+    void write() const {
+        std::ofstream out(options.output);
+        out << "benchmark,workload,qubits,threads,iterations,seconds_per_iteration,ns_per_gate,gb_per_s\n";
+        for (const Result& r : results) {
+            out << r.benchmark << ',' << r.workload << ',' << r.qubits << ',' << r.threads << ',' << r.iterations << ','
+                << r.secondsPerIteration << ',' << (r.gates > 0 ? r.secondsPerIteration * 1e9 / r.gates : 0) << ','
+                << (r.stateBytes > 0 ? r.stateBytes / r.secondsPerIteration / 1e9 : 0) << '\n';
+        }
+        std::cout << "\nWrote " << results.size() << " results to " << options.output << '\n';
+    }
+
+    // Returns the number of cases that are slower than the baseline by more than the tolerance
+    int compare() const {
+        std::ifstream in(options.baseline);
+        if (!in) {
+            std::cerr << "Cannot open baseline " << options.baseline << '\n';
+            return 1;
+        }
+        std::map<std::string, double> previous;
+        std::string line;
+        std::getline(in, line);
+        while (std::getline(in, line)) {
+            std::stringstream fields(line);
+            std::string benchmark, name, qubits, threads, iterations, seconds;
+            std::getline(fields, benchmark, ',');
+            std::getline(fields, name, ',');
+            std::getline(fields, qubits, ',');
+            std::getline(fields, threads, ',');
+            std::getline(fields, iterations, ',');
+            std::getline(fields, seconds, ',');
+            previous[benchmark + ',' + name + ',' + qubits + ',' + threads] = std::stod(seconds);
+        }
+
+        int regressions = 0;
+        for (const Result& r : results) {
+            auto it = previous.find(r.benchmark + ',' + r.workload + ',' + std::to_string(r.qubits) + ',' +
+                                    std::to_string(r.threads));
+            if (it == previous.end()) {
+                continue;
+            }
+            const double ratio = r.secondsPerIteration / it->second;
+            if (ratio > 1 + options.tolerance) {
+                ++regressions;
+                std::cout << "REGRESSION " << it->first << ": " << ratio << "x slower than baseline\n";
+            }
+        }
+        std::cout << regressions << " regressions against " << options.baseline << '\n';
+        return regressions;
+    }
+
+private:
+    const Options& options;
+    std::vector<Result> results;
+
+    std::vector<int> threadCounts() const {
+        std::vector<int> counts;
+        for (int threads = 1; threads < options.maxThreads; threads *= 2) {
+            counts.push_back(threads);
+        }
+        counts.push_back(options.maxThreads);
+        return counts;
+    }
+
+    static Matrix randomMatrix(int rows, int cols) {
+        std::mt19937 rng(rows * 31 + cols);
+        std::uniform_real_distribution<double> value(-1, 1);
+        Matrix m(rows, cols);
+        for (int i = 1; i <= rows; ++i) {
+            for (int j = 1; j <= cols; ++j) {
+                m(i, j) = Complex(value(rng), value(rng));
+            }
+        }
+        return m;
+    }
+
+    void runApply(const std::string& name, int n, int threads, SimulationMode mode, Precision precision = Precision::Double) {
+        Circuit circuit = workload(name, n);
+        circuit.setVerbose(false);
+        circuit.setThreadCount(threads);
+        circuit.setSimulationMode(mode);
+        circuit.setPrecision(precision);
+        auto [iterations, seconds] = timeIt(options.minSeconds, [&] {
+            circuit.applyCircuit();
+        });
+        const double gates = double(circuit.getOperations().size());
+        // Every gate streams the whole state in and out once
+        const double amplitudeBytes = precision == Precision::Double ? sizeof(Complex) : sizeof(ComplexF);
+        const double bytes = mode == SimulationMode::Dense ? 0 : gates * 2.0 * double(1 << n) * amplitudeBytes;
+        std::string benchmark = mode == SimulationMode::Dense ? "apply_circuit_dense" : "apply_circuit";
+        if (precision != Precision::Double) {
+            benchmark += "_fp32";
+        }
+        add({benchmark, name, n, threads, iterations, seconds, gates, bytes});
+    }
+};
+
+void printUsage() {
+    std::cout << "Usage: benchmark [--quick] [--max-qubits N] [--dense-qubits N] [--threads N] [--min-time S]\n"
+                 "                 [--output results.csv] [--baseline previous.csv] [--tolerance 0.1]\n";
+}
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--quick") {
+            options.maxQubits = 14;
+            options.denseQubits = 8;
+            options.minSeconds = 0.05;
+        } else if (arg == "--max-qubits" && hasValue) {
+            options.maxQubits = std::stoi(argv[++i]);
+        } else if (arg == "--dense-qubits" && hasValue) {
+            options.denseQubits = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.maxThreads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--min-time" && hasValue) {
+            options.minSeconds = std::stod(argv[++i]);
+        } else if (arg == "--output" && hasValue) {
+            options.output = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baseline = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            options.tolerance = std::stod(argv[++i]);
+        } else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    Suite suite(options);
+    suite.complexArithmetic();
+    suite.matrixProduct();
+    suite.kroneckerChain();
+    for (const char* name : {"ghz", "qft", "random", "grover"}) {
+        suite.denseMatrices(name);
+        suite.applyCircuit(name);
+    }
+    suite.write();
+    if (!options.baseline.empty()) {
+        return suite.compare() > 0 ? 1 : 0;
+    }
+    return 0;
+}
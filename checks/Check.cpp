@@ -0,0 +1,834 @@
+// Correctness checks that compare the simulator's fast paths with slower reference results.
+// Build from the repository root with
+//   g++ -std=c++17 -O2 -pthread checks/Check.cpp $(ls cpp_files/*.cpp | grep -v Main.cpp) -o check
+// and run ./check [--seed N]. Each check prints the worst deviation it found; the exit code is
+// non-zero when any check exceeds its tolerance or throws.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <functional>
+#include <filesystem>
+#include "../h_files/Complex.h"
+#include "../h_files/Matrix.h"
+#include "../h_files/Gates.h"
+#include "../h_files/Circuit.h"
+#include "../h_files/Observable.h"
+#include "../h_files/CircuitIO.h"
+#include "../h_files/OutOfCore.h"
+
+namespace {
+using Rng = std::mt19937;
+
+struct Check {
+    std::string name;
+    double tolerance;
+    std::function<double(Rng&)> run;  // worst deviation from the reference
+};
+
+std::shared_ptr<QuantumComponent> gate(const std::string& name, const std::vector<double>& angles = {}) {
+    return QuantumComponentFactory::create(name, angles);
+}
+
+double maxDifference(const Matrix& a, const Matrix& b) {
+    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+        throw std::runtime_error("Results have different dimensions");
+    }
+    double worst = 0;
+    for (int i = 0; i < a.getRows() * a.getCols(); ++i) {
+        worst = std::max(worst, double((a.data()[i] - b.data()[i]).modulus()));
+    }
+    return worst;
+}
+
+// Compares states that may differ by a global phase, as stabilizer amplitudes do
+double maxDifferenceUpToPhase(const Matrix& reference, const Matrix& state) {
+    if (reference.getRows() != state.getRows()) {
+        throw std::runtime_error("States have different dimensions");
+    }
+    Complex overlap(0, 0);
+    for (int i = 0; i < reference.getRows(); ++i) {
+        overlap += state.data()[i].conjugate() * reference.data()[i];
+    }
+    const double size = overlap.modulus();
+    const Complex phase = size > 0 ? Complex(overlap.get_real() / size, overlap.get_imag() / size) : Complex(1, 0);
+    double worst = 0;
+    for (int i = 0; i < reference.getRows(); ++i) {
+        worst = std::max(worst, double((reference.data()[i] - phase * state.data()[i]).modulus()));
+    }
+    return worst;
+}
+
+// The state applyCircuit leaves in StateVector mode, the reference for the other backends
+Matrix stateVectorResult(const Circuit& circuit) {
+    Circuit reference(circuit);
+    reference.setVerbose(false);
+    reference.setSimulationMode(SimulationMode::StateVector);
+    reference.applyCircuit();
+    return reference.getStateVector();
+}
+
+// Layers of random single-qubit gates and rotations, each followed by a controlled gate on a
+// random, not necessarily adjacent, pair of qubits
+Circuit randomCircuit(int qubits, int depth, Rng& rng) {
+    const char* fixed[] = {"Hadamard", "Pauli-X", "Pauli-Y", "Pauli-Z", "S-Gate", "T-Gate"};
+    const char* controlled[] = {"Pauli-X", "Pauli-Z", "Hadamard"};
+    std::uniform_real_distribution<double> angle(-3, 3);
+    Circuit circuit(qubits);
+    circuit.setVerbose(false);
+    for (int layer = 0; layer < depth; ++layer) {
+        for (int q = 0; q < qubits; ++q) {
+            const int kind = rng() % 8;
+            if (kind < 6) {
+                circuit.addGate(gate(fixed[kind]), q, 2 * layer);
+            } else if (kind == 6) {
+                circuit.addGate(gate("U3", {angle(rng), angle(rng), angle(rng)}), q, 2 * layer);
+            } else {
+                circuit.addGate(gate("Ry", {angle(rng)}), q, 2 * layer);
+            }
+        }
+        if (qubits > 1) {
+            const int control = rng() % qubits, target = (control + 1 + rng() % (qubits - 1)) % qubits;
+            if (rng() % 2) {
+                circuit.addControlledGate(gate(controlled[rng() % 3]), {control}, target, 2 * layer + 1);
+            } else {
+                circuit.addControlledGate(gate("Rz", {angle(rng)}), {control}, target, 2 * layer + 1);
+            }
+        }
+    }
+    return circuit;
+}
+
+// The same with Clifford gates only: H, S and Paulis, controlled X, Y and Z, and fixed CNOT blocks
+Circuit cliffordCircuit(int qubits, int depth, Rng& rng) {
+    const char* fixed[] = {"Hadamard", "Pauli-X", "Pauli-Y", "Pauli-Z", "S-Gate", "Identity"};
+    const char* controlled[] = {"Pauli-X", "Pauli-Y", "Pauli-Z"};
+    Circuit circuit(qubits);
+    circuit.setVerbose(false);
+    for (int layer = 0; layer < depth; ++layer) {
+        for (int q = 0; q < qubits; ++q) {
+            circuit.addGate(gate(fixed[rng() % 6]), q, 2 * layer);
+        }
+        if (qubits > 1 && rng() % 4 == 0) {
+            const int low = rng() % (qubits - 1);
+            circuit.addGate(gate("CNOTtarget"), low, 2 * layer + 1);
+            circuit.addGate(gate("CNOTcontrol"), low + 1, 2 * layer + 1);
+        } else if (qubits > 1) {
+            const int control = rng() % qubits, target = (control + 1 + rng() % (qubits - 1)) % qubits;
+            circuit.addControlledGate(gate(controlled[rng() % 3]), {control}, target, 2 * layer + 1);
+        }
+    }
+    return circuit;
+}
+
+// Random gates with redundancy planted on purpose: self-inverse and phase gates, rotations by
+// multiples of pi/4, identities, controlled gates, fixed CNOT blocks, and runs of gates repeated
+// on one qubit so that pairs meet across commuting neighbours
+Circuit redundantCircuit(int qubits, int gates, Rng& rng) {
+    const double quarter = std::acos(-1.0) / 4;
+    const char* fixed[] = {"Hadamard", "Pauli-X", "Pauli-Y", "Pauli-Z", "S-Gate", "T-Gate", "Identity"};
+    const char* controlled[] = {"Pauli-X", "Pauli-Z", "S-Gate", "T-Gate", "Hadamard"};
+    const char* rotations[] = {"Rx", "Ry", "Rz"};
+    Circuit circuit(qubits);
+    int timestep = 0;
+    for (int g = 0; g < gates; ++g, ++timestep) {
+        const int target = rng() % qubits;
+        const int kind = rng() % 11;
+        if (kind < 7) {
+            circuit.addGate(gate(fixed[kind]), target, timestep);
+        } else if (kind == 7) {
+            circuit.addGate(gate(rotations[rng() % 3], {double(rng() % 16) * quarter - 1}), target, timestep);
+        } else if (kind == 8) {
+            circuit.addGate(gate("Phase", {double(rng() % 8) * quarter}), target, timestep);
+        } else if (kind == 9 && qubits > 1) {
+            const int control = (target + 1 + rng() % (qubits - 1)) % qubits;
+            circuit.addControlledGate(gate(controlled[rng() % 5]), {control}, target, timestep);
+        } else if (kind == 10 && qubits > 1 && rng() % 3 == 0) {
+            const int low = rng() % (qubits - 1);
+            circuit.addGate(gate("CNOTtarget"), low, timestep);
+            circuit.addGate(gate("CNOTcontrol"), low + 1, timestep);
+        } else {
+            circuit.addGate(gate(fixed[rng() % 6]), target, timestep);
+            circuit.addGate(gate(fixed[rng() % 6]), target, ++timestep);
+        }
+    }
+    return circuit;
+}
+
+// optimize() must leave the unitary unchanged while removing gates
+double checkOptimizer(Rng& rng) {
+    double worst = 0;
+    std::size_t input = 0, output = 0;
+    for (int trial = 0; trial < 200; ++trial) {
+        Circuit circuit = redundantCircuit(2 + trial % 4, 40, rng);
+        const Matrix before = circuit.calculateTotalMatrix();
+        const OptimizationStatistics stats = circuit.optimize();
+        worst = std::max(worst, maxDifference(before, circuit.calculateTotalMatrix()));
+        input += stats.inputGates;
+        output += stats.outputGates;
+    }
+    if (output >= input) {
+        throw std::runtime_error("optimize() removed no gates");
+    }
+    return worst;
+}
+
+// Up to 8 qubits no bond reaches the default limit of 64, so the chain is exact
+double checkMatrixProductState(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 40; ++trial) {
+        const Circuit circuit = randomCircuit(1 + trial % 8, 10, rng);
+        Circuit chain(circuit);
+        chain.setSimulationMode(SimulationMode::MatrixProductState);
+        chain.applyCircuit();
+        worst = std::max(worst, maxDifference(stateVectorResult(circuit), chain.getStateVector()));
+    }
+    return worst;
+}
+
+// The state the StateVector kernels leave with the given thread count, storage layout and
+// fusion width
+Matrix kernelResult(const Circuit& circuit, int threads, StorageLayout layout, int fusion) {
+    Circuit run(circuit);
+    run.setSimulationMode(SimulationMode::StateVector);
+    run.setThreadCount(threads);
+    run.setStorageLayout(layout);
+    run.setGateFusion(fusion);
+    run.applyCircuit();
+    return run.getStateVector();
+}
+
+// Every combination of thread count, layout and fusion width against a reference state. The
+// circuits include controlled rotations on non-adjacent qubits.
+double compareKernels(const Circuit& circuit, const Matrix& reference) {
+    double worst = 0;
+    for (int threads : {1, 2, 4}) {
+        for (StorageLayout layout : {StorageLayout::Interleaved, StorageLayout::Split}) {
+            for (int fusion : {0, 1, 2, 3}) {
+                worst = std::max(worst, maxDifference(reference, kernelResult(circuit, threads, layout, fusion)));
+            }
+        }
+    }
+    return worst;
+}
+
+// Up to 8 qubits the reference is the Dense product of timestep matrices. A dense 16-qubit
+// unitary would take 64 GiB, so there the reference is the serial, unfused interleaved run,
+// itself checked against Dense above; 16 qubits give 2^15 pairs per gate, enough chunks for
+// the threaded kernels to split the work.
+double checkKernels(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 14; ++trial) {
+        const Circuit circuit = randomCircuit(2 + trial % 7, 8, rng);
+        Circuit dense(circuit);
+        dense.setSimulationMode(SimulationMode::Dense);
+        dense.applyCircuit();
+        worst = std::max(worst, compareKernels(circuit, dense.getStateVector()));
+    }
+    for (int trial = 0; trial < 2; ++trial) {
+        const Circuit circuit = randomCircuit(16 + trial, 6, rng);
+        worst = std::max(worst, compareKernels(circuit, kernelResult(circuit, 1, StorageLayout::Interleaved, 0)));
+    }
+    return worst;
+}
+
+// Copies the first `length` timesteps of source into circuit, starting at timestep offset
+void appendTimesteps(Circuit& circuit, const Circuit& source, int offset, int length) {
+    for (const CircuitOp& op : source.getOperations()) {
+        if (op.timestep >= length) {
+            break;
+        }
+        const auto component = QuantumComponentFactory::create(op.gate, source.getParameters(op));
+        if (op.controlCount > 0) {
+            circuit.addControlledGate(component, source.getControls(op), op.target, offset + op.timestep);
+        } else {
+            circuit.addGate(component, op.target, offset + op.timestep);
+        }
+    }
+}
+
+// calculateTotalMatrix raises repeated blocks to their repeat count; the reference multiplies
+// every timestep matrix in turn. The circuits are a random prefix, a block of 1 to 6 timesteps
+// (or one longer than the 64 the search considers) repeated 2 to 5 times, then a tail that
+// starts like the block but does not repeat it.
+double checkBlockPowers(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 16; ++trial) {
+        const bool longBlock = trial == 15;
+        const int n = longBlock ? 2 : 1 + trial % 4;
+        const int period = longBlock ? 70 : 1 + trial % 6;
+        const int count = 2 + trial % 4;
+        const Circuit prefix = randomCircuit(n, 1 + trial % 2, rng);
+        const Circuit block = randomCircuit(n, (period + 1) / 2, rng);
+        const Circuit tail = randomCircuit(n, 2, rng);
+
+        Circuit circuit(n);
+        circuit.setVerbose(false);
+        int timestep = 0;
+        appendTimesteps(circuit, prefix, timestep, prefix.getTimesteps());
+        timestep += prefix.getTimesteps();
+        for (int k = 0; k < count; ++k, timestep += period) {
+            appendTimesteps(circuit, block, timestep, period);
+        }
+        appendTimesteps(circuit, block, timestep, period - 1);
+        timestep += period - 1;
+        appendTimesteps(circuit, tail, timestep, tail.getTimesteps());
+
+        Matrix reference = circuit.calculateTimestepMatrix(0);
+        for (int t = 1; t < circuit.getTimesteps(); ++t) {
+            reference = circuit.calculateTimestepMatrix(t) * reference;
+        }
+        // The second call takes the block powers from the unitary cache
+        worst = std::max(worst, maxDifference(reference, circuit.calculateTotalMatrix()));
+        worst = std::max(worst, maxDifference(reference, circuit.calculateTotalMatrix()));
+        circuit.setUnitaryCacheCapacity(0);
+        worst = std::max(worst, maxDifference(reference, circuit.calculateTotalMatrix()));
+    }
+    return worst;
+}
+
+// Tableau amplitudes are defined only up to a global phase. Automatic mode must pick the
+// tableau for these circuits and give the same state.
+double checkStabilizer(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 60; ++trial) {
+        const Circuit circuit = cliffordCircuit(1 + trial % 10, 12, rng);
+        const Matrix reference = stateVectorResult(circuit);
+        for (SimulationMode mode : {SimulationMode::Stabilizer, SimulationMode::Automatic}) {
+            Circuit tableau(circuit);
+            tableau.setSimulationMode(mode);
+            tableau.applyCircuit();
+            worst = std::max(worst, maxDifferenceUpToPhase(reference, tableau.getStateVector()));
+        }
+    }
+    return worst;
+}
+
+// Without noise the density matrix stays the pure state |psi><psi| of the state vector run
+double checkDensityMatrix(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 20; ++trial) {
+        const Circuit circuit = randomCircuit(1 + trial % 5, 8, rng);
+        const Matrix psi = stateVectorResult(circuit);
+        Circuit mixed(circuit);
+        mixed.setSimulationMode(SimulationMode::DensityMatrix);
+        mixed.applyCircuit();
+        worst = std::max(worst, maxDifference(psi * psi.adjoint(), mixed.getDensityMatrix()));
+    }
+    return worst;
+}
+
+// A Kraus operator on one qubit of the register, I x ... x K x ... x I with qubit q as bit q
+Matrix onQubit(const Matrix& kraus, int qubit, int qubits) {
+    Matrix result = Matrix::identityMatrix(1);
+    for (int q = 0; q < qubits; ++q) {
+        result = Matrix::kroneckerProduct(q == qubit ? kraus : Matrix::identityMatrix(2), result);
+    }
+    return result;
+}
+
+// With gate noise each operation's unitary, built column by column with the state vector
+// kernels, is followed by explicit sums of K rho K^dagger over full 2^n x 2^n matrices
+double checkKrausChannels(Rng& rng) {
+    std::uniform_real_distribution<double> strength(0, 0.3);
+    double worst = 0;
+    for (int trial = 0; trial < 8; ++trial) {
+        const int n = 1 + trial % 4;
+        const int dimension = 1 << n;
+        const Circuit circuit = randomCircuit(n, 4, rng);
+        NoiseModel noise;
+        noise.addGateChannel(NoiseModel::amplitudeDamping(strength(rng)));
+        noise.addGateChannel(NoiseModel::depolarizing(strength(rng)));
+
+        Matrix rho(dimension, dimension);
+        rho(1, 1) = Complex(1, 0);
+        for (const GateOperation& op : circuit.compileCircuit()) {
+            Matrix unitary(dimension, dimension);
+            for (int column = 0; column < dimension; ++column) {
+                Matrix basis(dimension, 1);
+                basis.data()[column] = Complex(1, 0);
+                StateVectorSimulator::applyOperation(basis.data(), n, op);
+                for (int row = 0; row < dimension; ++row) {
+                    unitary.data()[row * dimension + column] = basis.data()[row];
+                }
+            }
+            rho = unitary * rho * unitary.adjoint();
+            for (const std::vector<int>* list : {&op.targets, &op.controls}) {
+                for (int qubit : *list) {
+                    for (const std::vector<Matrix>& channel : noise.getGateChannels()) {
+                        Matrix sum(dimension, dimension);
+                        for (const Matrix& kraus : channel) {
+                            const Matrix full = onQubit(kraus, qubit, n);
+                            sum = sum + full * rho * full.adjoint();
+                        }
+                        rho = sum;
+                    }
+                }
+            }
+        }
+
+        Circuit mixed(circuit);
+        mixed.setSimulationMode(SimulationMode::DensityMatrix);
+        mixed.setNoiseModel(noise);
+        mixed.applyCircuit();
+        worst = std::max(worst, maxDifference(rho, mixed.getDensityMatrix()));
+    }
+    return worst;
+}
+
+// qelib1's u3(theta, phi, lambda), written out rather than taken from the gate library
+Matrix u3Matrix(double theta, double phi, double lambda) {
+    Matrix u(2, 2);
+    u(1, 1) = Complex(std::cos(theta / 2), 0);
+    u(1, 2) = Complex(-std::cos(lambda) * std::sin(theta / 2), -std::sin(lambda) * std::sin(theta / 2));
+    u(2, 1) = Complex(std::cos(phi) * std::sin(theta / 2), std::sin(phi) * std::sin(theta / 2));
+    u(2, 2) = Complex(std::cos(phi + lambda) * std::cos(theta / 2), std::sin(phi + lambda) * std::cos(theta / 2));
+    return u;
+}
+
+Matrix diagonalMatrix(const Complex& first, const Complex& second) {
+    Matrix d(2, 2);
+    d(1, 1) = first;
+    d(2, 2) = second;
+    return d;
+}
+
+// A single-qubit gate on target where control is |1>, as a full 2^n x 2^n matrix
+Matrix controlledOnQubit(const Matrix& gate, int control, int target, int qubits) {
+    const int dimension = 1 << qubits;
+    Matrix result(dimension, dimension);
+    for (int column = 0; column < dimension; ++column) {
+        if (!((column >> control) & 1)) {
+            result.data()[column * dimension + column] = Complex(1, 0);
+            continue;
+        }
+        const int bit = (column >> target) & 1;
+        for (int value = 0; value < 2; ++value) {
+            const int row = (column & ~(1 << target)) | (value << target);
+            result.data()[row * dimension + column] = gate(value + 1, bit + 1);
+        }
+    }
+    return result;
+}
+
+// A QASM program with u2, sdg, cu3, crz, swap, register broadcasts over two registers, a
+// barrier and measurements, against the product of the matrices qelib1 defines for each
+// statement in order. The same circuit and random ones must survive a .qcb round trip.
+double checkCircuitIO(Rng& rng) {
+    std::uniform_real_distribution<double> angle(-3, 3);
+    const double pi = std::acos(-1.0);
+    const Matrix x = u3Matrix(pi, 0, pi), h = u3Matrix(pi / 2, 0, pi);
+    double worst = 0;
+    for (int trial = 0; trial < 8; ++trial) {
+        const double a[] = {angle(rng), angle(rng), angle(rng), angle(rng), angle(rng), angle(rng)};
+        std::ostringstream qasm;
+        qasm << std::setprecision(17) << "OPENQASM 2.0;\ninclude \"qelib1.inc\";\n"
+             << "qreg a[2];\nqreg b[2];\ncreg c[4];\n"
+             << "h a;\n"
+             << "u2(" << a[0] << ", " << a[1] << ") b[0];\n"
+             << "sdg b[1];\n"
+             << "cu3(" << a[2] << ", " << a[3] << ", " << a[4] << ") a[0], b[1];\n"
+             << "crz(" << a[5] << ") b[0], a[1];  // comment\n"
+             << "swap a[1], b[0];\n"
+             << "barrier a, b;\n"
+             << "cx a, b;\n"
+             << "rx(pi/3) a[0];\n"
+             << "measure a[0] -> c[0];\n";
+        std::istringstream in(qasm.str());
+        const Circuit parsed = CircuitIO::readQasm(in);
+
+        // a[0], a[1], b[0], b[1] are qubits 0 to 3
+        const int n = 4;
+        const std::vector<Matrix> steps = {
+            onQubit(h, 0, n), onQubit(h, 1, n),
+            onQubit(u3Matrix(pi / 2, a[0], a[1]), 2, n),
+            onQubit(diagonalMatrix(Complex(1, 0), Complex(0, -1)), 3, n),
+            controlledOnQubit(u3Matrix(a[2], a[3], a[4]), 0, 3, n),
+            controlledOnQubit(diagonalMatrix(Complex(std::cos(a[5] / 2), -std::sin(a[5] / 2)),
+                                             Complex(std::cos(a[5] / 2), std::sin(a[5] / 2))), 2, 1, n),
+            controlledOnQubit(x, 1, 2, n), controlledOnQubit(x, 2, 1, n), controlledOnQubit(x, 1, 2, n),
+            controlledOnQubit(x, 0, 2, n), controlledOnQubit(x, 1, 3, n),
+            onQubit(u3Matrix(pi / 3, -pi / 2, pi / 2), 0, n),
+        };
+        Matrix reference = Matrix::identityMatrix(1 << n);
+        for (const Matrix& step : steps) {
+            reference = step * reference;
+        }
+        worst = std::max(worst, maxDifference(reference, parsed.calculateTotalMatrix()));
+
+        for (const Circuit& circuit : {parsed, randomCircuit(1 + trial % 6, 6, rng)}) {
+            std::stringstream binary;
+            CircuitIO::writeBinary(circuit, binary);
+            const Circuit copy = CircuitIO::readBinary(binary);
+            if (copy.getQubits() != circuit.getQubits() || copy.getTimesteps() != circuit.getTimesteps() ||
+                copy.getOperations().size() != circuit.getOperations().size()) {
+                throw std::runtime_error("The .qcb round trip changed the circuit's shape");
+            }
+            for (std::size_t k = 0; k < circuit.getOperations().size(); ++k) {
+                const CircuitOp& before = circuit.getOperations()[k];
+                const CircuitOp& after = copy.getOperations()[k];
+                if (before.gate != after.gate || before.timestep != after.timestep || before.target != after.target ||
+                    circuit.getControls(before) != copy.getControls(after) ||
+                    circuit.getParameters(before) != copy.getParameters(after)) {
+                    throw std::runtime_error("The .qcb round trip changed operation " + std::to_string(k));
+                }
+            }
+            worst = std::max(worst, maxDifference(circuit.calculateTotalMatrix(), copy.calculateTotalMatrix()));
+        }
+    }
+    return worst;
+}
+
+double maxDifference(const Matrix& reference, const OutOfCoreStateVector& storage) {
+    double worst = 0;
+    for (int i = 0; i < reference.getRows(); ++i) {
+        worst = std::max(worst, double((reference.data()[i] - storage.amplitude(i)).modulus()));
+    }
+    return worst;
+}
+
+// With 3 block qubits out of 10, most gates and controls sit on high qubits, so nearly every
+// gate needs a block swap. Runs alternate between restoring the qubit order at the end and
+// leaving it permuted; amplitude() must read the logical state either way, and so must the
+// file once restoreQubitOrder has swapped the qubits back.
+double checkOutOfCore(Rng& rng) {
+    const std::string path = (std::filesystem::temp_directory_path() / "out_of_core_check.bin").string();
+    std::uniform_real_distribution<double> angle(-3, 3);
+    ThreadPool pool(2);
+    double worst = 0;
+    for (int trial = 0; trial < 8; ++trial) {
+        const int n = 10;
+        Circuit circuit = randomCircuit(n, 8, rng);
+        const int last = circuit.getTimesteps();
+        circuit.addControlledGate(gate("Ry", {angle(rng)}), {n - 1, n - 2}, 0, last);
+        circuit.addControlledGate(gate("Pauli-X", {}), {1}, n - 1, last + 1);
+        const Matrix reference = stateVectorResult(circuit);
+
+        const bool restoreOrder = trial % 2 == 0;
+        {
+            OutOfCoreStateVector storage(path, n, 3);
+            const OutOfCoreStatistics stats = storage.run(circuit.compileCircuit(), trial % 4 < 2 ? nullptr : &pool, restoreOrder);
+            if (stats.swaps == 0) {
+                throw std::runtime_error("No block swaps were needed");
+            }
+            worst = std::max(worst, maxDifference(reference, storage));
+            if (!restoreOrder) {
+                storage.restoreQubitOrder(&pool);
+                worst = std::max(worst, maxDifference(reference, storage));
+            }
+        }
+        {
+            // Fused operations through Circuit, which restores the order
+            Circuit fused(circuit);
+            fused.setGateFusion(1 + trial % 3);
+            OutOfCoreStateVector storage(path, n, 3);
+            fused.applyCircuit(storage);
+            worst = std::max(worst, maxDifference(reference, storage));
+        }
+    }
+    std::filesystem::remove(path);
+    return worst;
+}
+
+// Fails the check unless body throws
+void expectThrow(const std::function<void()>& body, const std::string& what) {
+    try {
+        body();
+    } catch (const std::exception&) {
+        return;
+    }
+    throw std::runtime_error(what + " did not throw");
+}
+
+// One state is authoritative across mode switches: a DensityMatrix run continues from the pure
+// state of earlier runs in any mode, and after it only rho can be read until
+// initializeStateVector starts a new pure state
+double checkModeSwitching(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 12; ++trial) {
+        const Circuit circuit = randomCircuit(1 + trial % 4, 4, rng);
+        Circuit twice(circuit);
+        twice.applyCircuit();
+        twice.applyCircuit();
+        const Matrix psi = twice.getStateVector();
+
+        Circuit circuit2(circuit);
+        const SimulationMode first[] = {SimulationMode::StateVector, SimulationMode::MatrixProductState,
+                                        SimulationMode::Dense};
+        circuit2.setSimulationMode(first[trial % 3]);
+        circuit2.applyCircuit();
+        const Matrix once = circuit2.getStateVector();
+        worst = std::max(worst, maxDifference(once * once.adjoint(), circuit2.getDensityMatrix()));
+        circuit2.setSimulationMode(SimulationMode::DensityMatrix);
+        circuit2.applyCircuit();
+        worst = std::max(worst, maxDifference(psi * psi.adjoint(), circuit2.getDensityMatrix()));
+
+        expectThrow([&] { circuit2.getStateVector(); }, "getStateVector after a DensityMatrix run");
+        circuit2.setSimulationMode(SimulationMode::StateVector);
+        expectThrow([&] { circuit2.applyCircuit(); }, "a StateVector run after a DensityMatrix run");
+
+        std::vector<Complex> input(once.data(), once.data() + once.getRows());
+        circuit2.initializeStateVector(input);
+        circuit2.applyCircuit();
+        worst = std::max(worst, maxDifference(psi, circuit2.getStateVector()));
+    }
+    return worst;
+}
+
+// A few Pauli strings with random factors on every qubit and random real weights
+PauliObservable randomObservable(int qubits, Rng& rng) {
+    std::uniform_real_distribution<double> weight(-1, 1);
+    PauliObservable observable;
+    for (int term = 0; term < 4; ++term) {
+        PauliTerm pauli{weight(rng), 0, 0};
+        for (int q = 0; q < qubits; ++q) {
+            const unsigned factor = rng() % 4;  // I, X, Y, Z
+            if (factor == 1 || factor == 2) {
+                pauli.xMask |= std::uint64_t(1) << q;
+            }
+            if (factor == 2 || factor == 3) {
+                pauli.zMask |= std::uint64_t(1) << q;
+            }
+        }
+        observable.addTerm(pauli);
+    }
+    return observable;
+}
+
+// Layers of uncontrolled rotations separated by fixed controlled gates, the circuits
+// parameterShiftGradient accepts
+Circuit rotationCircuit(int qubits, int depth, Rng& rng) {
+    const char* rotations[] = {"Rx", "Ry", "Rz", "Phase"};
+    std::uniform_real_distribution<double> angle(-3, 3);
+    Circuit circuit(qubits);
+    circuit.setVerbose(false);
+    for (int layer = 0; layer < depth; ++layer) {
+        for (int q = 0; q < qubits; ++q) {
+            if (rng() % 5 == 0) {
+                circuit.addGate(gate("U3", {angle(rng), angle(rng), angle(rng)}), q, 2 * layer);
+            } else {
+                circuit.addGate(gate(rotations[rng() % 4], {angle(rng)}), q, 2 * layer);
+            }
+        }
+        if (qubits > 1) {
+            const int control = rng() % qubits, target = (control + 1 + rng() % (qubits - 1)) % qubits;
+            circuit.addControlledGate(gate(rng() % 2 ? "Pauli-X" : "Pauli-Z"), {control}, target, 2 * layer + 1);
+        }
+    }
+    return circuit;
+}
+
+double maxDifference(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size()) {
+        throw std::runtime_error("Gradients have different lengths");
+    }
+    double worst = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        worst = std::max(worst, std::abs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+// The adjoint gradient through both observable overloads against the parameter-shift rule, and
+// the Pauli-string expectation against the dense matrix it stands for
+double checkParameterShift(Rng& rng) {
+    double worst = 0;
+    for (int trial = 0; trial < 10; ++trial) {
+        const int n = 1 + trial % 5;
+        Circuit circuit = rotationCircuit(n, 3, rng);
+        const PauliObservable observable = randomObservable(n, rng);
+        const Matrix dense = observable.toMatrix(n);
+        const std::vector<double> reference = circuit.parameterShiftGradient(dense);
+        worst = std::max(worst, maxDifference(reference, circuit.gradient(dense)));
+        worst = std::max(worst, maxDifference(reference, circuit.gradient(observable)));
+
+        circuit.applyCircuit();
+        worst = std::max(worst, std::abs(circuit.expectation(dense) - circuit.expectation(observable)));
+    }
+    return worst;
+}
+
+// Parameter shift does not hold for controlled rotations, so there the adjoint gradient is
+// compared with central differences of the expectation; their truncation error is O(h^2)
+double checkFiniteDifferences(Rng& rng) {
+    const double h = 1e-5;
+    double worst = 0;
+    for (int trial = 0; trial < 8; ++trial) {
+        const int n = 2 + trial % 4;
+        const Circuit circuit = randomCircuit(n, 4, rng);
+        const PauliObservable observable = randomObservable(n, rng);
+        const Matrix dense = observable.toMatrix(n);
+        const std::vector<double> values = circuit.getParameters();
+        std::vector<double> reference(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            double sides[2];
+            for (int side = 0; side < 2; ++side) {
+                std::vector<double> moved = values;
+                moved[i] += side == 0 ? h : -h;
+                Circuit shifted(circuit);
+                shifted.setParameters(moved);
+                shifted.applyCircuit();
+                sides[side] = shifted.expectation(observable);
+            }
+            reference[i] = (sides[0] - sides[1]) / (2 * h);
+        }
+        worst = std::max(worst, maxDifference(reference, circuit.gradient(dense)));
+        worst = std::max(worst, maxDifference(reference, circuit.gradient(observable)));
+    }
+    return worst;
+}
+
+// Gates on the top qubits need amplitudes held by other processes, so these exercise the
+// exchanges over both transports. At 20 qubits each swap streams in several chunks.
+double checkDistributed(Rng& rng) {
+    double worst = 0;
+    for (TransportKind transport : {TransportKind::SharedMemory, TransportKind::Tcp}) {
+        for (int processes : {2, 4}) {
+            const Circuit circuit = randomCircuit(6 + rng() % 3, 10, rng);
+            Circuit split(circuit);
+            split.applyCircuitDistributed(processes, transport);
+            worst = std::max(worst, maxDifference(stateVectorResult(circuit), split.getStateVector()));
+        }
+        const Circuit circuit = randomCircuit(20, 2, rng);
+        Circuit split(circuit);
+        split.applyCircuitDistributed(2, transport);
+        worst = std::max(worst, maxDifference(stateVectorResult(circuit), split.getStateVector()));
+    }
+    return worst;
+}
+
+// The circuit applied to |0...0> without checkpoints, fusion or any earlier state
+Matrix freshResult(const Circuit& circuit) {
+    Circuit reference(circuit);
+    reference.setCheckpointInterval(0);
+    std::vector<Complex> zero(std::size_t(1) << circuit.getQubits(), Complex(0, 0));
+    zero[0] = Complex(1, 0);
+    reference.initializeStateVector(zero);
+    return stateVectorResult(reference);
+}
+
+void expectResume(const Circuit& circuit, int resumedFrom, int timestepsRun, const std::string& after) {
+    const CheckpointStatistics& stats = circuit.getCheckpointStatistics();
+    if (stats.resumedFrom != resumedFrom || stats.timestepsRun != timestepsRun) {
+        throw std::runtime_error("After " + after + " the run resumed from timestep " + std::to_string(stats.resumedFrom) +
+                                 " and ran " + std::to_string(stats.timestepsRun) + " timesteps, expected " +
+                                 std::to_string(resumedFrom) + " and " + std::to_string(timestepsRun));
+    }
+}
+
+// Timestep holding each entry of getParameters()
+std::vector<int> parameterTimesteps(const Circuit& circuit) {
+    std::vector<int> timesteps;
+    for (const CircuitOp& op : circuit.getOperations()) {
+        timesteps.insert(timesteps.end(), op.parameterCount, op.timestep);
+    }
+    return timesteps;
+}
+
+// Each incremental run must match a fresh run of the edited circuit and restart at the last
+// checkpoint at or before the first changed timestep: gate edits mid-circuit, appended timesteps
+// and a sweep over single angles with setParameters
+double checkCheckpoints(Rng& rng) {
+    std::uniform_real_distribution<double> angle(-3, 3);
+    double worst = 0;
+    for (int trial = 0; trial < 12; ++trial) {
+        const int interval = 1 + trial % 3;
+        Circuit circuit = randomCircuit(3 + trial % 4, 8, rng);
+        circuit.setCheckpointInterval(interval);
+        int timesteps = circuit.getTimesteps();
+        circuit.applyCircuit();
+        expectResume(circuit, 0, timesteps, "the first run");
+        worst = std::max(worst, maxDifference(freshResult(circuit), circuit.getStateVector()));
+
+        circuit.applyCircuit();
+        expectResume(circuit, timesteps, 0, "a run without changes");
+        worst = std::max(worst, maxDifference(freshResult(circuit), circuit.getStateVector()));
+
+        for (int edit = 0; edit < 3; ++edit) {
+            const int timestep = 2 * int(rng() % (timesteps / 2));
+            circuit.addGate(gate("Ry", {angle(rng)}), rng() % circuit.getQubits(), timestep);
+            circuit.applyCircuit();
+            expectResume(circuit, timestep / interval * interval, timesteps - timestep / interval * interval,
+                         "editing timestep " + std::to_string(timestep));
+            worst = std::max(worst, maxDifference(freshResult(circuit), circuit.getStateVector()));
+        }
+
+        for (int q = 0; q < circuit.getQubits(); ++q) {
+            circuit.addGate(gate("U3", {angle(rng), angle(rng), angle(rng)}), q, timesteps);
+        }
+        circuit.addControlledGate(gate("Rz", {angle(rng)}), {0}, circuit.getQubits() - 1, timesteps + 1);
+        circuit.applyCircuit();
+        expectResume(circuit, timesteps, 2, "appending two timesteps");
+        worst = std::max(worst, maxDifference(freshResult(circuit), circuit.getStateVector()));
+        timesteps += 2;
+
+        std::vector<double> parameters = circuit.getParameters();
+        const std::vector<int> owners = parameterTimesteps(circuit);
+        for (std::size_t k = 0; k < parameters.size(); k += 1 + rng() % 3) {
+            parameters[k] += 0.25;
+            circuit.setParameters(parameters);
+            circuit.applyCircuit();
+            const int resume = owners[k] / interval * interval;
+            expectResume(circuit, resume, timesteps - resume, "changing angle " + std::to_string(k));
+            worst = std::max(worst, maxDifference(freshResult(circuit), circuit.getStateVector()));
+        }
+    }
+    return worst;
+}
+
+void printUsage() {
+    std::cout << "Usage: check [--seed N]\n";
+}
+}
+
+int main(int argc, char* argv[]) {
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            seed = unsigned(std::stoul(argv[++i]));
+        } else {
+            printUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    const std::vector<Check> checks = {
+        {"kernels vs dense", 1e-10, checkKernels},
+        {"optimizer vs total matrix", 1e-10, checkOptimizer},
+        {"block powers vs timestep product", 1e-10, checkBlockPowers},
+        {"matrix product state vs state vector", 1e-10, checkMatrixProductState},
+        {"stabilizer vs state vector", 1e-10, checkStabilizer},
+        {"density matrix vs state vector", 1e-10, checkDensityMatrix},
+        {"Kraus channels vs explicit sum", 1e-10, checkKrausChannels},
+        {"mode switches keep one state", 1e-10, checkModeSwitching},
+        {"adjoint gradient vs parameter shift", 1e-10, checkParameterShift},
+        {"adjoint gradient vs finite differences", 1e-7, checkFiniteDifferences},
+        {"distributed vs state vector", 1e-10, checkDistributed},
+        {"out-of-core vs state vector", 1e-10, checkOutOfCore},
+        {"checkpointed runs vs fresh runs", 1e-10, checkCheckpoints},
+        {"QASM and .qcb vs explicit matrices", 1e-10, checkCircuitIO},
+    };
+
+    int failures = 0;
+    for (const Check& check : checks) {
+        Rng rng(seed);
+        try {
+            const double error = check.run(rng);
+            const bool passed = error <= check.tolerance;
+            failures += !passed;
+            std::cout << (passed ? "PASS  " : "FAIL  ") << std::left << std::setw(40) << check.name
+                      << " max error " << error << " (tolerance " << check.tolerance << ")\n";
+        } catch (const std::exception& e) {
+            ++failures;
+            std::cout << "FAIL  " << std::left << std::setw(40) << check.name << " " << e.what() << '\n';
+        }
+    }
+    std::cout << checks.size() - failures << " of " << checks.size() << " checks passed\n";
+    return failures > 0 ? 1 : 0;
+}
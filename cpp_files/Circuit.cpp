@@ -1,67 +1,221 @@
 #include "../h_files/Circuit.h"
 
+#include <mutex>
+#include <random>
+#include <unordered_map>
 
-Circuit::Circuit(int num_qubits) : qubits(num_qubits), stateVector(1 << num_qubits, 1) {        
+namespace {
+// Longest timestep block calculateTotalMatrix looks for repeats of; with it the search costs
+// O(timesteps * maxBlockPeriod) id comparisons per block rather than O(timesteps^2)
+const int maxBlockPeriod = 64;
+
+template <typename T>
+void appendBytes(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Full 2^n x 2^n matrix of a controlled single-qubit gate, for the dense reference path
+Matrix controlledMatrix(const Matrix& gate, int target, const std::vector<int>& controls, int qubits) {
+    const int dimension = 1 << qubits;
+    const int targetBit = 1 << target;
+    int controlMask = 0;
+    for (int control : controls) {
+        controlMask |= 1 << control;
+    }
+
+    Matrix result(dimension, dimension);
+    for (int col = 0; col < dimension; ++col) {
+        if ((col & controlMask) != controlMask) {
+            result(col + 1, col + 1) = Complex(1, 0);
+            continue;
+        }
+        const int colBit = (col & targetBit) ? 1 : 0;
+        const int base = col & ~targetBit;
+        result(base + 1, col + 1) = gate(1, colBit + 1);
+        result((base | targetBit) + 1, col + 1) = gate(2, colBit + 1);
+    }
+    return result;
+}
+
+// Re <a|b> over two state vectors
+double realInnerProduct(const Matrix& a, const Matrix& b) {
+    const Complex* x = a.data();
+    const Complex* y = b.data();
+    double sum = 0;
+    for (int i = 0; i < a.getRows(); ++i) {
+        sum += x[i].get_real() * y[i].get_real() + x[i].get_imag() * y[i].get_imag();
+    }
+    return sum;
+}
+
+// SplitMix64 finaliser, gives each trajectory an independent seed
+std::uint64_t trajectorySeed(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+Matrix applyObservable(const Matrix& observable, const Matrix& psi, ThreadPool* pool) {
+    if (observable.getRows() != psi.getRows() || observable.getCols() != psi.getRows()) {
+        throw std::invalid_argument("Observable must be 2^qubits x 2^qubits");
+    }
+    return Matrix::multiply(observable, psi, pool);
+}
+
+// Mixed precision rescales the fp32 state this often, before rounding drift in the norm builds up
+const std::size_t renormalizeInterval = 64;
+
+// Rescales to unit norm, with the sum of squares accumulated in double
+void normalizeInDouble(ComplexF* amplitudes, std::size_t size) {
+    double sum = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        const double re = amplitudes[i].get_real(), im = amplitudes[i].get_imag();
+        sum += re * re + im * im;
+    }
+    if (sum == 0) {
+        return;
+    }
+    const float scale = float(1 / std::sqrt(sum));
+    for (std::size_t i = 0; i < size; ++i) {
+        amplitudes[i] = ComplexF(amplitudes[i].get_real() * scale, amplitudes[i].get_imag() * scale);
+    }
+}
+}
+
+
+std::ostream& operator<<(std::ostream& os, const CheckpointStatistics& stats) {
+    os << "Checkpoints: " << stats.checkpoints << " states (" << stats.bytes / 1048576.0 << " MiB) every "
+       << stats.interval << " timesteps, resumed at timestep " << stats.resumedFrom << ", " << stats.timestepsRun
+       << " timesteps run";
+    return os;
+}
+
+Circuit::Circuit(int num_qubits)
+: qubits(num_qubits), timesteps(1), mode(SimulationMode::StateVector), layout(StorageLayout::Interleaved), precision(Precision::Double),
+  fidelityCheck(false), fidelity(std::numeric_limits<double>::quiet_NaN()), fusionQubits(1), verbose(true),
+  stabilizerActive(false), mpsActive(false), maxBondDimension(64), truncationCutoff(1e-12), checkpointInterval(0), checkpointBudget(std::size_t(1) << 30) {
     if (num_qubits < 1) {
         throw std::invalid_argument("Number of qubits must be a positive integer");
-    }        
-    auto identity_gate = std::make_shared<Identity>();
+    }
+    unitaryCache = std::make_shared<UnitaryCache>();
+}
 
-    for (int timestep = 0; timestep < 1; ++timestep) {
-        std::vector<std::shared_ptr<QuantumComponent>> timestep_gates;
+void Circuit::requirePureState() const {
+    if (densityState.getRows() != 0) {
+        throw std::runtime_error("The state is a density matrix after a DensityMatrix run; call initializeStateVector to start a pure state");
+    }
+}
 
-        for (int qubit = 0; qubit < num_qubits; ++qubit) {
-            timestep_gates.push_back(identity_gate);
+Matrix& Circuit::state() const {
+    requirePureState();
+    if (stabilizerActive) {
+        // Amplitudes of a stabilizer state are only defined up to a global phase
+        stateVector = tableau.toStateVector();
+        tableau = StabilizerTableau();
+        stabilizerActive = false;
+    }
+    if (mpsActive) {
+        stateVector = mps.toStateVector();
+        mps = MatrixProductState();
+        mpsActive = false;
+    }
+    if (stateVector.getRows() == 0 && splitStateVector.size() != 0) {
+        stateVector = Matrix(int(splitStateVector.size()), 1);
+        splitStateVector.copyTo(stateVector.data());
+        splitStateVector = SplitComplexArray();
+    }
+    if (stateVector.getRows() == 0 && singleStateVector.getRows() != 0) {
+        stateVector = Matrix(singleStateVector);
+        singleStateVector = MatrixF();
+    }
+    if (stateVector.getRows() == 0) {
+        if (qubits > 30) {
+            throw std::length_error("State vector for " + std::to_string(qubits) + " qubits does not fit in a Matrix");
         }
+        stateVector = Matrix(1 << qubits, 1);
+        stateVector(1, 1) = Complex(1, 0);
+    }
+    return stateVector;
+}
 
-        Qcircuit.push_back(timestep_gates);
+MatrixF& Circuit::singleState() const {
+    if (singleStateVector.getRows() == 0) {
+        singleStateVector = MatrixF(state());
+        stateVector = Matrix();
     }
-    stateVector(1,1) = Complex(1, 0);
+    return singleStateVector;
 }
 
-// Copy constructor
-Circuit::Circuit(const Circuit& other)
-: qubits(other.qubits), stateVector(other.stateVector),
-  componentLibrary(other.componentLibrary) {
-    for (const auto& timestep : other.Qcircuit) {
-        std::vector<std::shared_ptr<QuantumComponent>> newTimestep;
-        for (const auto& component : timestep) {
-            newTimestep.push_back(component->clone());
-        }
-        Qcircuit.push_back(newTimestep);
+SplitComplexArray& Circuit::splitState() const {
+    if (splitStateVector.size() == 0) {
+        const Matrix& amplitudes = state();
+        splitStateVector = SplitComplexArray(amplitudes.data(), amplitudes.getRows());
+        stateVector = Matrix();
     }
+    return splitStateVector;
 }
 
-// Copy assignment operator
-Circuit& Circuit::operator=(const Circuit& other) {
-    if (this != &other) {
-        qubits = other.qubits;
-        stateVector = other.stateVector;
-        componentLibrary = other.componentLibrary; 
-        Qcircuit.clear();
-        for (const auto& timestep : other.Qcircuit) {
-            std::vector<std::shared_ptr<QuantumComponent>> newTimestep;
-            for (const auto& component : timestep) {
-                newTimestep.push_back(component->clone());
-            }
-            Qcircuit.push_back(newTimestep);
-        }
+Matrix Circuit::stateSnapshot() const {
+    if (splitStateVector.size() != 0) {
+        Matrix snapshot(int(splitStateVector.size()), 1);
+        splitStateVector.copyTo(snapshot.data());
+        return snapshot;
+    }
+    return state();
+}
+
+void Circuit::restoreState(const Matrix& amplitudes) {
+    if (layout == StorageLayout::Split) {
+        splitState() = SplitComplexArray(amplitudes.data(), amplitudes.getRows());
+    } else {
+        state() = amplitudes;
     }
-    return *this;
 }
 
+Matrix& Circuit::density() const {
+    if (densityState.getRows() == 0) {
+        Matrix rho = DensityMatrixSimulator::fromState(state().data(), qubits);
+        stateVector = Matrix();
+        singleStateVector = MatrixF();
+        splitStateVector = SplitComplexArray();
+        densityState = std::move(rho);
+    }
+    return densityState;
+}
 
+std::vector<double> Circuit::outcomeProbabilities() const {
+    std::vector<double> probabilities;
+    if (densityState.getRows() != 0) {
+        probabilities = DensityMatrixSimulator::probabilities(densityState.data(), qubits);
+    } else {
+        const Complex* amplitudes = state().data();
+        probabilities.resize(std::size_t(1) << qubits);
+        for (std::size_t i = 0; i < probabilities.size(); ++i) {
+            probabilities[i] = amplitudes[i].get_real() * amplitudes[i].get_real() +
+                               amplitudes[i].get_imag() * amplitudes[i].get_imag();
+        }
+    }
+    noise.applyReadoutError(probabilities, qubits);
+    return probabilities;
+}
 
 void Circuit::initializeStateVector(const std::vector<Complex>& initialValues) {
-    if (initialValues.size() != stateVector.getRows()) {
+    if (qubits > 30 || initialValues.size() != (std::size_t(1) << qubits)) {
         throw std::invalid_argument("Invalid initial state vector size");
     }
 
-    for (int i = 1; i <= initialValues.size(); i++) {
-        stateVector(i, 1) = initialValues[i - 1];
+    densityState = Matrix();
+    Matrix& amplitudes = state();
+    sampler.reset();
+    clearCheckpoints();
+    for (int i = 1; i <= int(initialValues.size()); i++) {
+        amplitudes(i, 1) = initialValues[i - 1];
     }
 
-    std::cout << "Initialized state vector"<< stateVector<<"\n";
+    if (verbose) {
+        std::cout << "Initialized state vector"<< amplitudes<<"\n";
+    }
 }
 
 void Circuit::addGate(std::shared_ptr<QuantumComponent> gate, int qubit, int timestep) {
@@ -74,13 +228,199 @@ void Circuit::addGate(std::shared_ptr<QuantumComponent> gate, int qubit, int tim
     }
 
     // Check if we need to add more timesteps
-    while (Qcircuit.size() <= timestep) {
-        std::vector<std::shared_ptr<QuantumComponent>> new_timestep(qubits, std::make_shared<Identity>());
-        Qcircuit.push_back(new_timestep);
+    timesteps = std::max(timesteps, timestep + 1);
+
+    // Replace the gate at the specified qubit and timestep; an Identity just clears the cell
+    clearQubits(timestep, {qubit});
+    if (gate->getId() != GateId::Identity) {
+        const std::vector<double> angles = gate->getParameters();
+        insertOp(CircuitOp{gate->getId(), timestep, qubit, 0, 0,
+                           std::uint32_t(parameterValues.size()), std::uint32_t(angles.size())});
+        parameterValues.insert(parameterValues.end(), angles.begin(), angles.end());
+    }
+}
+
+void Circuit::addControlledGate(std::shared_ptr<QuantumComponent> gate, const std::vector<int>& controls, int target, int timestep) {
+    if (timestep < 0) {
+        throw std::invalid_argument("Timestep cannot be negative");
+    }
+    if (gate->getMatrixRef().getRows() != 2) {
+        throw std::invalid_argument("Controlled gates must act on a single target qubit");
+    }
+    if (controls.empty()) {
+        throw std::invalid_argument("Controlled gate needs at least one control qubit");
+    }
+
+    std::vector<int> cells(controls);
+    cells.push_back(target);
+    std::vector<int> sorted(cells);
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.front() < 0 || sorted.back() >= qubits) {
+        throw std::invalid_argument("Qubit out of range");
     }
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        throw std::invalid_argument("Control and target qubits must be distinct");
+    }
+
+    timesteps = std::max(timesteps, timestep + 1);
+    clearQubits(timestep, cells);
+
+    const std::vector<double> angles = gate->getParameters();
+    CircuitOp op{gate->getId(), timestep, target, std::uint32_t(controlQubits.size()), std::uint32_t(controls.size()),
+                 std::uint32_t(parameterValues.size()), std::uint32_t(angles.size())};
+    controlQubits.insert(controlQubits.end(), controls.begin(), controls.end());
+    parameterValues.insert(parameterValues.end(), angles.begin(), angles.end());
+    insertOp(op);
+}
 
-    // Replace the gate at the specified qubit and timestep
-    Qcircuit[timestep][qubit] = gate;
+std::vector<CircuitOp>::iterator Circuit::timestepBegin(int timestep) {
+    return std::lower_bound(Qcircuit.begin(), Qcircuit.end(), timestep,
+                            [](const CircuitOp& op, int t) { return op.timestep < t; });
+}
+
+std::vector<CircuitOp>::const_iterator Circuit::timestepBegin(int timestep) const {
+    return std::lower_bound(Qcircuit.begin(), Qcircuit.end(), timestep,
+                            [](const CircuitOp& op, int t) { return op.timestep < t; });
+}
+
+void Circuit::clearQubits(int timestep, const std::vector<int>& cells) {
+    auto touches = [&](const CircuitOp& op) {
+        if (op.timestep != timestep) {
+            return false;
+        }
+        for (int cell : cells) {
+            if (op.target == cell) {
+                return true;
+            }
+            for (std::uint32_t c = 0; c < op.controlCount; ++c) {
+                if (controlQubits[op.firstControl + c] == cell) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    auto first = timestepBegin(timestep);
+    auto last = first;
+    while (last != Qcircuit.end() && last->timestep == timestep) {
+        ++last;
+    }
+    const bool freesSlots = std::any_of(first, last, [&](const CircuitOp& op) {
+        return (op.controlCount > 0 || op.parameterCount > 0) && touches(op);
+    });
+    Qcircuit.erase(std::remove_if(first, last, touches), last);
+
+    // Rewrite the side arrays without the replaced ops' slots, so repeated edits do not grow them
+    if (freesSlots) {
+        std::vector<int> controls;
+        std::vector<double> parameters;
+        for (CircuitOp& op : Qcircuit) {
+            const std::uint32_t firstControl = controls.size(), firstParameter = parameters.size();
+            controls.insert(controls.end(), controlQubits.begin() + op.firstControl,
+                            controlQubits.begin() + op.firstControl + op.controlCount);
+            parameters.insert(parameters.end(), parameterValues.begin() + op.firstParameter,
+                              parameterValues.begin() + op.firstParameter + op.parameterCount);
+            op.firstControl = firstControl;
+            op.firstParameter = firstParameter;
+        }
+        controlQubits.swap(controls);
+        parameterValues.swap(parameters);
+    }
+}
+
+void Circuit::insertOp(const CircuitOp& op) {
+    auto before = [](const CircuitOp& a, const CircuitOp& b) {
+        return a.timestep != b.timestep ? a.timestep < b.timestep : a.target < b.target;
+    };
+
+    // Gates usually arrive in order, so appending is the common case
+    if (Qcircuit.empty() || before(Qcircuit.back(), op)) {
+        Qcircuit.push_back(op);
+    } else {
+        Qcircuit.insert(std::lower_bound(Qcircuit.begin(), Qcircuit.end(), op, before), op);
+    }
+}
+
+std::vector<const CircuitOp*> Circuit::timestepOps(int timestep) const {
+    std::vector<const CircuitOp*> ops(qubits, nullptr);
+    for (auto it = timestepBegin(timestep); it != Qcircuit.end() && it->timestep == timestep; ++it) {
+        if (it->controlCount == 0) {
+            ops[it->target] = &*it;
+        }
+    }
+    return ops;
+}
+
+std::shared_ptr<QuantumComponent> Circuit::componentFor(const CircuitOp& op) const {
+    if (op.parameterCount == 0) {
+        return QuantumComponentFactory::create(op.gate);
+    }
+    return QuantumComponentFactory::create(op.gate, getParameters(op));
+}
+
+std::vector<int> Circuit::getControls(const CircuitOp& op) const {
+    return std::vector<int>(controlQubits.begin() + op.firstControl,
+                            controlQubits.begin() + op.firstControl + op.controlCount);
+}
+
+std::vector<double> Circuit::getParameters(const CircuitOp& op) const {
+    return std::vector<double>(parameterValues.begin() + op.firstParameter,
+                               parameterValues.begin() + op.firstParameter + op.parameterCount);
+}
+
+std::vector<double> Circuit::getParameters() const {
+    std::vector<double> values;
+    for (const CircuitOp& op : Qcircuit) {
+        values.insert(values.end(), parameterValues.begin() + op.firstParameter,
+                      parameterValues.begin() + op.firstParameter + op.parameterCount);
+    }
+    return values;
+}
+
+void Circuit::setParameters(const std::vector<double>& values) {
+    std::size_t next = 0;
+    for (const CircuitOp& op : Qcircuit) {
+        for (std::uint32_t p = 0; p < op.parameterCount; ++p) {
+            if (next >= values.size()) {
+                throw std::invalid_argument("Too few parameter values");
+            }
+            parameterValues[op.firstParameter + p] = values[next++];
+        }
+    }
+    if (next != values.size()) {
+        throw std::invalid_argument("Too many parameter values");
+    }
+}
+
+int Circuit::getQubits() const {
+    return qubits;
+}
+
+int Circuit::getTimesteps() const {
+    return timesteps;
+}
+
+const std::vector<CircuitOp>& Circuit::getOperations() const {
+    return Qcircuit;
+}
+
+std::vector<std::vector<std::shared_ptr<QuantumComponent>>> Circuit::getGrid(
+    std::vector<std::vector<int>>* controlTargets) const {
+    std::vector<std::vector<std::shared_ptr<QuantumComponent>>> grid(
+        timesteps, std::vector<std::shared_ptr<QuantumComponent>>(qubits, QuantumComponentFactory::create(GateId::Identity)));
+    if (controlTargets) {
+        controlTargets->assign(timesteps, std::vector<int>(qubits, -1));
+    }
+    for (const CircuitOp& op : Qcircuit) {
+        grid[op.timestep][op.target] = componentFor(op);
+        if (controlTargets) {
+            for (std::uint32_t c = 0; c < op.controlCount; ++c) {
+                (*controlTargets)[op.timestep][controlQubits[op.firstControl + c]] = op.target;
+            }
+        }
+    }
+    return grid;
 }
 
 void Circuit::addComponentToLibrary(const std::string& name) {
@@ -93,45 +433,852 @@ void Circuit::addComponentToLibrary(const std::string& name) {
 }
 
 
+std::string Circuit::layerKey(int timestep) const {
+    std::string key;
+    appendBytes(key, qubits);
+    for (auto it = timestepBegin(timestep); it != Qcircuit.end() && it->timestep == timestep; ++it) {
+        appendBytes(key, it->gate);
+        appendBytes(key, it->target);
+        appendBytes(key, it->controlCount);
+        for (std::uint32_t c = 0; c < it->controlCount; ++c) {
+            appendBytes(key, controlQubits[it->firstControl + c]);
+        }
+        appendBytes(key, it->parameterCount);
+        for (std::uint32_t p = 0; p < it->parameterCount; ++p) {
+            appendBytes(key, parameterValues[it->firstParameter + p]);
+        }
+    }
+    return key;
+}
+
+std::shared_ptr<const Matrix> Circuit::timestepMatrix(int timestep, const std::string& key) const {
+    std::shared_ptr<const Matrix> matrix = unitaryCache ? unitaryCache->find(key) : nullptr;
+    if (!matrix) {
+        matrix = std::make_shared<const Matrix>(buildTimestepMatrix(timestep));
+        if (unitaryCache) {
+            unitaryCache->insert(key, matrix);
+        }
+    }
+    return matrix;
+}
+
+std::shared_ptr<const Matrix> Circuit::blockPower(const std::vector<std::string>& keys, int first, int period, int count) const {
+    // Length prefixes keep the concatenated layer keys unambiguous
+    std::string blockKey = "block";
+    for (int t = first; t < first + period; ++t) {
+        appendBytes(blockKey, keys[t].size());
+        blockKey += keys[t];
+    }
+    std::string powerKey = blockKey;
+    appendBytes(powerKey, count);
+    if (std::shared_ptr<const Matrix> cached = unitaryCache ? unitaryCache->find(powerKey) : nullptr) {
+        return cached;
+    }
+
+    std::shared_ptr<const Matrix> block = period == 1 ? timestepMatrix(first, keys[first]) : nullptr;
+    if (!block && unitaryCache) {
+        block = unitaryCache->find(blockKey);
+    }
+    if (!block) {
+        Matrix product = *timestepMatrix(first, keys[first]);
+        for (int t = first + 1; t < first + period; ++t) {
+            product = Matrix::multiply(*timestepMatrix(t, keys[t]), product, pool.get());
+        }
+        block = std::make_shared<const Matrix>(std::move(product));
+        if (unitaryCache) {
+            unitaryCache->insert(blockKey, block);
+        }
+    }
+
+    std::shared_ptr<const Matrix> power, base = block;
+    for (int remaining = count; remaining > 0; remaining >>= 1) {
+        if (remaining & 1) {
+            power = power ? std::make_shared<const Matrix>(Matrix::multiply(*base, *power, pool.get())) : base;
+        }
+        if (remaining > 1) {
+            base = std::make_shared<const Matrix>(Matrix::multiply(*base, *base, pool.get()));
+        }
+    }
+    if (unitaryCache) {
+        unitaryCache->insert(powerKey, power);
+    }
+    return power;
+}
+
 Matrix Circuit::calculateTimestepMatrix(int timestep) const {
-    if (timestep < 0 || timestep >= Qcircuit.size()) {
+    if (timestep < 0 || timestep >= timesteps) {
         throw std::out_of_range("Timestep out of range");
     }
+    return *timestepMatrix(timestep, layerKey(timestep));
+}
 
-    // Initialize the result to be the 1x1 identity matrix.
-    Matrix result = Matrix::identityMatrix(1);  
+KroneckerExpression<double> Circuit::timestepKronecker(int timestep, std::vector<std::shared_ptr<QuantumComponent>>& gates) const {
+    const std::vector<const CircuitOp*> ops = timestepOps(timestep);
+    const auto identity = QuantumComponentFactory::create(GateId::Identity);
 
-    // Iterate over the qubits
-    for (int qubit = 0; qubit < qubits; ++qubit) {
-        // Get the gate that acts on the current qubit at the given timestep
-        auto gate = Qcircuit[timestep][qubit];
-        
-        // Get the matrix of the gate
-        Matrix currentMatrix = gate->getMatrix();
+    // The highest qubit is the most significant factor
+    std::vector<const Matrix*> factors;
+    for (int qubit = qubits - 1; qubit >= 0; --qubit) {
+        gates.push_back(ops[qubit] ? componentFor(*ops[qubit]) : identity);
+        factors.push_back(&gates.back()->getMatrixRef());
+    }
+    return KroneckerExpression<double>(std::move(factors));
+}
+
+bool Circuit::hasControlledOps(int timestep) const {
+    for (auto it = timestepBegin(timestep); it != Qcircuit.end() && it->timestep == timestep; ++it) {
+        if (it->controlCount > 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        // Calculate the Kronecker product of the result and the current matrix
-        result = Matrix::kroneckerProduct(currentMatrix, result);
+Matrix Circuit::buildTimestepMatrix(int timestep) const {
+    // Every gate's matrix in one pass, without the chain of growing partial products
+    std::vector<std::shared_ptr<QuantumComponent>> gates;
+    Matrix result = timestepKronecker(timestep, gates).evaluate(pool.get());
+
+    // Controlled gates act on qubits the chain left as identity, so they commute with it
+    for (auto it = timestepBegin(timestep); it != Qcircuit.end() && it->timestep == timestep; ++it) {
+        if (it->controlCount > 0) {
+            result = Matrix::multiply(controlledMatrix(componentFor(*it)->getMatrixRef(),
+                                                       it->target, getControls(*it), qubits), result, pool.get());
+        }
     }
 
     return result;
 }
 
 Matrix Circuit::calculateTotalMatrix() const {
-    // Start with the identity matrix
-    Matrix totalMatrix = Matrix::identityMatrix(1 << qubits);
-
-    // Iterate over the timesteps
-    for (int timestep = 0; timestep < Qcircuit.size(); ++timestep) {
-        // Calculate the matrix for the current timestep
-        Matrix timestepMatrix = calculateTimestepMatrix(timestep);
+    // Equal layers get equal ids, so repeats are found by comparing integers
+    std::vector<std::string> keys(timesteps);
+    std::vector<int> layers(timesteps);
+    std::unordered_map<std::string, int> ids;
+    for (int timestep = 0; timestep < timesteps; ++timestep) {
+        keys[timestep] = layerKey(timestep);
+        layers[timestep] = ids.emplace(keys[timestep], int(ids.size())).first->second;
+    }
 
-        // Multiply the total matrix by the timestep matrix
-        totalMatrix = timestepMatrix * totalMatrix;
+    Matrix totalMatrix;
+    int timestep = 0;
+    while (timestep < timesteps) {
+        // The block repeated back to back from here that covers the most timesteps
+        int period = 1, count = 1;
+        for (int p = 1; p <= maxBlockPeriod && timestep + 2 * p <= timesteps; ++p) {
+            int k = 1;
+            while (timestep + (k + 1) * p <= timesteps &&
+                   std::equal(layers.begin() + timestep, layers.begin() + timestep + p, layers.begin() + timestep + k * p)) {
+                ++k;
+            }
+            if (k > 1 && p * k > period * count) {
+                period = p;
+                count = k;
+            }
+        }
+        if (count == 1 && totalMatrix.getRows() > 0 && !hasControlledOps(timestep)) {
+            // A single layer of uncontrolled gates costs O(n 4^n) applied factor by factor,
+            // against O(8^n) for a product with its matrix
+            std::vector<std::shared_ptr<QuantumComponent>> gates;
+            totalMatrix = timestepKronecker(timestep, gates).apply(totalMatrix, pool.get());
+        } else {
+            const std::shared_ptr<const Matrix> step =
+                count > 1 ? blockPower(keys, timestep, period, count) : timestepMatrix(timestep, keys[timestep]);
+            totalMatrix = totalMatrix.getRows() == 0 ? *step : Matrix::multiply(*step, totalMatrix, pool.get());
+        }
+        timestep += period * count;
     }
 
     return totalMatrix;
 }
 
+void Circuit::setUnitaryCacheCapacity(std::size_t bytes) {
+    unitaryCache = bytes > 0 ? std::make_shared<UnitaryCache>(bytes) : nullptr;
+}
+
+UnitaryCacheStatistics Circuit::getUnitaryCacheStatistics() const {
+    return unitaryCache ? unitaryCache->getStatistics() : UnitaryCacheStatistics();
+}
+
+std::vector<GateOperation> Circuit::compileTimestep(int timestep) const {
+    if (timestep < 0 || timestep >= timesteps) {
+        throw std::out_of_range("Timestep out of range");
+    }
+    int firstParameter = 0;
+    for (auto it = Qcircuit.begin(); it != timestepBegin(timestep); ++it) {
+        firstParameter += it->parameterCount;
+    }
+    return compileTimestep(timestep, firstParameter);
+}
+
+std::vector<GateOperation> Circuit::compileTimestep(int timestep, int firstParameter) const {
+    const std::vector<const CircuitOp*> ops = timestepOps(timestep);
+    const auto identity = QuantumComponentFactory::create(GateId::Identity);
+
+    // Angles are numbered in op order, which is target order within the timestep
+    std::vector<int> parameterIndex(qubits, -1);
+    for (auto it = timestepBegin(timestep); it != Qcircuit.end() && it->timestep == timestep; ++it) {
+        if (it->parameterCount > 0) {
+            parameterIndex[it->target] = firstParameter;
+            firstParameter += it->parameterCount;
+        }
+    }
+
+    const Matrix& pauliX = QuantumComponentFactory::create(GateId::PauliX)->getMatrixRef();
+
+    std::vector<GateOperation> operations;
+
+    // Each gate claims as many bits as its matrix spans, starting where the previous gate stopped,
+    // exactly as the Kronecker chain in calculateTimestepMatrix lays them out.
+    int bit = 0;
+    for (int qubit = 0; qubit < qubits; ++qubit) {
+        const GateId id = ops[qubit] ? ops[qubit]->gate : GateId::Identity;
+        const auto gate = ops[qubit] ? componentFor(*ops[qubit]) : identity;
+        const Matrix& gateMatrix = gate->getMatrixRef();
+
+        int span = 0;
+        while ((1 << span) < gateMatrix.getRows()) {
+            ++span;
+        }
+        if (bit + span > qubits) {
+            throw std::invalid_argument("Gates at timestep " + std::to_string(timestep) + " span more qubits than the circuit has");
+        }
+
+        if (id == GateId::CNOTtarget || id == GateId::Toffoli) {
+            // The fixed CNOT/Toffoli blocks flip their lowest bit when the bits above it are set
+            GateOperation op{pauliX, {bit}, {}};
+            for (int i = 1; i < span; ++i) {
+                op.controls.push_back(bit + i);
+            }
+            operations.push_back(std::move(op));
+        } else if (span > 0 && id != GateId::Identity) {
+            GateOperation op{gateMatrix, {}, {}, parameterIndex[qubit]};
+            for (int i = 0; i < span; ++i) {
+                op.targets.push_back(bit + i);
+            }
+            operations.push_back(std::move(op));
+        }
+        bit += span;
+    }
+
+    if (bit != qubits) {
+        throw std::invalid_argument("Gates at timestep " + std::to_string(timestep) + " do not cover every qubit");
+    }
+
+    for (auto it = timestepBegin(timestep); it != Qcircuit.end() && it->timestep == timestep; ++it) {
+        if (it->controlCount > 0) {
+            operations.push_back(GateOperation{componentFor(*it)->getMatrixRef(), {it->target}, getControls(*it),
+                                               parameterIndex[it->target]});
+        }
+    }
+    return operations;
+}
+
+std::vector<GateOperation> Circuit::compileCircuit() const {
+    std::vector<GateOperation> operations;
+    int firstParameter = 0;
+    auto it = Qcircuit.begin();
+    for (int timestep = 0; timestep < timesteps; ++timestep) {
+        for (GateOperation& op : compileTimestep(timestep, firstParameter)) {
+            operations.push_back(std::move(op));
+        }
+        for (; it != Qcircuit.end() && it->timestep == timestep; ++it) {
+            firstParameter += it->parameterCount;
+        }
+    }
+    return operations;
+}
+
+void Circuit::runOperations(const std::vector<GateOperation>& operations) {
+    if (precision != Precision::Double) {
+        runSingleOperations(operations);
+        return;
+    }
+    // The split amplitudes stay in split form across runs; accessors convert them on demand
+    if (layout == StorageLayout::Split) {
+        SplitComplexArray& amplitudes = splitState();
+        for (const GateOperation& op : operations) {
+            StateVectorSimulator::applyOperation(amplitudes, qubits, op, pool.get());
+        }
+    } else {
+        Matrix& stateVector = state();
+        for (const GateOperation& op : operations) {
+            StateVectorSimulator::applyOperation(stateVector.data(), qubits, op, pool.get());
+        }
+    }
+}
+
+void Circuit::runFromCheckpoints() {
+    std::vector<std::string> keys(timesteps);
+    for (int timestep = 0; timestep < timesteps; ++timestep) {
+        keys[timestep] = layerKey(timestep);
+    }
+    int dirty = 0;
+    if (checkpoints.empty()) {
+        checkpoints.emplace(0, stateSnapshot());
+    } else {
+        const int common = std::min<int>(timesteps, checkpointKeys.size());
+        while (dirty < common && keys[dirty] == checkpointKeys[dirty]) {
+            ++dirty;
+        }
+        if (dirty == timesteps && timesteps == int(checkpointKeys.size())) {
+            checkpointStatistics.resumedFrom = timesteps;
+            checkpointStatistics.timestepsRun = 0;
+            return;
+        }
+    }
+    // States after the first changed timestep are stale. When timesteps were only appended, the
+    // current state is the state before the first new one.
+    checkpoints.erase(checkpoints.upper_bound(dirty), checkpoints.end());
+    int timestep = dirty;
+    if (dirty != int(checkpointKeys.size()) || checkpointKeys.empty()) {
+        const auto resume = std::prev(checkpoints.upper_bound(dirty));
+        restoreState(resume->second);
+        timestep = resume->first;
+    }
+
+    const std::size_t stateBytes = (std::size_t(1) << qubits) * sizeof(Complex);
+    const std::size_t room = checkpointBudget / stateBytes;
+    int interval = checkpointInterval;
+    while (room > 0 && std::size_t((timesteps - 1) / interval) > room) {
+        interval *= 2;
+    }
+    std::vector<int> firstParameter(timesteps, 0);
+    int parameters = 0;
+    auto op = Qcircuit.begin();
+    for (int timestep = 0; timestep < timesteps; ++timestep) {
+        for (; op != Qcircuit.end() && op->timestep < timestep; ++op) {
+            parameters += op->parameterCount;
+        }
+        firstParameter[timestep] = parameters;
+    }
+
+    // Segments end on checkpoint boundaries, so fusion never spans one
+    checkpointStatistics.resumedFrom = timestep;
+    checkpointStatistics.timestepsRun = timesteps - timestep;
+    while (timestep < timesteps) {
+        const int end = std::min(timesteps, (timestep / interval + 1) * interval);
+        std::vector<GateOperation> operations;
+        for (; timestep < end; ++timestep) {
+            const std::vector<GateOperation> step = compileTimestep(timestep, firstParameter[timestep]);
+            operations.insert(operations.end(), step.begin(), step.end());
+        }
+        if (fusionQubits > 0) {
+            FusionStatistics segment;
+            operations = GateFusion::fuse(operations, fusionQubits, &segment);
+            fusionStatistics += segment;
+        }
+        runOperations(operations);
+        if (timestep < timesteps && checkpoints.size() - 1 < room) {
+            checkpoints.emplace(timestep, stateSnapshot());
+        }
+    }
+    // Checkpoints left from a finer interval give way once the budget is reached
+    for (auto it = std::next(checkpoints.begin()); it != checkpoints.end() && checkpoints.size() - 1 > room;) {
+        it = it->first % interval != 0 ? checkpoints.erase(it) : std::next(it);
+    }
+    checkpointKeys = std::move(keys);
+    checkpointStatistics.checkpoints = checkpoints.size();
+    checkpointStatistics.bytes = checkpoints.size() * stateBytes;
+    checkpointStatistics.interval = interval;
+}
+
+void Circuit::clearCheckpoints() {
+    checkpoints.clear();
+    checkpointKeys.clear();
+    checkpointStatistics = CheckpointStatistics();
+}
+
+void Circuit::runSingleOperations(const std::vector<GateOperation>& operations) {
+    Matrix reference;
+    if (fidelityCheck) {
+        reference = simulate(operations);
+    }
+    // The split layout is double only, so reduced-precision runs always use the interleaved kernels
+    MatrixF& amplitudes = singleState();
+    for (std::size_t k = 0; k < operations.size(); ++k) {
+        StateVectorSimulator::applyOperation(amplitudes.data(), qubits, operations[k], pool.get());
+        if (precision == Precision::Mixed && (k + 1) % renormalizeInterval == 0) {
+            normalizeInDouble(amplitudes.data(), amplitudes.getRows());
+        }
+    }
+    if (precision == Precision::Mixed) {
+        normalizeInDouble(amplitudes.data(), amplitudes.getRows());
+    }
+
+    if (fidelityCheck) {
+        // Both states are normalized in double first, since fp32 rounding leaves the Single state's
+        // norm slightly off 1; the clamp absorbs the last bits of fp64 rounding.
+        double overlapReal = 0, overlapImag = 0, referenceNorm = 0, norm = 0;
+        for (int i = 0; i < amplitudes.getRows(); ++i) {
+            const Complex a = reference.data()[i];
+            const double bReal = amplitudes.data()[i].get_real(), bImag = amplitudes.data()[i].get_imag();
+            overlapReal += a.get_real() * bReal + a.get_imag() * bImag;
+            overlapImag += a.get_real() * bImag - a.get_imag() * bReal;
+            referenceNorm += a.get_real() * a.get_real() + a.get_imag() * a.get_imag();
+            norm += bReal * bReal + bImag * bImag;
+        }
+        const double overlap = overlapReal * overlapReal + overlapImag * overlapImag;
+        fidelity = norm > 0 && referenceNorm > 0 ? std::min(1.0, overlap / (referenceNorm * norm)) : 0.0;
+        if (verbose) {
+            std::cout << "Fidelity against fp64: " << std::setprecision(12) << fidelity << std::setprecision(6) << '\n';
+        }
+    }
+}
+
+Matrix Circuit::simulate(const std::vector<GateOperation>& operations) const {
+    Matrix psi = state();
+    for (const GateOperation& op : operations) {
+        StateVectorSimulator::applyOperation(psi.data(), qubits, op, pool.get());
+    }
+    return psi;
+}
+
+double Circuit::expectation(const Matrix& observable) const {
+    const Matrix& psi = state();
+    return realInnerProduct(psi, applyObservable(observable, psi, pool.get()));
+}
+
+double Circuit::expectation(const PauliObservable& observable) const {
+    return observable.expectation(state().data(), qubits, pool.get());
+}
+
+std::vector<double> Circuit::gradient(const Matrix& observable) const {
+    return adjointGradient([&](const Matrix& psi) { return applyObservable(observable, psi, pool.get()); });
+}
+
+std::vector<double> Circuit::gradient(const PauliObservable& observable) const {
+    return adjointGradient([&](const Matrix& psi) {
+        Matrix result(psi.getRows(), 1);
+        observable.apply(psi.data(), result.data(), qubits, pool.get());
+        return result;
+    });
+}
+
+std::vector<double> Circuit::adjointGradient(const std::function<Matrix(const Matrix&)>& observe) const {
+    // dU/d(angle) for every trainable angle, in getParameters() order
+    std::vector<Matrix> derivatives;
+    std::vector<std::uint32_t> angleCount;  // angles of the op whose first angle sits at this index
+    for (const CircuitOp& circuitOp : Qcircuit) {
+        if (circuitOp.parameterCount == 0) {
+            continue;
+        }
+        const auto gate = std::dynamic_pointer_cast<ParameterizedGate>(componentFor(circuitOp));
+        for (std::uint32_t p = 0; p < circuitOp.parameterCount; ++p) {
+            derivatives.push_back(gate->getDerivative(p));
+            angleCount.push_back(p == 0 ? circuitOp.parameterCount : 0);
+        }
+    }
+    std::vector<double> result(derivatives.size(), 0.0);
+    if (derivatives.empty()) {
+        return result;
+    }
+
+    const std::vector<GateOperation> operations = compileCircuit();
+    const std::size_t count = operations.size();
+    // Forward pass keeps psi after every `stride` ops; the backward pass snaps back to these
+    // so that rounding from repeated U^dagger applications does not accumulate.
+    const std::size_t stride = std::max<std::size_t>(1, std::size_t(std::sqrt(double(count))));
+    std::vector<Matrix> checkpoints;
+    Matrix psi = state();
+    for (std::size_t k = 0; k < count; ++k) {
+        if (k % stride == 0) {
+            checkpoints.push_back(psi);
+        }
+        StateVectorSimulator::applyOperation(psi.data(), qubits, operations[k], pool.get());
+    }
+
+    Matrix lambda = observe(psi);
+    for (std::size_t k = count; k-- > 0;) {
+        const GateOperation& op = operations[k];
+        GateOperation inverse{op.matrix.adjoint(), op.targets, op.controls};
+        if (k % stride == 0) {
+            psi = checkpoints[k / stride];
+        } else {
+            StateVectorSimulator::applyOperation(psi.data(), qubits, inverse, pool.get());
+        }
+
+        // psi is now the state entering op k; lambda is O psi_final pulled back to after op k
+        if (op.firstParameter >= 0) {
+            std::size_t controlMask = 0;
+            for (int control : op.controls) {
+                controlMask |= std::size_t(1) << control;
+            }
+            for (std::uint32_t p = 0; p < angleCount[op.firstParameter]; ++p) {
+                GateOperation derivative{derivatives[op.firstParameter + p], op.targets, op.controls};
+                Matrix mu = psi;
+                StateVectorSimulator::applyOperation(mu.data(), qubits, derivative, pool.get());
+                // d(controlled U) is dU on the controlled subspace and zero elsewhere
+                if (controlMask != 0) {
+                    Complex* amplitudes = mu.data();
+                    for (std::size_t i = 0; i < std::size_t(mu.getRows()); ++i) {
+                        if ((i & controlMask) != controlMask) {
+                            amplitudes[i] = Complex(0, 0);
+                        }
+                    }
+                }
+                result[op.firstParameter + p] = 2 * realInnerProduct(lambda, mu);
+            }
+        }
+        StateVectorSimulator::applyOperation(lambda.data(), qubits, inverse, pool.get());
+    }
+    return result;
+}
+
+std::vector<double> Circuit::parameterShiftGradient(const Matrix& observable) const {
+    for (const CircuitOp& op : Qcircuit) {
+        if (op.parameterCount > 0 && op.controlCount > 0) {
+            throw std::invalid_argument("Parameter shift does not apply to controlled rotations; use gradient()");
+        }
+    }
+    const double shift = std::acos(-1.0) / 2;
+    const std::vector<double> values = getParameters();
+    std::vector<double> result(values.size());
+    Circuit shifted(*this);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        std::vector<double> moved = values;
+        moved[i] = values[i] + shift;
+        shifted.setParameters(moved);
+        Matrix plus = shifted.simulate(shifted.compileCircuit());
+        moved[i] = values[i] - shift;
+        shifted.setParameters(moved);
+        Matrix minus = shifted.simulate(shifted.compileCircuit());
+        result[i] = (realInnerProduct(plus, applyObservable(observable, plus, pool.get())) -
+                     realInnerProduct(minus, applyObservable(observable, minus, pool.get()))) / 2;
+    }
+    return result;
+}
+
+bool Circuit::stabilizerApplies(const std::vector<GateOperation>& operations, std::string& reason) const {
+    if (noise.hasGateNoise() || noise.hasReadoutError()) {
+        reason = "the noise model is not supported";
+        return false;
+    }
+    // A prepared or previously evolved amplitude vector cannot be turned into a tableau
+    if (!stabilizerActive && (stateVector.getRows() != 0 || singleStateVector.getRows() != 0 || mpsActive)) {
+        reason = "the state vector already holds a state";
+        return false;
+    }
+    for (const GateOperation& op : operations) {
+        if (!StabilizerTableau::isClifford(op)) {
+            reason = "it contains non-Clifford gates";
+            return false;
+        }
+    }
+    return true;
+}
+
+void Circuit::setSimulationMode(SimulationMode newMode) {
+    mode = newMode;
+}
+
+SimulationMode Circuit::getSimulationMode() const {
+    return mode;
+}
+
+void Circuit::setStorageLayout(StorageLayout newLayout) {
+    layout = newLayout;
+}
+
+StorageLayout Circuit::getStorageLayout() const {
+    return layout;
+}
+
+void Circuit::setPrecision(Precision newPrecision) {
+    precision = newPrecision;
+}
+
+Precision Circuit::getPrecision() const {
+    return precision;
+}
+
+void Circuit::setFidelityCheck(bool enabled) {
+    fidelityCheck = enabled;
+}
+
+double Circuit::getFidelity() const {
+    return fidelity;
+}
+
+void Circuit::setGateFusion(int maxFusedQubits) {
+    if (maxFusedQubits < 0 || maxFusedQubits > 3) {
+        throw std::invalid_argument("Fused operations can span at most 3 qubits");
+    }
+    fusionQubits = maxFusedQubits;
+}
+
+const FusionStatistics& Circuit::getFusionStatistics() const {
+    return fusionStatistics;
+}
+
+OptimizationStatistics Circuit::optimize() {
+    std::vector<PlacedGate> gates;
+    gates.reserve(Qcircuit.size());
+    for (const CircuitOp& op : Qcircuit) {
+        gates.push_back({op.gate, op.timestep, op.target, getControls(op), getParameters(op)});
+    }
+    OptimizationStatistics stats;
+    gates = CircuitOptimizer::optimize(gates, &stats);
+
+    // Survivors keep their order; timesteps are renumbered so none stays empty
+    Qcircuit.clear();
+    controlQubits.clear();
+    parameterValues.clear();
+    int previous = -1, timestep = -1;
+    for (const PlacedGate& gate : gates) {
+        if (gate.timestep != previous) {
+            previous = gate.timestep;
+            ++timestep;
+        }
+        CircuitOp op{gate.gate, timestep, gate.target, std::uint32_t(controlQubits.size()), std::uint32_t(gate.controls.size()),
+                     std::uint32_t(parameterValues.size()), std::uint32_t(gate.parameters.size())};
+        controlQubits.insert(controlQubits.end(), gate.controls.begin(), gate.controls.end());
+        parameterValues.insert(parameterValues.end(), gate.parameters.begin(), gate.parameters.end());
+        insertOp(op);
+    }
+    timesteps = std::max(1, timestep + 1);
+    return stats;
+}
+
+void Circuit::setMaxBondDimension(int maxBond, double cutoff) {
+    if (maxBond < 1) {
+        throw std::invalid_argument("Bond dimension must be at least 1");
+    }
+    maxBondDimension = maxBond;
+    truncationCutoff = cutoff;
+    if (mpsActive) {
+        mps.setTruncation(maxBond, cutoff);
+    }
+}
+
+void Circuit::setCheckpointInterval(int interval, std::size_t budgetBytes) {
+    if (interval < 0) {
+        throw std::invalid_argument("Checkpoint interval cannot be negative");
+    }
+    checkpointInterval = interval;
+    checkpointBudget = budgetBytes;
+    clearCheckpoints();
+}
+
+const CheckpointStatistics& Circuit::getCheckpointStatistics() const {
+    return checkpointStatistics;
+}
+
+int Circuit::getMaxBondDimension() const {
+    return maxBondDimension;
+}
+
+MPSStatistics Circuit::getMPSStatistics() const {
+    return mpsActive ? mps.getStatistics() : MPSStatistics();
+}
+
+void Circuit::setThreadCount(int threads) {
+    if (threads < 0) {
+        throw std::invalid_argument("Thread count cannot be negative");
+    }
+    if (threads == 1) {
+        pool.reset();
+    } else {
+        pool = std::make_shared<ThreadPool>(threads);
+    }
+}
+
+int Circuit::getThreadCount() const {
+    return pool ? pool->size() : 1;
+}
+
+const Matrix& Circuit::getStateVector() const {
+    return state();
+}
+
+void Circuit::initializeStateBatch(const Matrix& states) {
+    if (qubits > 30 || states.getRows() != (1 << qubits) || states.getCols() < 1) {
+        throw std::invalid_argument("Batch must have 2^qubits rows and at least one column");
+    }
+    stateBatch = states;
+}
+
+void Circuit::initializeBasisBatch(const std::vector<std::size_t>& basisStates) {
+    if (qubits > 30 || basisStates.empty()) {
+        throw std::invalid_argument("Basis batch needs at least one state and at most 30 qubits");
+    }
+    Matrix states(1 << qubits, basisStates.size());
+    for (std::size_t column = 0; column < basisStates.size(); ++column) {
+        if (basisStates[column] >= (std::size_t(1) << qubits)) {
+            throw std::out_of_range("Basis state out of range");
+        }
+        states(basisStates[column] + 1, column + 1) = Complex(1, 0);
+    }
+    stateBatch = std::move(states);
+}
+
+void Circuit::applyCircuitBatch() {
+    if (stateBatch.getRows() == 0) {
+        throw std::logic_error("No batch of states has been initialized");
+    }
+    std::vector<GateOperation> operations = compileCircuit();
+    if (fusionQubits > 0) {
+        operations = GateFusion::fuse(operations, fusionQubits, &fusionStatistics);
+    }
+    for (const GateOperation& op : operations) {
+        StateVectorSimulator::applyOperationBatch(stateBatch.data(), qubits, stateBatch.getCols(), op, pool.get());
+    }
+}
+
+OutOfCoreStatistics Circuit::applyCircuit(OutOfCoreStateVector& storage) const {
+    if (storage.getQubits() != qubits) {
+        throw std::invalid_argument("Out-of-core state has a different number of qubits");
+    }
+    std::vector<GateOperation> operations = compileCircuit();
+    if (fusionQubits > 0) {
+        operations = GateFusion::fuse(operations, fusionQubits);
+    }
+    OutOfCoreStatistics stats = storage.run(operations, pool.get());
+    if (verbose) {
+        std::cout << stats << '\n';
+    }
+    return stats;
+}
+
+DistributedStatistics Circuit::applyCircuitDistributed(int processes, TransportKind transport, int threadsPerProcess) {
+    std::vector<GateOperation> operations = compileCircuit();
+    if (fusionQubits > 0) {
+        operations = GateFusion::fuse(operations, fusionQubits, &fusionStatistics);
+    }
+    Matrix& stateVector = state();
+    sampler.reset();
+    clearCheckpoints();
+    DistributedStatistics stats =
+        DistributedStateVector::simulate(stateVector.data(), qubits, operations, processes, transport, threadsPerProcess);
+    if (verbose) {
+        std::cout << stats << '\n';
+    }
+    return stats;
+}
+
+const Matrix& Circuit::getStateBatch() const {
+    return stateBatch;
+}
+
+MeasurementCounts Circuit::sample(std::uint64_t shots, std::uint64_t seed) const {
+    if (stabilizerActive && !noise.hasReadoutError()) {
+        return tableau.sample(shots, seed, pool.get());
+    }
+    if (mpsActive && !noise.hasReadoutError()) {
+        return mps.sample(shots, seed, pool.get());
+    }
+    if (!sampler) {
+        if (densityState.getRows() != 0 || noise.hasReadoutError()) {
+            sampler = std::make_shared<MeasurementSampler>(outcomeProbabilities(), qubits);
+        } else {
+            sampler = std::make_shared<MeasurementSampler>(state().data(), qubits);
+        }
+    }
+    return sampler->sample(shots, seed, pool.get());
+}
+
+MeasurementCounts Circuit::sampleMarginal(const std::vector<int>& measured, std::uint64_t shots, std::uint64_t seed) const {
+    if ((stabilizerActive || mpsActive) && !noise.hasReadoutError()) {
+        for (int qubit : measured) {
+            if (qubit < 0 || qubit >= qubits) {
+                throw std::out_of_range("Measured qubit out of range");
+            }
+        }
+        MeasurementCounts counts;
+        const MeasurementCounts full = stabilizerActive ? tableau.sample(shots, seed, pool.get()) : mps.sample(shots, seed, pool.get());
+        for (const auto& entry : full) {
+            std::string bits(measured.size(), '0');
+            for (std::size_t bit = 0; bit < measured.size(); ++bit) {
+                bits[measured.size() - 1 - bit] = entry.first[qubits - 1 - measured[bit]];
+            }
+            counts[bits] += entry.second;
+        }
+        return counts;
+    }
+    if (densityState.getRows() == 0 && !noise.hasReadoutError()) {
+        MeasurementSampler marginal(MeasurementSampler::marginalProbabilities(state().data(), qubits, measured), measured.size());
+        return marginal.sample(shots, seed, pool.get());
+    }
+    for (int qubit : measured) {
+        if (qubit < 0 || qubit >= qubits) {
+            throw std::out_of_range("Measured qubit out of range");
+        }
+    }
+    const std::vector<double> full = outcomeProbabilities();
+    std::vector<double> reduced(std::size_t(1) << measured.size(), 0.0);
+    for (std::size_t index = 0; index < full.size(); ++index) {
+        std::size_t outcome = 0;
+        for (std::size_t bit = 0; bit < measured.size(); ++bit) {
+            outcome |= ((index >> measured[bit]) & 1) << bit;
+        }
+        reduced[outcome] += full[index];
+    }
+    MeasurementSampler marginal(reduced, measured.size());
+    return marginal.sample(shots, seed, pool.get());
+}
+
+void Circuit::setNoiseModel(const NoiseModel& model) {
+    noise = model;
+    sampler.reset();
+}
+
+const NoiseModel& Circuit::getNoiseModel() const {
+    return noise;
+}
+
+Matrix Circuit::getDensityMatrix() const {
+    if (densityState.getRows() != 0) {
+        return DensityMatrixSimulator::toMatrix(densityState.data(), qubits);
+    }
+    return DensityMatrixSimulator::toMatrix(DensityMatrixSimulator::fromState(state().data(), qubits).data(), qubits);
+}
+
+MeasurementCounts Circuit::sampleTrajectories(std::uint64_t trajectories, std::uint64_t seed) const {
+    const std::vector<GateOperation> operations = compileCircuit();
+    const Matrix& initial = state();
+    const auto& channels = noise.getGateChannels();
+
+    std::mutex merge;
+    MeasurementCounts counts;
+    auto run = [&](std::size_t first, std::size_t last) {
+        Matrix psi;
+        std::map<std::uint64_t, std::uint64_t> local;
+        for (std::size_t trajectory = first; trajectory < last; ++trajectory) {
+            // Each trajectory owns its random stream, so results do not depend on scheduling
+            std::mt19937_64 rng(trajectorySeed(seed + trajectory));
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            psi = initial;
+            for (const GateOperation& op : operations) {
+                StateVectorSimulator::applyOperation(psi.data(), qubits, op);
+                for (const std::vector<int>* list : {&op.targets, &op.controls}) {
+                    for (int qubit : *list) {
+                        for (const auto& kraus : channels) {
+                            DensityMatrixSimulator::applyTrajectoryChannel(psi.data(), qubits, kraus, qubit, uniform(rng));
+                        }
+                    }
+                }
+            }
+            MeasurementSampler measure(psi.data(), qubits);
+            ++local[noise.applyReadoutError(measure.draw(uniform(rng)), qubits, rng)];
+        }
+        std::lock_guard<std::mutex> lock(merge);
+        for (const auto& [outcome, count] : local) {
+            counts[MeasurementSampler::toBitstring(outcome, qubits)] += count;
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, trajectories, 1, run);
+    } else {
+        run(0, trajectories);
+    }
+    return counts;
+}
+
+void Circuit::setVerbose(bool printState) {
+    verbose = printState;
+}
+
 void Circuit::configureCircuit() {
     std::string gateName;
     int qubit, timestep;
@@ -228,11 +1375,122 @@ printCircuit();
 }
 
 void Circuit::applyCircuit() {
-    // Calculate the total matrix of the circuit
-    Matrix totalMatrix = calculateTotalMatrix();
+    sampler.reset();
+    fusionStatistics = FusionStatistics();
+    // Other modes and precisions change the state without updating the checkpoints
+    const bool resumable = checkpointInterval > 0 && precision == Precision::Double &&
+                           (mode == SimulationMode::StateVector || mode == SimulationMode::Automatic);
+    if (!resumable) {
+        clearCheckpoints();
+    }
+    if (mode != SimulationMode::DensityMatrix) {
+        requirePureState();
+    }
+    if (mode == SimulationMode::Dense) {
+        // Calculate the total matrix of the circuit
+        Matrix totalMatrix = calculateTotalMatrix();
 
-    // Multiply the state vector by the total matrix
-    stateVector = totalMatrix * stateVector;
+        // Multiply the state vector by the total matrix
+        Matrix& stateVector = state();
+        stateVector = Matrix::multiply(totalMatrix, stateVector, pool.get());
+    } else if (mode == SimulationMode::DensityMatrix) {
+        // Noise follows each gate, so gates are only fused when there is none
+        std::vector<GateOperation> operations = compileCircuit();
+        if (fusionQubits > 0 && !noise.hasGateNoise()) {
+            operations = GateFusion::fuse(operations, fusionQubits, &fusionStatistics);
+        }
+        Matrix& rho = density();
+        for (const GateOperation& op : operations) {
+            DensityMatrixSimulator::applyOperation(rho.data(), qubits, op, pool.get());
+            for (const std::vector<int>* list : {&op.targets, &op.controls}) {
+                for (int qubit : *list) {
+                    for (const auto& kraus : noise.getGateChannels()) {
+                        DensityMatrixSimulator::applyChannel(rho.data(), qubits, kraus, qubit, pool.get());
+                    }
+                }
+            }
+        }
+        if (verbose) {
+            const std::vector<double> probabilities = DensityMatrixSimulator::probabilities(rho.data(), qubits);
+            std::cout << " Mixed State :\n";
+            for (std::size_t i = 0; i < probabilities.size(); ++i) {
+                if (probabilities[i] > 1e-12) {
+                    std::cout << "State |" << i << ">: Probability = " << probabilities[i] << '\n';
+                }
+            }
+        }
+        return;
+    } else if (mode == SimulationMode::MatrixProductState) {
+        if (noise.hasGateNoise()) {
+            throw std::invalid_argument("Matrix product state mode does not support gate noise");
+        }
+        if (!mpsActive) {
+            // An existing amplitude vector is decomposed once; otherwise the chain starts as |0...0>
+            if (stateVector.getRows() != 0 || singleStateVector.getRows() != 0 || splitStateVector.size() != 0 ||
+                stabilizerActive) {
+                mps = MatrixProductState::fromStateVector(state().data(), qubits, maxBondDimension, truncationCutoff);
+                stateVector = Matrix();
+            } else {
+                mps = MatrixProductState(qubits, maxBondDimension, truncationCutoff);
+            }
+            mpsActive = true;
+        }
+        for (const GateOperation& op : compileCircuit()) {
+            mps.applyOperation(op);
+        }
+        if (verbose) {
+            std::cout << " Matrix Product State :\n" << mps;
+        }
+        return;
+    } else {
+        std::vector<GateOperation> operations = compileCircuit();
+        if (mode == SimulationMode::Stabilizer || mode == SimulationMode::Automatic) {
+            std::string reason;
+            if (stabilizerApplies(operations, reason)) {
+                if (!stabilizerActive) {
+                    tableau = StabilizerTableau(qubits);
+                    stabilizerActive = true;
+                }
+                for (const GateOperation& op : operations) {
+                    tableau.applyOperation(op);
+                }
+                if (verbose) {
+                    std::cout << " Stabilizer State :\n";
+                    if (qubits <= 64) {
+                        std::cout << tableau;
+                    } else {
+                        std::cout << qubits << " qubits, " << operations.size() << " Clifford gates\n";
+                    }
+                }
+                return;
+            }
+            if (mode == SimulationMode::Stabilizer) {
+                throw std::invalid_argument("Stabilizer mode cannot run this circuit: " + reason);
+            }
+        }
+        if (resumable) {
+            runFromCheckpoints();
+            if (verbose) {
+                if (fusionQubits > 0) {
+                    std::cout << fusionStatistics << '\n';
+                }
+                std::cout << checkpointStatistics << '\n';
+            }
+        } else {
+            // Apply each gate directly to the state vector
+            if (fusionQubits > 0) {
+                operations = GateFusion::fuse(operations, fusionQubits, &fusionStatistics);
+                if (verbose) {
+                    std::cout << fusionStatistics << '\n';
+                }
+            }
+            runOperations(operations);
+        }
+    }
+    if (!verbose) {
+        return;
+    }
+    const Matrix& stateVector = state();
     std::cout << " Superposition State :\n" << stateVector << '\n';
     // Output the probability amplitude for each state
     for (int i = 1; i < stateVector.getRows()+ 1; ++i) {
@@ -253,10 +1511,28 @@ void Circuit::printCircuit() const {
     std::string vertical_line = "|";
     int max_gate_name_length = 4;  // default minimum length for gate name
 
+    // Gate names per (timestep, qubit) from the grid view; controlled gates mark their control wires
+    std::vector<std::vector<int>> controlTargets;
+    const std::vector<std::vector<std::shared_ptr<QuantumComponent>>> cells = getGrid(&controlTargets);
+    std::vector<std::vector<std::string>> grid(timesteps, std::vector<std::string>(qubits, "."));
+    for (int t = 0; t < timesteps; ++t) {
+        for (int q = 0; q < qubits; ++q) {
+            const int target = controlTargets[t][q];
+            if (target >= 0) {
+                grid[t][q] = "ctrl";
+                if (grid[t][target].compare(0, 2, "C-") != 0) {
+                    grid[t][target] = "C-" + cells[t][target]->getName();
+                }
+            } else if (cells[t][q]->getId() != GateId::Identity && grid[t][q] == ".") {
+                grid[t][q] = cells[t][q]->getName();
+            }
+        }
+    }
+
     // Calculate the maximum gate name length
-    for (const auto& timestep : Qcircuit) {
+    for (const auto& timestep : grid) {
         for (const auto& gate : timestep) {
-            int gate_name_length = gate->getName().length();
+            int gate_name_length = gate.length();
             if (gate_name_length > max_gate_name_length) {
                 max_gate_name_length = gate_name_length;
             }
@@ -266,16 +1542,16 @@ void Circuit::printCircuit() const {
     // Print header
     std::cout << "\033[1m" << "Quantum Circuit: " << "\033[0m" << "\n";
     std::cout << "Number of qubits: " << qubits << "\n";
-    std::cout << "Number of timesteps: " << Qcircuit.size() << "\n\n";
+    std::cout << "Number of timesteps: " << grid.size() << "\n\n";
 
     // Print each qubit
     for (int i = 0; i < qubits; i++) {
         std::cout << "Qubit " << i + 1 << ": ";
         
         // Print gates in each timestep
-        for (const auto& timestep : Qcircuit) {
+        for (const auto& timestep : grid) {
             std::cout << vertical_line << std::setw(max_gate_name_length) << std::left 
-                      << timestep[i]->getName() << vertical_line;
+                      << timestep[i] << vertical_line;
             
             std::cout << horizontal_line;
         }
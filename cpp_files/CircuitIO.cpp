@@ -0,0 +1,539 @@
+#include "../h_files/CircuitIO.h"
+
+#include <fstream>
+#include <map>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+const char binaryMagic[4] = {'Q', 'C', 'B', '1'};
+
+// A gate read from QASM, kept until the whole file is scheduled so the circuit is built in op order
+struct ParsedGate {
+    GateId gate;
+    int timestep;
+    int target;
+    std::vector<int> controls;
+    std::vector<double> parameters;
+};
+
+struct GateSpec {
+    GateId gate;
+    int angles;    // angles written in the QASM call
+    int controls;  // leading operands that act as controls
+};
+
+const std::map<std::string, GateSpec>& gateTable() {
+    static const std::map<std::string, GateSpec> table = {
+        {"id", {GateId::Identity, 0, 0}},   {"x", {GateId::PauliX, 0, 0}},     {"y", {GateId::PauliY, 0, 0}},
+        {"z", {GateId::PauliZ, 0, 0}},      {"h", {GateId::Hadamard, 0, 0}},   {"s", {GateId::SGate, 0, 0}},
+        {"t", {GateId::TGate, 0, 0}},       {"sdg", {GateId::Phase, 0, 0}},    {"tdg", {GateId::Phase, 0, 0}},
+        {"rx", {GateId::RotationX, 1, 0}},  {"ry", {GateId::RotationY, 1, 0}}, {"rz", {GateId::RotationZ, 1, 0}},
+        {"u1", {GateId::Phase, 1, 0}},      {"p", {GateId::Phase, 1, 0}},      {"u2", {GateId::U3, 2, 0}},
+        {"u3", {GateId::U3, 3, 0}},         {"u", {GateId::U3, 3, 0}},         {"cx", {GateId::PauliX, 0, 1}},
+        {"CX", {GateId::PauliX, 0, 1}},     {"cy", {GateId::PauliY, 0, 1}},    {"cz", {GateId::PauliZ, 0, 1}},
+        {"ch", {GateId::Hadamard, 0, 1}},   {"crx", {GateId::RotationX, 1, 1}}, {"cry", {GateId::RotationY, 1, 1}},
+        {"crz", {GateId::RotationZ, 1, 1}}, {"cu1", {GateId::Phase, 1, 1}},    {"cp", {GateId::Phase, 1, 1}},
+        {"cu3", {GateId::U3, 3, 1}},        {"ccx", {GateId::PauliX, 0, 2}},   {"swap", {GateId::PauliX, 0, 0}},
+    };
+    return table;
+}
+
+// Recursive descent over QASM angle expressions: numbers, pi, + - * / ^, unary minus,
+// parentheses and sin cos tan exp ln sqrt
+class ExpressionParser {
+public:
+    explicit ExpressionParser(const std::string& text) : text(text), pos(0) {}
+
+    double parse() {
+        double value = sum();
+        skipSpace();
+        if (pos != text.size()) {
+            throw std::invalid_argument("Unexpected '" + text.substr(pos) + "' in angle expression");
+        }
+        return value;
+    }
+
+private:
+    const std::string& text;
+    std::size_t pos;
+
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool accept(char c) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    double sum() {
+        double value = product();
+        while (true) {
+            if (accept('+')) {
+                value += product();
+            } else if (accept('-')) {
+                value -= product();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    double product() {
+        double value = power();
+        while (true) {
+            if (accept('*')) {
+                value *= power();
+            } else if (accept('/')) {
+                value /= power();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    double power() {
+        double base = unary();
+        if (accept('^')) {
+            return std::pow(base, power());
+        }
+        return base;
+    }
+
+    double unary() {
+        if (accept('-')) {
+            return -unary();
+        }
+        if (accept('+')) {
+            return unary();
+        }
+        return primary();
+    }
+
+    double primary() {
+        if (accept('(')) {
+            double value = sum();
+            if (!accept(')')) {
+                throw std::invalid_argument("Missing ')' in angle expression");
+            }
+            return value;
+        }
+        skipSpace();
+        const std::size_t start = pos;
+        if (pos < text.size() && std::isalpha(static_cast<unsigned char>(text[pos]))) {
+            while (pos < text.size() && std::isalnum(static_cast<unsigned char>(text[pos]))) {
+                ++pos;
+            }
+            const std::string name = text.substr(start, pos - start);
+            if (name == "pi") {
+                return std::acos(-1.0);
+            }
+            if (!accept('(')) {
+                throw std::invalid_argument("Unknown identifier '" + name + "' in angle expression");
+            }
+            double argument = sum();
+            if (!accept(')')) {
+                throw std::invalid_argument("Missing ')' after " + name);
+            }
+            if (name == "sin") return std::sin(argument);
+            if (name == "cos") return std::cos(argument);
+            if (name == "tan") return std::tan(argument);
+            if (name == "exp") return std::exp(argument);
+            if (name == "ln") return std::log(argument);
+            if (name == "sqrt") return std::sqrt(argument);
+            throw std::invalid_argument("Unknown function '" + name + "' in angle expression");
+        }
+        char* end = nullptr;
+        double value = std::strtod(text.c_str() + pos, &end);
+        if (end == text.c_str() + pos) {
+            throw std::invalid_argument("Expected a number in angle expression");
+        }
+        pos = end - text.c_str();
+        return value;
+    }
+};
+
+std::string trim(const std::string& text) {
+    std::size_t first = 0, last = text.size();
+    while (first < last && std::isspace(static_cast<unsigned char>(text[first]))) {
+        ++first;
+    }
+    while (last > first && std::isspace(static_cast<unsigned char>(text[last - 1]))) {
+        --last;
+    }
+    return text.substr(first, last - first);
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    int depth = 0;
+    std::string current;
+    for (char c : text) {
+        if (c == ',' && depth == 0) {
+            items.push_back(trim(current));
+            current.clear();
+            continue;
+        }
+        depth += (c == '(') - (c == ')');
+        current += c;
+    }
+    if (!trim(current).empty() || !items.empty()) {
+        items.push_back(trim(current));
+    }
+    return items;
+}
+
+// Parses QASM one statement at a time and schedules each gate as soon as its qubits are free
+class QasmParser {
+public:
+    explicit QasmParser(std::istream& in) : in(in), line(1), totalQubits(0) {}
+
+    Circuit parse() {
+        std::string statement;
+        while (nextStatement(statement)) {
+            try {
+                handle(statement);
+            } catch (const std::exception& error) {
+                throw std::invalid_argument("QASM line " + std::to_string(statementLine) + ": " + error.what());
+            }
+        }
+        if (totalQubits == 0) {
+            throw std::invalid_argument("QASM file declares no qubits");
+        }
+
+        // Ops were scheduled out of order across qubits; sorting first keeps every insert an append
+        std::stable_sort(gates.begin(), gates.end(), [](const ParsedGate& a, const ParsedGate& b) {
+            return a.timestep != b.timestep ? a.timestep < b.timestep : a.target < b.target;
+        });
+        Circuit circuit(totalQubits);
+        for (const ParsedGate& gate : gates) {
+            auto component = QuantumComponentFactory::create(gate.gate, gate.parameters);
+            if (gate.controls.empty()) {
+                circuit.addGate(component, gate.target, gate.timestep);
+            } else {
+                circuit.addControlledGate(component, gate.controls, gate.target, gate.timestep);
+            }
+        }
+        return circuit;
+    }
+
+private:
+    std::istream& in;
+    int line;
+    int statementLine = 1;
+    int totalQubits;
+    std::map<std::string, std::pair<int, int>> registers;  // name -> (first qubit, size)
+    std::vector<int> frontier;                             // next free timestep of every qubit
+    std::vector<ParsedGate> gates;
+
+    // Reads up to the next ';', dropping // comments; braces end a statement too so that
+    // unsupported gate bodies are reported instead of misread
+    bool nextStatement(std::string& statement) {
+        statement.clear();
+        char c;
+        while (in.get(c)) {
+            if (c == '\n') {
+                ++line;
+            }
+            if (c == '/' && in.peek() == '/') {
+                std::string comment;
+                std::getline(in, comment);
+                ++line;
+                continue;
+            }
+            if (trim(statement).empty()) {
+                statementLine = line;
+            }
+            if (c == ';' || c == '{') {
+                if (c == '{') {
+                    statement += c;
+                }
+                return true;
+            }
+            statement += c;
+        }
+        if (!trim(statement).empty()) {
+            statementLine = line;
+            throw std::invalid_argument("QASM line " + std::to_string(line) + ": missing ';'");
+        }
+        return false;
+    }
+
+    void handle(const std::string& raw) {
+        const std::string statement = trim(raw);
+        if (statement.empty()) {
+            return;
+        }
+        std::size_t split = 0;
+        while (split < statement.size() && (std::isalnum(static_cast<unsigned char>(statement[split])) || statement[split] == '_')) {
+            ++split;
+        }
+        const std::string keyword = statement.substr(0, split);
+        const std::string rest = trim(statement.substr(split));
+
+        if (keyword == "OPENQASM" || keyword == "include") {
+            return;
+        }
+        if (keyword == "qreg") {
+            declareRegister(rest);
+            return;
+        }
+        if (keyword == "creg" || keyword == "measure") {
+            return;
+        }
+        if (keyword == "barrier") {
+            barrier(rest);
+            return;
+        }
+        if (keyword == "gate" || keyword == "opaque" || keyword == "if" || keyword == "reset") {
+            throw std::invalid_argument("'" + keyword + "' is not supported");
+        }
+
+        auto spec = gateTable().find(keyword);
+        if (spec == gateTable().end()) {
+            throw std::invalid_argument("Unknown gate '" + keyword + "'");
+        }
+
+        std::vector<double> angles;
+        std::string operandText = rest;
+        if (!rest.empty() && rest[0] == '(') {
+            int depth = 0;
+            std::size_t close = 0;
+            for (; close < rest.size(); ++close) {
+                depth += (rest[close] == '(') - (rest[close] == ')');
+                if (depth == 0) {
+                    break;
+                }
+            }
+            if (close == rest.size()) {
+                throw std::invalid_argument("Missing ')' after gate angles");
+            }
+            for (const std::string& item : splitList(rest.substr(1, close - 1))) {
+                angles.push_back(ExpressionParser(item).parse());
+            }
+            operandText = rest.substr(close + 1);
+        }
+        if (int(angles.size()) != spec->second.angles) {
+            throw std::invalid_argument("Gate '" + keyword + "' takes " + std::to_string(spec->second.angles) + " angles");
+        }
+
+        std::vector<std::vector<int>> operands;
+        for (const std::string& item : splitList(operandText)) {
+            operands.push_back(resolve(item));
+        }
+        const std::size_t arity = keyword == "swap" ? 2 : spec->second.controls + 1;
+        if (operands.size() != arity) {
+            throw std::invalid_argument("Gate '" + keyword + "' takes " + std::to_string(arity) + " qubits");
+        }
+
+        // A whole register as an operand applies the gate once per qubit, registers in lockstep
+        std::size_t repeat = 1;
+        for (const auto& operand : operands) {
+            if (operand.size() > 1) {
+                if (repeat > 1 && operand.size() != repeat) {
+                    throw std::invalid_argument("Register operands differ in size");
+                }
+                repeat = operand.size();
+            }
+        }
+        for (std::size_t r = 0; r < repeat; ++r) {
+            std::vector<int> qubits;
+            for (const auto& operand : operands) {
+                qubits.push_back(operand.size() == 1 ? operand[0] : operand[r]);
+            }
+            emit(keyword, spec->second, angles, qubits);
+        }
+    }
+
+    void declareRegister(const std::string& text) {
+        const std::size_t open = text.find('['), close = text.find(']');
+        if (open == std::string::npos || close == std::string::npos || close < open) {
+            throw std::invalid_argument("Expected qreg name[size]");
+        }
+        const std::string name = trim(text.substr(0, open));
+        const int size = std::stoi(text.substr(open + 1, close - open - 1));
+        if (size < 1 || registers.count(name)) {
+            throw std::invalid_argument("Bad or repeated register '" + name + "'");
+        }
+        registers[name] = {totalQubits, size};
+        totalQubits += size;
+        frontier.resize(totalQubits, 0);
+    }
+
+    // "q[3]" is one qubit, "q" every qubit of the register
+    std::vector<int> resolve(const std::string& operand) const {
+        const std::size_t open = operand.find('[');
+        const std::string name = trim(operand.substr(0, open));
+        auto reg = registers.find(name);
+        if (reg == registers.end()) {
+            throw std::invalid_argument("Unknown register '" + name + "'");
+        }
+        const int first = reg->second.first, size = reg->second.second;
+        if (open == std::string::npos) {
+            std::vector<int> all(size);
+            for (int i = 0; i < size; ++i) {
+                all[i] = first + i;
+            }
+            return all;
+        }
+        const int index = std::stoi(operand.substr(open + 1));
+        if (index < 0 || index >= size) {
+            throw std::invalid_argument("Qubit index out of range in '" + operand + "'");
+        }
+        return {first + index};
+    }
+
+    void barrier(const std::string& text) {
+        std::vector<int> qubits;
+        if (text.empty()) {
+            for (int q = 0; q < totalQubits; ++q) {
+                qubits.push_back(q);
+            }
+        } else {
+            for (const std::string& item : splitList(text)) {
+                for (int q : resolve(item)) {
+                    qubits.push_back(q);
+                }
+            }
+        }
+        int latest = 0;
+        for (int q : qubits) {
+            latest = std::max(latest, frontier[q]);
+        }
+        for (int q : qubits) {
+            frontier[q] = latest;
+        }
+    }
+
+    void place(GateId gate, std::vector<double> parameters, std::vector<int> controls, int target) {
+        int timestep = frontier[target];
+        for (int control : controls) {
+            if (control == target) {
+                throw std::invalid_argument("Control and target qubits must be distinct");
+            }
+            timestep = std::max(timestep, frontier[control]);
+        }
+        frontier[target] = timestep + 1;
+        for (int control : controls) {
+            frontier[control] = timestep + 1;
+        }
+        gates.push_back(ParsedGate{gate, timestep, target, std::move(controls), std::move(parameters)});
+    }
+
+    void emit(const std::string& keyword, const GateSpec& spec, std::vector<double> angles, const std::vector<int>& qubits) {
+        const double pi = std::acos(-1.0);
+        if (keyword == "id") {
+            return;
+        }
+        if (keyword == "swap") {
+            place(GateId::PauliX, {}, {qubits[0]}, qubits[1]);
+            place(GateId::PauliX, {}, {qubits[1]}, qubits[0]);
+            place(GateId::PauliX, {}, {qubits[0]}, qubits[1]);
+            return;
+        }
+        if (keyword == "sdg" || keyword == "tdg") {
+            angles = {keyword == "sdg" ? -pi / 2 : -pi / 4};
+        }
+        if (keyword == "u2") {
+            angles.insert(angles.begin(), pi / 2);
+        }
+        std::vector<int> controls(qubits.begin(), qubits.begin() + spec.controls);
+        place(spec.gate, std::move(angles), std::move(controls), qubits.back());
+    }
+};
+
+template <typename T>
+void writeValue(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(std::istream& in) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::invalid_argument("Binary circuit ends early");
+    }
+    return value;
+}
+}
+
+Circuit CircuitIO::readQasm(std::istream& in) {
+    return QasmParser(in).parse();
+}
+
+void CircuitIO::writeBinary(const Circuit& circuit, std::ostream& out) {
+    const std::vector<CircuitOp>& ops = circuit.getOperations();
+    out.write(binaryMagic, sizeof(binaryMagic));
+    writeValue<std::uint32_t>(out, circuit.getQubits());
+    writeValue<std::uint64_t>(out, ops.size());
+    for (const CircuitOp& op : ops) {
+        writeValue<std::uint8_t>(out, static_cast<std::uint8_t>(op.gate));
+        writeValue<std::uint8_t>(out, op.controlCount);
+        writeValue<std::uint8_t>(out, op.parameterCount);
+        writeValue<std::uint8_t>(out, 0);
+        writeValue<std::int32_t>(out, op.timestep);
+        writeValue<std::int32_t>(out, op.target);
+        for (int control : circuit.getControls(op)) {
+            writeValue<std::int32_t>(out, control);
+        }
+        for (double angle : circuit.getParameters(op)) {
+            writeValue<double>(out, angle);
+        }
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write binary circuit");
+    }
+}
+
+Circuit CircuitIO::readBinary(std::istream& in) {
+    char magic[sizeof(binaryMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0) {
+        throw std::invalid_argument("Not a binary circuit file");
+    }
+    Circuit circuit(readValue<std::uint32_t>(in));
+    const std::uint64_t count = readValue<std::uint64_t>(in);
+    std::vector<int> controls;
+    std::vector<double> parameters;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        const GateId gate = static_cast<GateId>(readValue<std::uint8_t>(in));
+        const int controlCount = readValue<std::uint8_t>(in);
+        const int parameterCount = readValue<std::uint8_t>(in);
+        readValue<std::uint8_t>(in);
+        const int timestep = readValue<std::int32_t>(in);
+        const int target = readValue<std::int32_t>(in);
+        controls.resize(controlCount);
+        for (int& control : controls) {
+            control = readValue<std::int32_t>(in);
+        }
+        parameters.resize(parameterCount);
+        for (double& angle : parameters) {
+            angle = readValue<double>(in);
+        }
+
+        // Records are in (timestep, target) order, so every add is an append
+        auto component = QuantumComponentFactory::create(gate, parameters);
+        if (controls.empty()) {
+            circuit.addGate(component, target, timestep);
+        } else {
+            circuit.addControlledGate(component, controls, target, timestep);
+        }
+    }
+    return circuit;
+}
+
+Circuit CircuitIO::readFile(const std::string& path) {
+    const bool binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".qcb") == 0;
+    std::ifstream in(path, binary ? std::ios::binary : std::ios::in);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    return binary ? readBinary(in) : readQasm(in);
+}
@@ -0,0 +1,258 @@
+#include "../h_files/CircuitOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+namespace {
+const double pi = std::acos(-1.0);
+constexpr double angleTolerance = 1e-12;
+constexpr int lookBack = 64;  // earlier gates sharing a qubit examined per gate
+
+// Single-qubit operator algebra a gate acts in on one of its qubits; gates in the same one commute
+enum class Axis { Z, X, Y, General };
+
+Axis targetAxis(GateId gate) {
+    switch (gate) {
+    case GateId::Identity:
+    case GateId::PauliZ:
+    case GateId::SGate:
+    case GateId::TGate:
+    case GateId::Phase:
+    case GateId::RotationZ:
+        return Axis::Z;
+    case GateId::PauliX:
+    case GateId::RotationX:
+        return Axis::X;
+    case GateId::PauliY:
+    case GateId::RotationY:
+        return Axis::Y;
+    default:
+        return Axis::General;
+    }
+}
+
+bool isFixedBlock(GateId gate) {
+    return gate == GateId::CNOTcontrol || gate == GateId::CNOTtarget || gate == GateId::Toffoli;
+}
+
+bool isPhase(GateId gate) {
+    return gate == GateId::PauliZ || gate == GateId::SGate || gate == GateId::TGate || gate == GateId::Phase;
+}
+
+bool isRotation(GateId gate) {
+    return gate == GateId::RotationX || gate == GateId::RotationY || gate == GateId::RotationZ;
+}
+
+bool isSelfInverse(GateId gate) {
+    return gate == GateId::Hadamard || gate == GateId::PauliX || gate == GateId::PauliY;
+}
+
+// lambda of diag(1, e^(i lambda))
+double phaseAngle(const PlacedGate& gate) {
+    switch (gate.gate) {
+    case GateId::PauliZ: return pi;
+    case GateId::SGate: return pi / 2;
+    case GateId::TGate: return pi / 4;
+    default: return gate.parameters[0];
+    }
+}
+
+// angle in [0, period), with values within the tolerance of a full period taken as 0
+double reduceAngle(double angle, double period) {
+    angle = std::fmod(angle, period);
+    if (angle < 0) {
+        angle += period;
+    }
+    return period - angle < angleTolerance ? 0 : angle;
+}
+
+bool near(double a, double b) {
+    return std::abs(a - b) < angleTolerance;
+}
+
+// Rewrites gate as diag(1, e^(i angle)), by name where one fits; false when that is the identity
+bool setPhase(PlacedGate& gate, double angle) {
+    angle = reduceAngle(angle, 2 * pi);
+    gate.parameters.clear();
+    if (angle < angleTolerance) {
+        return false;
+    } else if (near(angle, pi)) {
+        gate.gate = GateId::PauliZ;
+    } else if (near(angle, pi / 2)) {
+        gate.gate = GateId::SGate;
+    } else if (near(angle, pi / 4)) {
+        gate.gate = GateId::TGate;
+    } else {
+        gate.gate = GateId::Phase;
+        gate.parameters.push_back(angle);
+    }
+    return true;
+}
+
+struct Node {
+    PlacedGate gate;
+    std::vector<int> sortedControls;
+    bool alive = true;
+};
+
+bool touches(const Node& node, int qubit) {
+    return node.gate.target == qubit ||
+           std::binary_search(node.sortedControls.begin(), node.sortedControls.end(), qubit);
+}
+
+Axis axisOn(const Node& node, int qubit) {
+    return qubit == node.gate.target ? targetAxis(node.gate.gate) : Axis::Z;
+}
+
+bool commute(const Node& a, const Node& b) {
+    auto agrees = [&](int qubit) {
+        if (!touches(b, qubit)) {
+            return true;
+        }
+        const Axis axis = axisOn(a, qubit);
+        return axis != Axis::General && axis == axisOn(b, qubit);
+    };
+    return agrees(a.gate.target) && std::all_of(a.sortedControls.begin(), a.sortedControls.end(), agrees);
+}
+}
+
+std::ostream& operator<<(std::ostream& os, const OptimizationStatistics& stats) {
+    const std::size_t removed = stats.inputGates - stats.outputGates;
+    os << "Optimizer: " << stats.inputGates << " -> " << stats.outputGates << " gates";
+    if (stats.inputGates > 0) {
+        os << " (" << 100.0 * removed / stats.inputGates << "% fewer)";
+    }
+    os << ", " << stats.cancelledPairs << " inverse pairs, " << stats.mergedRotations << " merged rotations, "
+       << stats.removedIdentities << " identities removed, " << stats.commutations << " commutations";
+    return os;
+}
+
+std::vector<PlacedGate> CircuitOptimizer::optimize(const std::vector<PlacedGate>& gates, OptimizationStatistics* stats) {
+    OptimizationStatistics local;
+    local.inputGates = gates.size();
+
+    std::set<int> fixedTimesteps;
+    int qubits = 0;
+    std::vector<Node> nodes(gates.size());
+    for (std::size_t i = 0; i < gates.size(); ++i) {
+        nodes[i].gate = gates[i];
+        nodes[i].sortedControls = gates[i].controls;
+        std::sort(nodes[i].sortedControls.begin(), nodes[i].sortedControls.end());
+        qubits = std::max(qubits, gates[i].target + 1);
+        if (!gates[i].controls.empty()) {
+            qubits = std::max(qubits, nodes[i].sortedControls.back() + 1);
+        }
+        if (isFixedBlock(gates[i].gate)) {
+            fixedTimesteps.insert(gates[i].timestep);
+        }
+    }
+
+    // Live gates on each qubit that later gates may still reach, in execution order
+    std::vector<std::vector<std::size_t>> onQubit(qubits);
+    int lastFixed = -1;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        Node& node = nodes[i];
+        if (fixedTimesteps.count(node.gate.timestep)) {
+            if (node.gate.timestep != lastFixed) {
+                for (auto& list : onQubit) {
+                    list.clear();
+                }
+                lastFixed = node.gate.timestep;
+            }
+            continue;
+        }
+        if (node.gate.gate == GateId::Identity) {
+            node.alive = false;
+            ++local.removedIdentities;
+            continue;
+        }
+
+        std::vector<int> span(node.sortedControls);
+        span.push_back(node.gate.target);
+        std::vector<std::size_t> cursor(span.size());
+        for (std::size_t k = 0; k < span.size(); ++k) {
+            cursor[k] = onQubit[span[k]].size();
+        }
+
+        // Earlier gates on any of the gate's qubits, latest first
+        std::size_t passed = 0;
+        bool absorbed = false;
+        for (int examined = 0; examined < lookBack && !absorbed; ++examined) {
+            std::size_t latest = 0;
+            bool found = false;
+            for (std::size_t k = 0; k < span.size(); ++k) {
+                const auto& list = onQubit[span[k]];
+                while (cursor[k] > 0 && !nodes[list[cursor[k] - 1]].alive) {
+                    --cursor[k];
+                }
+                if (cursor[k] > 0 && (!found || list[cursor[k] - 1] > latest)) {
+                    latest = list[cursor[k] - 1];
+                    found = true;
+                }
+            }
+            if (!found) {
+                break;
+            }
+            for (std::size_t k = 0; k < span.size(); ++k) {
+                if (cursor[k] > 0 && onQubit[span[k]][cursor[k] - 1] == latest) {
+                    --cursor[k];
+                }
+            }
+
+            Node& earlier = nodes[latest];
+            if (earlier.gate.target == node.gate.target && earlier.sortedControls == node.sortedControls) {
+                const GateId a = earlier.gate.gate, b = node.gate.gate;
+                if (isSelfInverse(a) && a == b) {
+                    earlier.alive = node.alive = false;
+                    ++local.cancelledPairs;
+                    absorbed = true;
+                } else if (isPhase(a) && isPhase(b)) {
+                    node.alive = false;
+                    ++local.mergedRotations;
+                    if (!setPhase(earlier.gate, phaseAngle(earlier.gate) + phaseAngle(node.gate))) {
+                        earlier.alive = false;
+                        ++local.removedIdentities;
+                    }
+                    absorbed = true;
+                } else if (isRotation(a) && a == b) {
+                    // R(4 pi) is the identity; R(2 pi) = -I only up to a phase that matters once controlled
+                    node.alive = false;
+                    ++local.mergedRotations;
+                    const double angle = reduceAngle(earlier.gate.parameters[0] + node.gate.parameters[0], 4 * pi);
+                    earlier.gate.parameters[0] = angle;
+                    if (angle < angleTolerance) {
+                        earlier.alive = false;
+                        ++local.removedIdentities;
+                    }
+                    absorbed = true;
+                }
+                if (absorbed) {
+                    local.commutations += passed;
+                    break;
+                }
+            }
+            if (!commute(earlier, node)) {
+                break;
+            }
+            ++passed;
+        }
+
+        if (!absorbed) {
+            for (int qubit : span) {
+                onQubit[qubit].push_back(i);
+            }
+        }
+    }
+
+    std::vector<PlacedGate> result;
+    for (Node& node : nodes) {
+        if (node.alive) {
+            result.push_back(std::move(node.gate));
+        }
+    }
+    local.outputGates = result.size();
+    if (stats) {
+        *stats = local;
+    }
+    return result;
+}
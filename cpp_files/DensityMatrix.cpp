@@ -0,0 +1,120 @@
+#include "../h_files/DensityMatrix.h"
+#include "../h_files/MatrixExpression.h"
+
+#include <stdexcept>
+
+namespace {
+Matrix conjugate(const Matrix& m) {
+    return m.adjoint().transpose();
+}
+
+void checkSize(int qubits) {
+    if (qubits < 1 || 2 * qubits > 30) {
+        throw std::length_error("Density matrix for " + std::to_string(qubits) + " qubits does not fit in a Matrix");
+    }
+}
+}
+
+Matrix DensityMatrixSimulator::fromState(const Complex* amplitudes, int qubits) {
+    checkSize(qubits);
+    const std::size_t dimension = std::size_t(1) << qubits;
+    Matrix rho(int(dimension * dimension), 1);
+    Complex* out = rho.data();
+    for (std::size_t c = 0; c < dimension; ++c) {
+        const Complex conjugateColumn = amplitudes[c].conjugate();
+        for (std::size_t r = 0; r < dimension; ++r) {
+            out[r + (c << qubits)] = amplitudes[r] * conjugateColumn;
+        }
+    }
+    return rho;
+}
+
+Matrix DensityMatrixSimulator::toMatrix(const Complex* rho, int qubits) {
+    const int dimension = 1 << qubits;
+    Matrix result(dimension, dimension);
+    for (int r = 0; r < dimension; ++r) {
+        for (int c = 0; c < dimension; ++c) {
+            result(r + 1, c + 1) = rho[std::size_t(r) + (std::size_t(c) << qubits)];
+        }
+    }
+    return result;
+}
+
+void DensityMatrixSimulator::applyOperation(Complex* rho, int qubits, const GateOperation& op, ThreadPool* pool) {
+    StateVectorSimulator::applyOperation(rho, 2 * qubits, op, pool);
+
+    GateOperation columns{conjugate(op.matrix), op.targets, op.controls};
+    for (int& target : columns.targets) {
+        target += qubits;
+    }
+    for (int& control : columns.controls) {
+        control += qubits;
+    }
+    StateVectorSimulator::applyOperation(rho, 2 * qubits, columns, pool);
+}
+
+void DensityMatrixSimulator::applyChannel(Complex* rho, int qubits, const std::vector<Matrix>& kraus, int qubit, ThreadPool* pool) {
+    // Local index (column bit << 1) | row bit, so conj(K) takes the high bit
+    Matrix superoperator(4, 4);
+    for (const Matrix& k : kraus) {
+        superoperator = lazy(superoperator) + kron(conjugate(k), k);
+    }
+    StateVectorSimulator::applyMultiQubitGate(rho, 2 * qubits, superoperator, {qubit, qubit + qubits}, pool);
+}
+
+std::vector<double> DensityMatrixSimulator::probabilities(const Complex* rho, int qubits) {
+    const std::size_t dimension = std::size_t(1) << qubits;
+    std::vector<double> diagonal(dimension);
+    for (std::size_t i = 0; i < dimension; ++i) {
+        diagonal[i] = std::max(0.0, rho[i + (i << qubits)].get_real());
+    }
+    return diagonal;
+}
+
+int DensityMatrixSimulator::applyTrajectoryChannel(Complex* amplitudes, int qubits, const std::vector<Matrix>& kraus, int qubit,
+                                                   double uniform, ThreadPool* pool) {
+    // Reduced 2x2 density matrix of the qubit, one pass over the state
+    const std::size_t stride = std::size_t(1) << qubit;
+    const std::size_t size = std::size_t(1) << qubits;
+    double p00 = 0, p11 = 0;
+    Complex p10(0, 0);
+    for (std::size_t block = 0; block < size; block += 2 * stride) {
+        for (std::size_t i = block; i < block + stride; ++i) {
+            const Complex a0 = amplitudes[i], a1 = amplitudes[i + stride];
+            p00 += a0.get_real() * a0.get_real() + a0.get_imag() * a0.get_imag();
+            p11 += a1.get_real() * a1.get_real() + a1.get_imag() * a1.get_imag();
+            p10 = p10 + a1 * a0.conjugate();
+        }
+    }
+
+    // ||K psi||^2 = tr(K^dagger K rho_q); rounding can leave uniform past the last sum, in which
+    // case the last operator with nonzero weight is taken
+    int chosen = -1;
+    double weight = 0, cumulative = 0;
+    for (std::size_t k = 0; k < kraus.size(); ++k) {
+        const Matrix m = kraus[k].adjoint() * kraus[k];
+        const double w = m(1, 1).get_real() * p00 + m(2, 2).get_real() * p11 + 2 * (m(1, 2) * p10).get_real();
+        if (w <= 0) {
+            continue;
+        }
+        chosen = int(k);
+        weight = w;
+        cumulative += w;
+        if (uniform < cumulative) {
+            break;
+        }
+    }
+    if (chosen < 0) {
+        throw std::runtime_error("Every Kraus operator has zero weight on this state");
+    }
+
+    Matrix scaled = kraus[chosen];
+    const Complex norm(1 / std::sqrt(weight), 0);
+    for (int i = 1; i <= 2; ++i) {
+        for (int j = 1; j <= 2; ++j) {
+            scaled(i, j) = scaled(i, j) * norm;
+        }
+    }
+    StateVectorSimulator::applySingleQubitGate(amplitudes, qubits, scaled, qubit, pool);
+    return chosen;
+}
@@ -0,0 +1,273 @@
+#include "../h_files/Distributed.h"
+#include "../h_files/StateVector.h"
+
+#include <memory>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+namespace {
+const std::size_t exchangeChunk = std::size_t(1) << 16;  // amplitudes per pipelined message, 1 MiB
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// index j of the 2^(bits-1) states whose bit `bit` equals value
+std::size_t withBit(std::size_t j, int bit, std::size_t value) {
+    const std::size_t low = j & ((std::size_t(1) << bit) - 1);
+    return ((j >> bit) << (bit + 1)) | (value << bit) | low;
+}
+}
+
+std::ostream& operator<<(std::ostream& os, const DistributedStatistics& stats) {
+    os << "Distributed: " << stats.processes << " processes (" << stats.globalQubits << " global qubits), "
+       << stats.exchanges << " exchanges, " << stats.bytesExchanged / 1048576.0 << " MiB sent per process, compute "
+       << stats.computeSeconds << " s, exchange " << stats.exchangeSeconds << " s";
+    return os;
+}
+
+DistributedStateVector::DistributedStateVector(Transport& transport, int qubits, const Complex* initialSlice, ThreadPool* pool)
+: transport(transport), pool(pool), qubits(qubits), localQubits(0) {
+    const int processes = transport.size();
+    int globalQubits = 0;
+    while ((1 << globalQubits) < processes) {
+        ++globalQubits;
+    }
+    if ((1 << globalQubits) != processes) {
+        throw std::invalid_argument("Process count must be a power of two");
+    }
+    localQubits = qubits - globalQubits;
+    if (localQubits < 1) {
+        throw std::invalid_argument("More processes than the state can be split over");
+    }
+    local.assign(initialSlice, initialSlice + (std::size_t(1) << localQubits));
+    position.resize(qubits);
+    logicalAt.resize(qubits);
+    for (int q = 0; q < qubits; ++q) {
+        position[q] = logicalAt[q] = q;
+    }
+    stats.processes = processes;
+    stats.globalQubits = globalQubits;
+}
+
+DistributedStatistics DistributedStateVector::run(const std::vector<GateOperation>& operations) {
+    auto nextUse = [&](int logical, std::size_t after) {
+        for (std::size_t k = after; k < operations.size(); ++k) {
+            const std::vector<int>& targets = operations[k].targets;
+            if (std::find(targets.begin(), targets.end(), logical) != targets.end()) {
+                return k;
+            }
+        }
+        return operations.size();
+    };
+
+    for (std::size_t k = 0; k < operations.size(); ++k) {
+        const GateOperation& op = operations[k];
+        if (int(op.targets.size()) > localQubits) {
+            throw std::invalid_argument("Operation has more targets than each process has local qubits");
+        }
+        for (const std::vector<int>* list : {&op.targets, &op.controls}) {
+            for (int qubit : *list) {
+                if (qubit < 0 || qubit >= qubits) {
+                    throw std::out_of_range("Gate qubit out of range");
+                }
+            }
+        }
+
+        // Every rank takes the same decisions, so the swaps pair up without negotiation
+        for (int target : op.targets) {
+            if (position[target] < localQubits) {
+                continue;
+            }
+            int victim = -1;
+            std::size_t furthest = 0;
+            for (int low = 0; low < localQubits; ++low) {
+                if (std::find(op.targets.begin(), op.targets.end(), logicalAt[low]) != op.targets.end()) {
+                    continue;
+                }
+                const std::size_t use = nextUse(logicalAt[low], k);
+                if (victim < 0 || use > furthest) {
+                    victim = low;
+                    furthest = use;
+                }
+            }
+            const int global = position[target];
+            swapQubits(global, victim);
+            swapLog.emplace_back(global, victim);
+        }
+
+        GateOperation physical{op.matrix, op.targets, {}};
+        for (int& target : physical.targets) {
+            target = position[target];
+        }
+        bool applies = true;
+        for (int control : op.controls) {
+            const int bit = position[control];
+            if (bit < localQubits) {
+                physical.controls.push_back(bit);
+            } else if (!((transport.rank() >> (bit - localQubits)) & 1)) {
+                applies = false;
+            }
+        }
+        if (applies) {
+            const auto start = Clock::now();
+            StateVectorSimulator::applyOperation(local.data(), localQubits, physical, pool);
+            stats.computeSeconds += secondsSince(start);
+        }
+    }
+    return stats;
+}
+
+void DistributedStateVector::swapQubits(int global, int low) {
+    const auto start = Clock::now();
+    const int globalBit = global - localQubits;
+    const int partner = transport.rank() ^ (1 << globalBit);
+    // The rank holding global = 0 sends its low = 1 half, its partner the low = 0 half; the j-th
+    // amplitude sent by one side lands on the j-th amplitude sent by the other
+    const std::size_t sendValue = ((transport.rank() >> globalBit) & 1) ? 0 : 1;
+    const std::size_t half = std::size_t(1) << (localQubits - 1);
+    const std::size_t chunk = std::min(half, exchangeChunk);
+
+    std::vector<Complex> sendBuffer[2] = {std::vector<Complex>(chunk), std::vector<Complex>(chunk)};
+    std::vector<Complex> receiveBuffer[2] = {std::vector<Complex>(chunk), std::vector<Complex>(chunk)};
+    auto pack = [&](std::size_t first, std::size_t count, std::vector<Complex>& buffer) {
+        for (std::size_t j = 0; j < count; ++j) {
+            buffer[j] = local[withBit(first + j, low, sendValue)];
+        }
+    };
+    auto unpack = [&](std::size_t first, std::size_t count, const std::vector<Complex>& buffer) {
+        for (std::size_t j = 0; j < count; ++j) {
+            local[withBit(first + j, low, sendValue)] = buffer[j];
+        }
+    };
+
+    // Chunk c is packed while chunk c - 1 is on the wire; once c - 1 has arrived, c goes out
+    // and c - 1 is unpacked during its transfer. The chunks use alternate buffers, and c - 1 and
+    // c cover different amplitudes.
+    std::future<void> inFlight;
+    std::size_t previous = 0, previousCount = 0;
+    int slot = 0;
+    for (std::size_t first = 0; first < half; first += chunk) {
+        const std::size_t count = std::min(chunk, half - first);
+        pack(first, count, sendBuffer[slot]);
+        const bool arrived = inFlight.valid();
+        if (arrived) {
+            inFlight.get();
+        }
+        inFlight = std::async(std::launch::async, [&, slot, count] {
+            transport.exchange(partner, sendBuffer[slot].data(), receiveBuffer[slot].data(), count * sizeof(Complex));
+        });
+        if (arrived) {
+            unpack(previous, previousCount, receiveBuffer[1 - slot]);
+        }
+        previous = first;
+        previousCount = count;
+        slot = 1 - slot;
+    }
+    inFlight.get();
+    unpack(previous, previousCount, receiveBuffer[1 - slot]);
+
+    std::swap(logicalAt[global], logicalAt[low]);
+    position[logicalAt[global]] = global;
+    position[logicalAt[low]] = low;
+    ++stats.exchanges;
+    stats.bytesExchanged += half * sizeof(Complex);
+    stats.exchangeSeconds += secondsSince(start);
+}
+
+void DistributedStateVector::gather(Complex* output) {
+    for (auto it = swapLog.rbegin(); it != swapLog.rend(); ++it) {
+        swapQubits(it->first, it->second);
+    }
+    swapLog.clear();
+
+    const std::size_t bytes = local.size() * sizeof(Complex);
+    if (transport.rank() == 0) {
+        std::copy(local.begin(), local.end(), output);
+        for (int peer = 1; peer < transport.size(); ++peer) {
+            transport.receive(peer, output + peer * local.size(), bytes);
+        }
+    } else {
+        transport.send(0, local.data(), bytes);
+    }
+}
+
+DistributedStatistics DistributedStateVector::simulate(Complex* amplitudes, int qubits, const std::vector<GateOperation>& operations,
+                                                       int processes, TransportKind kind, int threadsPerProcess) {
+    if (processes < 1 || (processes & (processes - 1)) != 0 || (std::size_t(1) << qubits) < std::size_t(2 * processes)) {
+        throw std::invalid_argument("Process count must be a power of two with at least two amplitudes per process");
+    }
+    std::unique_ptr<Transport> transport;
+    if (kind == TransportKind::Tcp) {
+        transport = std::make_unique<TcpTransport>(processes);
+    } else {
+        transport = std::make_unique<SharedMemoryTransport>(processes);
+    }
+    const std::size_t slice = (std::size_t(1) << qubits) / processes;
+
+    // Buffered output would otherwise be flushed once per process
+    std::cout.flush();
+    std::vector<pid_t> workers;
+    for (int rank = 1; rank < processes; ++rank) {
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+        if (pid == 0) {
+            // The parent's thread pool does not survive the fork; workers start their own
+            int status = 0;
+            try {
+                transport->attach(rank);
+                std::unique_ptr<ThreadPool> workerPool;
+                if (threadsPerProcess != 1) {
+                    workerPool = std::make_unique<ThreadPool>(threadsPerProcess);
+                }
+                DistributedStateVector part(*transport, qubits, amplitudes + rank * slice, workerPool.get());
+                part.run(operations);
+                part.gather(nullptr);
+            } catch (const std::exception& error) {
+                std::cerr << "Rank " << rank << ": " << error.what() << std::endl;
+                status = 1;
+            }
+            ::_exit(status);
+        }
+        workers.push_back(pid);
+    }
+
+    DistributedStatistics stats;
+    try {
+        transport->attach(0);
+        std::unique_ptr<ThreadPool> rootPool;
+        if (threadsPerProcess != 1) {
+            rootPool = std::make_unique<ThreadPool>(threadsPerProcess);
+        }
+        DistributedStateVector part(*transport, qubits, amplitudes, rootPool.get());
+        stats = part.run(operations);
+        part.gather(amplitudes);
+    } catch (...) {
+        // The workers would wait for rank 0 forever
+        for (pid_t pid : workers) {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, nullptr, 0);
+        }
+        throw;
+    }
+
+    bool failed = false;
+    for (pid_t pid : workers) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    if (failed) {
+        throw std::runtime_error("A distributed worker process failed");
+    }
+    return stats;
+}
@@ -0,0 +1,135 @@
+#include "../h_files/GateFusion.h"
+
+#include <map>
+#include <algorithm>
+
+std::ostream& operator<<(std::ostream& os, const FusionStatistics& stats) {
+    os << "Gate fusion: " << stats.inputOperations << " operations -> " << stats.outputOperations
+       << " (" << stats.singleQubitMerges << " single-qubit merges, "
+       << stats.absorbedIntoWider << " absorbed into multi-qubit operations)";
+    return os;
+}
+
+FusionStatistics& FusionStatistics::operator+=(const FusionStatistics& other) {
+    inputOperations += other.inputOperations;
+    outputOperations += other.outputOperations;
+    singleQubitMerges += other.singleQubitMerges;
+    absorbedIntoWider += other.absorbedIntoWider;
+    return *this;
+}
+
+Matrix GateFusion::expandToTargets(const Matrix& gate, const std::vector<int>& from, const std::vector<int>& to) {
+    // position[i] is the bit of `to` that carries bit i of the gate's index
+    std::vector<int> position;
+    int fromMask = 0;
+    for (int qubit : from) {
+        auto it = std::find(to.begin(), to.end(), qubit);
+        if (it == to.end()) {
+            throw std::invalid_argument("Gate qubits are not a subset of the fused qubits");
+        }
+        position.push_back(it - to.begin());
+        fromMask |= 1 << position.back();
+    }
+
+    const int dimension = 1 << to.size();
+    auto gateIndex = [&](int index) {
+        int local = 0;
+        for (std::size_t bit = 0; bit < position.size(); ++bit) {
+            if (index & (1 << position[bit])) {
+                local |= 1 << bit;
+            }
+        }
+        return local;
+    };
+
+    Matrix result(dimension, dimension);
+    for (int row = 0; row < dimension; ++row) {
+        for (int col = 0; col < dimension; ++col) {
+            // Qubits the gate does not act on must be left unchanged
+            if ((row & ~fromMask) == (col & ~fromMask)) {
+                result(row + 1, col + 1) = gate(gateIndex(row) + 1, gateIndex(col) + 1);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<GateOperation> GateFusion::fuse(const std::vector<GateOperation>& operations, int maxFusedQubits,
+                                            FusionStatistics* stats) {
+    if (maxFusedQubits < 1) {
+        throw std::invalid_argument("Fusion needs at least one qubit per operation");
+    }
+
+    std::vector<GateOperation> fused;
+    std::vector<bool> removed;
+    std::map<int, std::size_t> lastOnQubit;  // qubit -> index in `fused` of the last operation touching it
+    FusionStatistics counts;
+    counts.inputOperations = operations.size();
+
+    auto record = [&](std::size_t index) {
+        for (int qubit : fused[index].targets) {
+            lastOnQubit[qubit] = index;
+        }
+        for (int qubit : fused[index].controls) {
+            lastOnQubit[qubit] = index;
+        }
+    };
+
+    for (const GateOperation& op : operations) {
+        if (op.targets.empty()) {
+            continue;
+        }
+
+        // The last operation on each of op's qubits can absorb op when it covers all of them:
+        // nothing after it touches those qubits, so op can be moved up next to it.
+        // Controlled operations are never merged; they only act as barriers on their qubits.
+        auto last = lastOnQubit.find(op.targets[0]);
+        if (last != lastOnQubit.end() && op.controls.empty()) {
+            GateOperation& previous = fused[last->second];
+            bool covers = previous.controls.empty() && previous.targets.size() <= std::size_t(maxFusedQubits);
+            for (int qubit : op.targets) {
+                auto it = lastOnQubit.find(qubit);
+                covers = covers && it != lastOnQubit.end() && it->second == last->second;
+            }
+            if (covers) {
+                previous.matrix = expandToTargets(op.matrix, op.targets, previous.targets) * previous.matrix;
+                if (previous.targets.size() == 1) {
+                    ++counts.singleQubitMerges;
+                } else {
+                    ++counts.absorbedIntoWider;
+                }
+                continue;
+            }
+        }
+
+        GateOperation next = op;
+        // A wider gate also swallows pending single-qubit gates on its qubits
+        if (op.controls.empty() && op.targets.size() > 1 && op.targets.size() <= std::size_t(maxFusedQubits)) {
+            for (int qubit : op.targets) {
+                auto it = lastOnQubit.find(qubit);
+                if (it != lastOnQubit.end() && !removed[it->second] && fused[it->second].targets.size() == 1
+                    && fused[it->second].controls.empty()) {
+                    next.matrix = next.matrix * expandToTargets(fused[it->second].matrix, fused[it->second].targets, next.targets);
+                    removed[it->second] = true;
+                    ++counts.absorbedIntoWider;
+                }
+            }
+        }
+
+        fused.push_back(std::move(next));
+        removed.push_back(false);
+        record(fused.size() - 1);
+    }
+
+    std::vector<GateOperation> result;
+    for (std::size_t i = 0; i < fused.size(); ++i) {
+        if (!removed[i]) {
+            result.push_back(std::move(fused[i]));
+        }
+    }
+    counts.outputOperations = result.size();
+    if (stats) {
+        *stats = counts;
+    }
+    return result;
+}
@@ -1,48 +1,150 @@
 #include "../h_files/Gates.h"
 
+namespace {
+// Matrix entries known at compile time
+constexpr double invSqrt2 = 0.70710678118654752440;   // 1/sqrt(2)
+constexpr double cosPiOver4 = 0.70710678118654752440; // cos(pi/4) = sin(pi/4)
+
+// Builds a size x size matrix from its entries in row-major order
+Matrix makeMatrix(int size, std::initializer_list<Complex> entries) {
+    Matrix result(size, size);
+    int index = 0;
+    for (const Complex& entry : entries) {
+        result.data()[index++] = entry;
+    }
+    return result;
+}
+}
+
+Matrix QuantumComponent::getMatrix() const {
+    return getMatrixRef();
+}
+
+std::vector<double> QuantumComponent::getParameters() const {
+    return {};
+}
+
 std::shared_ptr<QuantumComponent> QuantumComponentFactory::create(const std::string& name) {
     if (name == "Hadamard") {
-        return std::make_shared<HadamardGate>();
+        return create(GateId::Hadamard);
     }
     else if (name == "Pauli-X") {
-        return std::make_shared<PauliXGate>();
+        return create(GateId::PauliX);
     }
     else if (name == "Pauli-Y") {
-        return std::make_shared<PauliYGate>();
+        return create(GateId::PauliY);
     }
     else if (name == "Pauli-Z") {
-        return std::make_shared<PauliZGate>();
+        return create(GateId::PauliZ);
     }
     else if (name == "CNOTcontrol") {
-        return std::make_shared<CNOTcontrol>();
+        return create(GateId::CNOTcontrol);
     }
     else if (name == "CNOTtarget") {
-        return std::make_shared<CNOTtarget>();
+        return create(GateId::CNOTtarget);
     }
     else if (name == "Identity") {
-        return std::make_shared<Identity>();
+        return create(GateId::Identity);
     }
     else if (name == "S-Gate") {
-        return std::make_shared<SGate>();
+        return create(GateId::SGate);
     }
     else if (name == "T-Gate") {
-        return std::make_shared<TGate>();
+        return create(GateId::TGate);
     }
     else if (name == "Toffoli") {
-        return std::make_shared<ToffoliGatetarget>();
+        return create(GateId::Toffoli);
     }
     else {
         throw std::invalid_argument("Invalid gate name");
     }
 }
 
-Matrix HadamardGate::getMatrix() const {
-    Matrix H(2, 2);
-    double h = 1.0 / std::sqrt(2);
-    H(1, 1) = Complex(h, 0);
-    H(1, 2) = Complex(h, 0);
-    H(2, 1) = Complex(h, 0);
-    H(2, 2) = Complex(-h, 0);
+std::shared_ptr<QuantumComponent> QuantumComponentFactory::create(GateId id) {
+    // One shared instance per gate type
+    static const std::shared_ptr<QuantumComponent> hadamard = std::make_shared<HadamardGate>();
+    static const std::shared_ptr<QuantumComponent> pauliX = std::make_shared<PauliXGate>();
+    static const std::shared_ptr<QuantumComponent> pauliY = std::make_shared<PauliYGate>();
+    static const std::shared_ptr<QuantumComponent> pauliZ = std::make_shared<PauliZGate>();
+    static const std::shared_ptr<QuantumComponent> cnotControl = std::make_shared<CNOTcontrol>();
+    static const std::shared_ptr<QuantumComponent> cnotTarget = std::make_shared<CNOTtarget>();
+    static const std::shared_ptr<QuantumComponent> identity = std::make_shared<Identity>();
+    static const std::shared_ptr<QuantumComponent> sGate = std::make_shared<SGate>();
+    static const std::shared_ptr<QuantumComponent> tGate = std::make_shared<TGate>();
+    static const std::shared_ptr<QuantumComponent> toffoli = std::make_shared<ToffoliGatetarget>();
+
+    switch (id) {
+        case GateId::Identity: return identity;
+        case GateId::Hadamard: return hadamard;
+        case GateId::PauliX: return pauliX;
+        case GateId::PauliY: return pauliY;
+        case GateId::PauliZ: return pauliZ;
+        case GateId::CNOTcontrol: return cnotControl;
+        case GateId::CNOTtarget: return cnotTarget;
+        case GateId::Toffoli: return toffoli;
+        case GateId::SGate: return sGate;
+        case GateId::TGate: return tGate;
+        default: break;
+    }
+    throw std::invalid_argument("Gate needs parameters");
+}
+
+std::shared_ptr<QuantumComponent> QuantumComponentFactory::create(const std::string& name, const std::vector<double>& parameters) {
+    if (name == "Rx") {
+        return create(GateId::RotationX, parameters);
+    }
+    else if (name == "Ry") {
+        return create(GateId::RotationY, parameters);
+    }
+    else if (name == "Rz") {
+        return create(GateId::RotationZ, parameters);
+    }
+    else if (name == "Phase") {
+        return create(GateId::Phase, parameters);
+    }
+    else if (name == "U3") {
+        return create(GateId::U3, parameters);
+    }
+    else if (parameters.empty()) {
+        return create(name);
+    }
+    else {
+        throw std::invalid_argument("Gate " + name + " takes no parameters");
+    }
+}
+
+std::shared_ptr<QuantumComponent> QuantumComponentFactory::create(GateId id, const std::vector<double>& parameters) {
+    std::size_t expected = 0;
+    switch (id) {
+        case GateId::RotationX:
+        case GateId::RotationY:
+        case GateId::RotationZ:
+        case GateId::Phase:
+            expected = 1;
+            break;
+        case GateId::U3:
+            expected = 3;
+            break;
+        default:
+            break;
+    }
+    if (parameters.size() != expected) {
+        throw std::invalid_argument("Wrong number of gate parameters");
+    }
+
+    switch (id) {
+        case GateId::RotationX: return std::make_shared<RxGate>(parameters[0]);
+        case GateId::RotationY: return std::make_shared<RyGate>(parameters[0]);
+        case GateId::RotationZ: return std::make_shared<RzGate>(parameters[0]);
+        case GateId::Phase: return std::make_shared<PhaseGate>(parameters[0]);
+        case GateId::U3: return std::make_shared<U3Gate>(parameters[0], parameters[1], parameters[2]);
+        default: return create(id);
+    }
+}
+
+const Matrix& HadamardGate::getMatrixRef() const {
+    static const Matrix H = makeMatrix(2, {Complex(invSqrt2, 0), Complex(invSqrt2, 0),
+                                          Complex(invSqrt2, 0), Complex(-invSqrt2, 0)});
     return H;
 }
 
@@ -50,10 +152,13 @@ std::string HadamardGate::getName() const {
     return "Hadamard";
 }
 
-Matrix PauliXGate::getMatrix() const {
-    Matrix X(2, 2);
-    X(1, 2) = Complex(1, 0);
-    X(2, 1) = Complex(1, 0);
+GateId HadamardGate::getId() const {
+    return GateId::Hadamard;
+}
+
+const Matrix& PauliXGate::getMatrixRef() const {
+    static const Matrix X = makeMatrix(2, {Complex(0, 0), Complex(1, 0),
+                                          Complex(1, 0), Complex(0, 0)});
     return X;
 }
 
@@ -61,10 +166,13 @@ std::string PauliXGate::getName() const {
     return "Pauli-X";
 }
 
-Matrix PauliYGate::getMatrix() const {
-    Matrix Y(2, 2);
-    Y(1, 2) = Complex(0, -1);
-    Y(2, 1) = Complex(0, 1);
+GateId PauliXGate::getId() const {
+    return GateId::PauliX;
+}
+
+const Matrix& PauliYGate::getMatrixRef() const {
+    static const Matrix Y = makeMatrix(2, {Complex(0, 0), Complex(0, -1),
+                                          Complex(0, 1), Complex(0, 0)});
     return Y;
 }
 
@@ -72,10 +180,13 @@ std::string PauliYGate::getName() const {
     return "Pauli-Y";
 }
 
-Matrix PauliZGate::getMatrix() const {
-    Matrix Z(2, 2);
-    Z(1, 1) = Complex(1, 0);
-    Z(2, 2) = Complex(-1, 0);
+GateId PauliYGate::getId() const {
+    return GateId::PauliY;
+}
+
+const Matrix& PauliZGate::getMatrixRef() const {
+    static const Matrix Z = makeMatrix(2, {Complex(1, 0), Complex(0, 0),
+                                          Complex(0, 0), Complex(-1, 0)});
     return Z;
 }
 
@@ -83,9 +194,12 @@ std::string PauliZGate::getName() const {
     return "Pauli-Z";
 }
 
-Matrix CNOTcontrol::getMatrix() const {
-    Matrix I(1, 1);
-    I(1, 1) = Complex(1, 0);
+GateId PauliZGate::getId() const {
+    return GateId::PauliZ;
+}
+
+const Matrix& CNOTcontrol::getMatrixRef() const {
+    static const Matrix I = makeMatrix(1, {Complex(1, 0)});
     return I;
 }
 
@@ -93,12 +207,15 @@ std::string CNOTcontrol::getName() const {
     return "CNOTcontrol";
 }
 
-Matrix CNOTtarget::getMatrix() const {
-    Matrix C(4, 4);
-    C(1, 1) = Complex(1, 0);
-    C(2, 2) = Complex(1, 0);
-    C(3,4) = Complex(1, 0);
-    C(4, 3) = Complex(1, 0);
+GateId CNOTcontrol::getId() const {
+    return GateId::CNOTcontrol;
+}
+
+const Matrix& CNOTtarget::getMatrixRef() const {
+    static const Matrix C = makeMatrix(4, {Complex(1, 0), Complex(0, 0), Complex(0, 0), Complex(0, 0),
+                                          Complex(0, 0), Complex(1, 0), Complex(0, 0), Complex(0, 0),
+                                          Complex(0, 0), Complex(0, 0), Complex(0, 0), Complex(1, 0),
+                                          Complex(0, 0), Complex(0, 0), Complex(1, 0), Complex(0, 0)});
     return C;
 }
 
@@ -106,10 +223,13 @@ std::string CNOTtarget::getName() const {
     return "CNOTtarget";
 }
 
-Matrix Identity::getMatrix() const {
-    Matrix I(2, 2);
-    I(1, 1) = Complex(1, 0);
-    I(2, 2) = Complex(1, 0);
+GateId CNOTtarget::getId() const {
+    return GateId::CNOTtarget;
+}
+
+const Matrix& Identity::getMatrixRef() const {
+    static const Matrix I = makeMatrix(2, {Complex(1, 0), Complex(0, 0),
+                                          Complex(0, 0), Complex(1, 0)});
     return I;
 }
 
@@ -117,10 +237,13 @@ std::string Identity::getName() const {
     return ".";
 }
 
-Matrix SGate::getMatrix() const {
-    Matrix S(2, 2);
-    S(1, 1) = Complex(1, 0);
-    S(2, 2) = Complex(0, 1);  // i
+GateId Identity::getId() const {
+    return GateId::Identity;
+}
+
+const Matrix& SGate::getMatrixRef() const {
+    static const Matrix S = makeMatrix(2, {Complex(1, 0), Complex(0, 0),
+                                          Complex(0, 0), Complex(0, 1)});  // i
     return S;
 }
 
@@ -128,10 +251,13 @@ std::string SGate::getName() const {
     return "S-Gate";
 }
 
-Matrix TGate::getMatrix() const {
-    Matrix T(2, 2);
-    T(1, 1) = Complex(1, 0);
-    T(2, 2) = Complex(std::cos(M_PI/4), std::sin(M_PI/4));  // e^(iπ/4)
+GateId SGate::getId() const {
+    return GateId::SGate;
+}
+
+const Matrix& TGate::getMatrixRef() const {
+    static const Matrix T = makeMatrix(2, {Complex(1, 0), Complex(0, 0),
+                                          Complex(0, 0), Complex(cosPiOver4, cosPiOver4)});  // e^(i*pi/4)
     return T;
 }
 
@@ -139,16 +265,20 @@ std::string TGate::getName() const {
     return "T-Gate";
 }
 
-Matrix ToffoliGatetarget::getMatrix() const {
-    Matrix Toffoli(8, 8);
-    Toffoli(1, 1) = Complex(1, 0);
-    Toffoli(2, 2) = Complex(1, 0);
-    Toffoli(3, 3) = Complex(1, 0);
-    Toffoli(4, 4) = Complex(1, 0);
-    Toffoli(5, 5) = Complex(1, 0);
-    Toffoli(6, 6) = Complex(1, 0);
-    Toffoli(7, 8) = Complex(1, 0);
-    Toffoli(8, 7) = Complex(1, 0);
+GateId TGate::getId() const {
+    return GateId::TGate;
+}
+
+const Matrix& ToffoliGatetarget::getMatrixRef() const {
+    static const Matrix Toffoli = [] {
+        // Identity with the last two basis states swapped
+        Matrix result = Matrix::identityMatrix(8);
+        result(7, 7) = Complex(0, 0);
+        result(8, 8) = Complex(0, 0);
+        result(7, 8) = Complex(1, 0);
+        result(8, 7) = Complex(1, 0);
+        return result;
+    }();
     return Toffoli;
 }
 
@@ -156,6 +286,10 @@ std::string ToffoliGatetarget::getName() const {
     return "Toffoli";
 }
 
+GateId ToffoliGatetarget::getId() const {
+    return GateId::Toffoli;
+}
+
 std::shared_ptr<QuantumComponent> HadamardGate::clone() const {
     return std::make_shared<HadamardGate>(*this);
 }
@@ -196,5 +330,155 @@ std::shared_ptr<QuantumComponent> ToffoliGatetarget::clone() const {
     return std::make_shared<ToffoliGatetarget>(*this);
 }
 
- 
+ParameterizedGate::ParameterizedGate(std::vector<double> values, Matrix gateMatrix)
+: parameters(std::move(values)), matrix(std::move(gateMatrix)) {}
+
+const Matrix& ParameterizedGate::getMatrixRef() const {
+    return matrix;
+}
+
+std::vector<double> ParameterizedGate::getParameters() const {
+    return parameters;
+}
+
+RxGate::RxGate(double theta)
+: ParameterizedGate({theta}, makeMatrix(2, {Complex(std::cos(theta / 2), 0), Complex(0, -std::sin(theta / 2)),
+                                            Complex(0, -std::sin(theta / 2)), Complex(std::cos(theta / 2), 0)})) {}
+
+std::string RxGate::getName() const {
+    return "Rx";
+}
+
+GateId RxGate::getId() const {
+    return GateId::RotationX;
+}
+
+std::shared_ptr<QuantumComponent> RxGate::clone() const {
+    return std::make_shared<RxGate>(*this);
+}
+
+Matrix RxGate::getDerivative(int index) const {
+    if (index != 0) {
+        throw std::out_of_range("Rx has one parameter");
+    }
+    const double c = std::cos(parameters[0] / 2) / 2, s = std::sin(parameters[0] / 2) / 2;
+    return makeMatrix(2, {Complex(-s, 0), Complex(0, -c),
+                          Complex(0, -c), Complex(-s, 0)});
+}
+
+RyGate::RyGate(double theta)
+: ParameterizedGate({theta}, makeMatrix(2, {Complex(std::cos(theta / 2), 0), Complex(-std::sin(theta / 2), 0),
+                                            Complex(std::sin(theta / 2), 0), Complex(std::cos(theta / 2), 0)})) {}
+
+std::string RyGate::getName() const {
+    return "Ry";
+}
+
+GateId RyGate::getId() const {
+    return GateId::RotationY;
+}
+
+std::shared_ptr<QuantumComponent> RyGate::clone() const {
+    return std::make_shared<RyGate>(*this);
+}
+
+Matrix RyGate::getDerivative(int index) const {
+    if (index != 0) {
+        throw std::out_of_range("Ry has one parameter");
+    }
+    const double c = std::cos(parameters[0] / 2) / 2, s = std::sin(parameters[0] / 2) / 2;
+    return makeMatrix(2, {Complex(-s, 0), Complex(-c, 0),
+                          Complex(c, 0), Complex(-s, 0)});
+}
+
+RzGate::RzGate(double theta)
+: ParameterizedGate({theta}, makeMatrix(2, {Complex(std::cos(theta / 2), -std::sin(theta / 2)), Complex(0, 0),
+                                            Complex(0, 0), Complex(std::cos(theta / 2), std::sin(theta / 2))})) {}
+
+std::string RzGate::getName() const {
+    return "Rz";
+}
+
+GateId RzGate::getId() const {
+    return GateId::RotationZ;
+}
+
+std::shared_ptr<QuantumComponent> RzGate::clone() const {
+    return std::make_shared<RzGate>(*this);
+}
+
+Matrix RzGate::getDerivative(int index) const {
+    if (index != 0) {
+        throw std::out_of_range("Rz has one parameter");
+    }
+    // d/dtheta e^(-+i theta/2) = -+(i/2) e^(-+i theta/2)
+    const double c = std::cos(parameters[0] / 2) / 2, s = std::sin(parameters[0] / 2) / 2;
+    return makeMatrix(2, {Complex(-s, -c), Complex(0, 0),
+                          Complex(0, 0), Complex(-s, c)});
+}
+
+PhaseGate::PhaseGate(double lambda)
+: ParameterizedGate({lambda}, makeMatrix(2, {Complex(1, 0), Complex(0, 0),
+                                             Complex(0, 0), Complex(std::cos(lambda), std::sin(lambda))})) {}
+
+std::string PhaseGate::getName() const {
+    return "Phase";
+}
+
+GateId PhaseGate::getId() const {
+    return GateId::Phase;
+}
+
+std::shared_ptr<QuantumComponent> PhaseGate::clone() const {
+    return std::make_shared<PhaseGate>(*this);
+}
 
+Matrix PhaseGate::getDerivative(int index) const {
+    if (index != 0) {
+        throw std::out_of_range("Phase has one parameter");
+    }
+    return makeMatrix(2, {Complex(0, 0), Complex(0, 0),
+                          Complex(0, 0), Complex(-std::sin(parameters[0]), std::cos(parameters[0]))});
+}
+
+U3Gate::U3Gate(double theta, double phi, double lambda)
+: ParameterizedGate({theta, phi, lambda}, [&] {
+      const double c = std::cos(theta / 2), s = std::sin(theta / 2);
+      return makeMatrix(2, {Complex(c, 0), Complex(-std::cos(lambda) * s, -std::sin(lambda) * s),
+                            Complex(std::cos(phi) * s, std::sin(phi) * s),
+                            Complex(std::cos(phi + lambda) * c, std::sin(phi + lambda) * c)});
+  }()) {}
+
+std::string U3Gate::getName() const {
+    return "U3";
+}
+
+GateId U3Gate::getId() const {
+    return GateId::U3;
+}
+
+std::shared_ptr<QuantumComponent> U3Gate::clone() const {
+    return std::make_shared<U3Gate>(*this);
+}
+
+Matrix U3Gate::getDerivative(int index) const {
+    const double theta = parameters[0], phi = parameters[1], lambda = parameters[2];
+    const double c = std::cos(theta / 2), s = std::sin(theta / 2);
+    const Complex eLambda(std::cos(lambda), std::sin(lambda));
+    const Complex ePhi(std::cos(phi), std::sin(phi));
+    const Complex eBoth(std::cos(phi + lambda), std::sin(phi + lambda));
+    const Complex i(0, 1);
+    const Complex zero(0, 0);
+
+    if (index == 0) {
+        return makeMatrix(2, {Complex(-s / 2, 0), eLambda * Complex(-c / 2, 0),
+                              ePhi * Complex(c / 2, 0), eBoth * Complex(-s / 2, 0)});
+    } else if (index == 1) {
+        return makeMatrix(2, {zero, zero,
+                              i * ePhi * Complex(s, 0), i * eBoth * Complex(c, 0)});
+    } else if (index == 2) {
+        return makeMatrix(2, {zero, i * eLambda * Complex(-s, 0),
+                              zero, i * eBoth * Complex(c, 0)});
+    }
+    throw std::out_of_range("U3 has three parameters");
+}
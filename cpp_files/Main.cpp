@@ -1,18 +1,189 @@
 #include <iostream>
-#include <memory> 
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include "../h_files/Complex.h"
 #include "../h_files/Matrix.h"
 #include "../h_files/Gates.h"
 #include "../h_files/Circuit.h"
+#include "../h_files/CircuitIO.h"
+
+namespace {
+void printUsage() {
+    std::cout << "Usage: my_executable [options] <circuit file or directory>...\n"
+                 "  Runs every .qasm and .qcb file back to back; with no arguments the interactive builder starts.\n"
+                 "  --threads N      worker threads for the state vector kernels (0 = all cores, default 1)\n"
+                 "  --fusion K       fuse gates into operations of up to K qubits (0-3, default 1)\n"
+                 "  --shots N        sample N shots from each final state and print the most frequent outcome\n"
+                 "  --precision P    amplitude precision: double (default), single or mixed\n"
+                 "  --mode M         statevector (default), automatic (Clifford circuits on a stabilizer tableau), stabilizer or mps\n"
+                 "  --bond D         maximum bond dimension in mps mode (default 64)\n"
+                 "  --optimize       cancel inverse gate pairs and merge phase gates and rotations before running\n"
+                 "  --fidelity       with single or mixed precision, also run in double and print the fidelity\n"
+                 "  --write-binary   also save each QASM input, as read, as a .qcb file next to it\n";
+}
+
+std::vector<std::string> collectFiles(const std::vector<std::string>& paths) {
+    std::vector<std::string> files;
+    for (const std::string& path : paths) {
+        if (std::filesystem::is_directory(path)) {
+            std::vector<std::string> entries;
+            for (const auto& entry : std::filesystem::directory_iterator(path)) {
+                const std::string extension = entry.path().extension().string();
+                if (entry.is_regular_file() && (extension == ".qasm" || extension == ".qcb")) {
+                    entries.push_back(entry.path().string());
+                }
+            }
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        } else {
+            files.push_back(path);
+        }
+    }
+    return files;
+}
+
+int runBatch(int argc, char* argv[]) {
+    int threads = 1, fusion = 1, bond = 64;
+    std::uint64_t shots = 0;
+    bool writeBinary = false, checkFidelity = false, optimize = false;
+    Precision precision = Precision::Double;
+    SimulationMode mode = SimulationMode::StateVector;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--threads" || arg == "--fusion" || arg == "--shots" || arg == "--bond") && i + 1 < argc) {
+            const std::string value = argv[++i];
+            if (arg == "--threads") threads = std::stoi(value);
+            else if (arg == "--fusion") fusion = std::stoi(value);
+            else if (arg == "--bond") bond = std::stoi(value);
+            else shots = std::stoull(value);
+        } else if (arg == "--precision" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            if (value == "double") precision = Precision::Double;
+            else if (value == "single") precision = Precision::Single;
+            else if (value == "mixed") precision = Precision::Mixed;
+            else {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--mode" && i + 1 < argc) {
+            const std::string value = argv[++i];
+            if (value == "statevector") mode = SimulationMode::StateVector;
+            else if (value == "automatic") mode = SimulationMode::Automatic;
+            else if (value == "stabilizer") mode = SimulationMode::Stabilizer;
+            else if (value == "mps") mode = SimulationMode::MatrixProductState;
+            else {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--optimize") {
+            optimize = true;
+        } else if (arg == "--fidelity") {
+            checkFidelity = true;
+        } else if (arg == "--write-binary") {
+            writeBinary = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    const std::vector<std::string> files = collectFiles(paths);
+    if (files.empty()) {
+        std::cerr << "No circuit files found\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    double parseSeconds = 0, runSeconds = 0;
+    int completed = 0, failed = 0;
+    for (const std::string& file : files) {
+        try {
+            const auto start = Clock::now();
+            Circuit circuit = CircuitIO::readFile(file);
+            // The .qcb holds the circuit as read, before --optimize rewrites it
+            if (writeBinary && std::filesystem::path(file).extension() != ".qcb") {
+                std::ofstream out(std::filesystem::path(file).replace_extension(".qcb"), std::ios::binary);
+                CircuitIO::writeBinary(circuit, out);
+            }
+            const auto parsed = Clock::now();
+
+            circuit.setVerbose(false);
+            circuit.setThreadCount(threads);
+            circuit.setGateFusion(fusion);
+            circuit.setPrecision(precision);
+            circuit.setSimulationMode(mode);
+            circuit.setMaxBondDimension(bond);
+            circuit.setFidelityCheck(checkFidelity);
+            OptimizationStatistics optimized;
+            if (optimize) {
+                optimized = circuit.optimize();
+            }
+            circuit.applyCircuit();
+            const auto finished = Clock::now();
+
+            parseSeconds += std::chrono::duration<double>(parsed - start).count();
+            runSeconds += std::chrono::duration<double>(finished - parsed).count();
+            ++completed;
+
+            std::cout << file << ": " << circuit.getQubits() << " qubits, " << circuit.getOperations().size()
+                      << " gates, " << circuit.getTimesteps() << " timesteps, "
+                      << std::chrono::duration<double, std::milli>(finished - start).count() << " ms";
+            if (optimize) {
+                std::cout << ", " << optimized.inputGates - optimized.outputGates << " gates optimized away";
+            }
+            if (checkFidelity && precision != Precision::Double) {
+                std::cout << ", fidelity " << circuit.getFidelity();
+            }
+            if (mode == SimulationMode::MatrixProductState) {
+                const MPSStatistics mps = circuit.getMPSStatistics();
+                std::cout << ", max bond " << mps.maxBond << ", truncation error " << mps.discardedWeight;
+            }
+            if (shots > 0) {
+                const MeasurementCounts counts = circuit.sample(shots);
+                auto best = std::max_element(counts.begin(), counts.end(),
+                                             [](const auto& a, const auto& b) { return a.second < b.second; });
+                std::cout << ", most frequent " << best->first << " (" << best->second << "/" << shots << ")";
+            }
+            std::cout << '\n';
+        } catch (const std::exception& error) {
+            ++failed;
+            std::cerr << file << ": " << error.what() << '\n';
+        }
+    }
+
+    const double total = parseSeconds + runSeconds;
+    std::cout << "\n" << completed << " circuits in " << total << " s (parse " << parseSeconds << " s, simulate "
+              << runSeconds << " s): " << (total > 0 ? completed / total : 0.0) << " circuits/sec";
+    if (failed > 0) {
+        std::cout << ", " << failed << " failed";
+    }
+    std::cout << std::endl;
+    return failed > 0 ? 1 : 0;
+}
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runBatch(argc, argv);
+    }
 
-int main() {
-    
     std::cout << "\n" "Welcome to the Quantum Circuit Simulator!\n"
             "You can create your circuits by declaring them. While this function is designed to enhance user functionality, "
             "it's not necessary to use it for basic operations. Feel free to explore all the gates defined in the 'gates.h' file. "
             "Enjoy your quantum computing journey!" << std::endl;
 
-    //Example 2 qubit circuit. 
+    //Example 2 qubit circuit.
     Circuit circuit(2);
 
     circuit.configureCircuit();
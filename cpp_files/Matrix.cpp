@@ -1,50 +1,178 @@
 #include "../h_files/Matrix.h"
+#include "../h_files/ThreadPool.h"
+#include "../h_files/SimdKernels.h"
+#include "../h_files/MatrixAllocator.h"
+
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+// Block sizes chosen so a row block of the result plus one panel of each operand stay in L2
+const int rowBlock = 32;
+const int innerBlock = 128;
+const int columnBlock = 512;
+
+// std::vector allocator drawing on the MatrixAllocator that was current when the buffer was
+// created, so panels and scratch rows reuse pooled memory like the matrices around them
+template <typename T>
+struct PooledAllocator {
+    using value_type = T;
+    MatrixAllocator* source;
+
+    PooledAllocator() : source(&MatrixAllocator::current()) {}
+    template <typename U>
+    PooledAllocator(const PooledAllocator<U>& other) : source(other.source) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(source->allocate(n * sizeof(T)));
+    }
+    void deallocate(T* memory, std::size_t n) {
+        source->deallocate(memory, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PooledAllocator<T>& a, const PooledAllocator<U>& b) {
+    return a.source == b.source;
+}
+
+template <typename T, typename U>
+bool operator!=(const PooledAllocator<T>& a, const PooledAllocator<U>& b) {
+    return a.source != b.source;
+}
+
+using Buffer = std::vector<double, PooledAllocator<double>>;
+
+// Split copy of a matrix or of one cache block of it, so the inner loops work on plain doubles
+// whatever the storage precision
+struct Panel {
+    Buffer re, im;
+
+    Panel(int rows, int cols) : re(std::size_t(rows) * cols), im(re.size()) {}
+
+    template <typename T>
+    explicit Panel(const BasicMatrix<T>& m) : Panel(m.getRows(), m.getCols()) {
+        pack(m, 0, m.getRows(), 0, m.getCols());
+    }
+
+    // Rows [firstRow, firstRow + height) and columns [firstCol, firstCol + width) of m, row stride width
+    template <typename T>
+    void pack(const BasicMatrix<T>& m, int firstRow, int height, int firstCol, int width) {
+        for (int r = 0; r < height; ++r) {
+            const BasicComplex<T>* values = m.data() + std::size_t(firstRow + r) * m.getCols() + firstCol;
+            double* rowReal = re.data() + std::size_t(r) * width;
+            double* rowImag = im.data() + std::size_t(r) * width;
+            for (int c = 0; c < width; ++c) {
+                rowReal[c] = values[c].get_real();
+                rowImag[c] = values[c].get_imag();
+            }
+        }
+    }
+};
+
+void runRows(int rows, int block, ThreadPool* pool, const std::function<void(std::size_t, std::size_t)>& body) {
+    if (pool) {
+        pool->parallelFor(0, rows, block, body);
+    } else {
+        body(0, rows);
+    }
+}
+}
 
-Matrix::Matrix(int nrows, int ncols) :
-    rows(nrows), cols(ncols), matrix_data(new Complex[nrows * ncols]) {}
+template <typename T>
+void BasicMatrix<T>::allocateStorage() {
+    if (rows < 0 || cols < 0) {
+        throw std::length_error("Matrix dimensions cannot be negative");
+    }
+    const std::size_t count = std::size_t(rows) * cols;
+    if (count == 0) {
+        matrix_data = nullptr;
+        allocator = nullptr;
+        return;
+    }
+    allocator = &MatrixAllocator::current();
+    matrix_data = static_cast<BasicComplex<T>*>(allocator->allocate(count * sizeof(BasicComplex<T>)));
+}
 
-Matrix::Matrix(const Matrix& other) :
-    rows(other.rows), cols(other.cols), matrix_data(new Complex[other.rows * other.cols]) {
-    for (int i = 0; i < rows * cols; i++) {
-        matrix_data[i] = other.matrix_data[i];
+template <typename T>
+void BasicMatrix<T>::releaseStorage() {
+    if (matrix_data) {
+        allocator->deallocate(matrix_data, std::size_t(rows) * cols * sizeof(BasicComplex<T>));
+        matrix_data = nullptr;
+        allocator = nullptr;
     }
 }
 
-Matrix::Matrix(Matrix&& other) :
-    rows(other.rows), cols(other.cols), matrix_data(other.matrix_data){
+template <typename T>
+BasicMatrix<T>::BasicMatrix() :
+    rows(0), cols(0), matrix_data(nullptr), allocator(nullptr) {}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(int nrows, int ncols) :
+    rows(nrows), cols(ncols), matrix_data(nullptr), allocator(nullptr) {
+    allocateStorage();
+    std::uninitialized_value_construct_n(matrix_data, std::size_t(rows) * cols);
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& other) :
+    rows(other.rows), cols(other.cols), matrix_data(nullptr), allocator(nullptr) {
+    allocateStorage();
+    std::uninitialized_copy_n(other.matrix_data, std::size_t(rows) * cols, matrix_data);
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& other) :
+    rows(other.rows), cols(other.cols), matrix_data(other.matrix_data), allocator(other.allocator) {
+    other.rows = other.cols = 0;
     other.matrix_data = nullptr;
+    other.allocator = nullptr;
 }
 
-Matrix::~Matrix() {
-    delete[] matrix_data;
+template <typename T>
+BasicMatrix<T>::~BasicMatrix() {
+    releaseStorage();
 }
 
-Matrix& Matrix::operator=(Matrix&& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& other) {
     if (this != &other) {
-        delete[] matrix_data;
+        releaseStorage();
         rows = other.rows;
         cols = other.cols;
         matrix_data = other.matrix_data;
+        allocator = other.allocator;
+        other.rows = other.cols = 0;
         other.matrix_data = nullptr;
+        other.allocator = nullptr;
     }
     return *this;
 }
 
-Matrix& Matrix::operator=(const Matrix& other) {
+template <typename T>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& other) {
     if (this != &other) {
-        delete[] matrix_data;
-        rows = other.rows;
-        cols = other.cols;
-        matrix_data = new Complex[rows * cols];
-        for (int i = 0; i < rows * cols; i++) {
-            matrix_data[i] = other.matrix_data[i];
+        const std::size_t count = std::size_t(other.rows) * other.cols;
+        if (count != std::size_t(rows) * cols) {
+            releaseStorage();
+            rows = other.rows;
+            cols = other.cols;
+            allocateStorage();
+            std::uninitialized_copy_n(other.matrix_data, count, matrix_data);
+        } else {
+            rows = other.rows;
+            cols = other.cols;
+            std::copy_n(other.matrix_data, count, matrix_data);
         }
     }
     return *this;
 }
 
 
-std::ostream& operator<<(std::ostream& os, const Matrix& mat) {
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const BasicMatrix<T>& mat) {
     for (int i = 0; i < mat.rows; i++) {
         for (int j = 0; j < mat.cols; j++) {
             os << std::setw(8) << std::setprecision(3) << mat(i + 1, j + 1);
@@ -54,23 +182,27 @@ std::ostream& operator<<(std::ostream& os, const Matrix& mat) {
     return os;
 }
 
-std::istream& operator>>(std::istream& is, Matrix& mat) {
+template <typename T>
+std::istream& operator>>(std::istream& is, BasicMatrix<T>& mat) {
     for (int i = 0; i < mat.rows * mat.cols; i++) {
         is >> mat.matrix_data[i];
     }
     return is;
 }
 
-Complex& Matrix::operator()(int i, int j) {
+template <typename T>
+BasicComplex<T>& BasicMatrix<T>::operator()(int i, int j) {
     return matrix_data[(i - 1) * cols + (j - 1)];
 }
 
-Complex Matrix::operator()(int i, int j) const {
+template <typename T>
+BasicComplex<T> BasicMatrix<T>::operator()(int i, int j) const {
     return matrix_data[(i - 1) * cols + (j - 1)];
 }
 
-Matrix Matrix::operator+(const Matrix& other) const {
-    Matrix result(rows, cols);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator+(const BasicMatrix& other) const {
+    BasicMatrix result(rows, cols);
     if (rows == other.rows && cols == other.cols) {
         for (int i = 1; i <= rows; i++) {
             for (int j = 1; j <= cols; j++) {
@@ -81,8 +213,9 @@ Matrix Matrix::operator+(const Matrix& other) const {
     return result;
 }
 
-Matrix Matrix::operator-(const Matrix& other) const {
-    Matrix result(rows, cols);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator-(const BasicMatrix& other) const {
+    BasicMatrix result(rows, cols);
     if (rows == other.rows && cols == other.cols) {
         for (int i = 1; i <= rows; i++) {
             for (int j = 1; j <= cols; j++) {
@@ -93,52 +226,115 @@ Matrix Matrix::operator-(const Matrix& other) const {
     return result;
 }
 
-Matrix Matrix::operator*(const Matrix& other) const {
-    if (cols != other.rows) {
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix& other) const {
+    return multiply(*this, other, nullptr);
+}
+
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::multiply(const BasicMatrix& a, const BasicMatrix& b, ThreadPool* pool) {
+    if (a.cols != b.rows) {
         throw std::invalid_argument("Invalid matrix dimensions for multiplication");
     }
-    Matrix result(rows, other.cols);
-    for (int i = 1; i <= rows; i++) {
-        for (int j = 1; j <= other.cols; j++) {
-            Complex sum(0, 0); // Changed type from double to Complex
-            for (int k = 1; k <= cols; k++) {
-                sum += (*this)(i, k) * other(k, j);
+    const int m = a.rows, n = b.cols, inner = a.cols;
+    BasicMatrix result(m, n);
+    if (m == 0 || n == 0) {
+        return result;
+    }
+    const int depthLimit = std::max(1, std::min(inner, innerBlock)), widthLimit = std::min(n, columnBlock);
+
+    // Each row block converts only the blocks of a and b it is about to use and accumulates one
+    // block of the result, so the split buffers are a few hundred KiB per thread however large
+    // the operands are. i-k-j order inside a block: each a(i,k) scales a contiguous run of row k
+    // of b into row i of the result. Zero entries of a are skipped, which matters for the sparse
+    // gate matrices.
+    auto rowsBody = [&](std::size_t firstRow, std::size_t lastRow) {
+        const int heightLimit = int(std::min<std::size_t>(rowBlock, lastRow - firstRow));
+        Panel left(heightLimit, depthLimit), right(depthLimit, widthLimit), out(heightLimit, widthLimit);
+        for (std::size_t ii = firstRow; ii < lastRow; ii += rowBlock) {
+            const int height = int(std::min<std::size_t>(lastRow, ii + rowBlock) - ii);
+            for (int jj = 0; jj < n; jj += columnBlock) {
+                const int width = std::min(n, jj + columnBlock) - jj;
+                std::fill(out.re.begin(), out.re.end(), 0.0);
+                std::fill(out.im.begin(), out.im.end(), 0.0);
+                for (int kk = 0; kk < inner; kk += innerBlock) {
+                    const int depth = std::min(inner, kk + innerBlock) - kk;
+                    left.pack(a, int(ii), height, kk, depth);
+                    right.pack(b, kk, depth, jj, width);
+                    for (int i = 0; i < height; ++i) {
+                        double* rowReal = out.re.data() + std::size_t(i) * width;
+                        double* rowImag = out.im.data() + std::size_t(i) * width;
+                        for (int k = 0; k < depth; ++k) {
+                            const double aReal = left.re[std::size_t(i) * depth + k];
+                            const double aImag = left.im[std::size_t(i) * depth + k];
+                            if (aReal == 0 && aImag == 0) {
+                                continue;
+                            }
+                            SimdKernels::complexAxpy(width, aReal, aImag, right.re.data() + std::size_t(k) * width,
+                                                     right.im.data() + std::size_t(k) * width, rowReal, rowImag);
+                        }
+                    }
+                }
+                for (int i = 0; i < height; ++i) {
+                    BasicComplex<T>* row = result.matrix_data + (ii + i) * n + jj;
+                    for (int j = 0; j < width; ++j) {
+                        row[j] = BasicComplex<T>(out.re[std::size_t(i) * width + j], out.im[std::size_t(i) * width + j]);
+                    }
+                }
             }
-            result(i, j) = sum;
         }
-    }
+    };
+    runRows(m, rowBlock, pool, rowsBody);
     return result;
 }
 
 
-Matrix Matrix::identityMatrix(int size) {
-    Matrix result(size, size);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::identityMatrix(int size) {
+    BasicMatrix result(size, size);
     for (int i = 1; i <= size; i++) {
-        result(i, i) = Complex(1, 0);
+        result(i, i) = BasicComplex<T>(1, 0);
     }
     return result;
 }
 
-Matrix Matrix::kroneckerProduct(const Matrix& a, const Matrix& b) {
-    int rows = a.getRows() * b.getRows();
-    int cols = a.getCols() * b.getCols();
-    Matrix result(rows, cols);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::kroneckerProduct(const BasicMatrix& a, const BasicMatrix& b) {
+    return kroneckerProduct(a, b, nullptr);
+}
 
-    for (int i = 1; i <= a.getRows(); i++) {
-        for (int j = 1; j <= a.getCols(); j++) {
-            for (int k = 1; k <= b.getRows(); k++) {
-                for (int l = 1; l <= b.getCols(); l++) {
-                    result((i - 1) * b.getRows() + k, (j - 1) * b.getCols() + l) = a(i, j) * b(k, l);
-                }
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::kroneckerProduct(const BasicMatrix& a, const BasicMatrix& b, ThreadPool* pool) {
+    const int bRows = b.rows, bCols = b.cols;
+    const int rows = a.rows * bRows;
+    const int cols = a.cols * bCols;
+    BasicMatrix result(rows, cols);
+    const Panel left(a), right(b);
+
+    // Result row (i, k) is the concatenation over j of a(i,j) * row k of b
+    auto rowsBody = [&](std::size_t firstRow, std::size_t lastRow) {
+        Buffer rowReal(cols), rowImag(cols);
+        for (std::size_t row = firstRow; row < lastRow; ++row) {
+            const int i = row / bRows, k = row % bRows;
+            for (int j = 0; j < a.cols; ++j) {
+                SimdKernels::complexScale(bCols, left.re[std::size_t(i) * a.cols + j], left.im[std::size_t(i) * a.cols + j],
+                                          right.re.data() + std::size_t(k) * bCols, right.im.data() + std::size_t(k) * bCols,
+                                          rowReal.data() + std::size_t(j) * bCols, rowImag.data() + std::size_t(j) * bCols);
+            }
+            BasicComplex<T>* out = result.matrix_data + row * cols;
+            for (int c = 0; c < cols; ++c) {
+                out[c] = BasicComplex<T>(rowReal[c], rowImag[c]);
             }
         }
-    }
+    };
+    runRows(rows, rowBlock, pool, rowsBody);
 
     return result;
 }
 
-Matrix Matrix::transpose() const {
-    Matrix result(cols, rows);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::transpose() const {
+    BasicMatrix result(cols, rows);
     for (int i = 1; i <= rows; i++) {
         for (int j = 1; j <= cols; j++) {
             result(j, i) = (*this)(i, j);
@@ -147,8 +343,20 @@ Matrix Matrix::transpose() const {
     return result;
 }
 
-Matrix Matrix::submatrix(int row, int col) const {
-    Matrix submatrix(rows - 1, cols - 1);
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::adjoint() const {
+    BasicMatrix result(cols, rows);
+    for (int i = 1; i <= rows; i++) {
+        for (int j = 1; j <= cols; j++) {
+            result(j, i) = (*this)(i, j).conjugate();
+        }
+    }
+    return result;
+}
+
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::submatrix(int row, int col) const {
+    BasicMatrix submatrix(rows - 1, cols - 1);
     for (int i = 1; i <= rows; i++) {
         if (i == row) continue;
         for (int j = 1; j <= cols; j++) {
@@ -159,7 +367,8 @@ Matrix Matrix::submatrix(int row, int col) const {
     return submatrix;
 }
 
-Complex Matrix::determinant() const {
+template <typename T>
+BasicComplex<T> BasicMatrix<T>::determinant() const {
     if (rows != cols) {
         throw std::invalid_argument("Invalid matrix dimensions for determinant");
     }
@@ -168,24 +377,223 @@ Complex Matrix::determinant() const {
         return (*this)(1, 1);
     }
 
-    Complex det(0.0, 0.0);
+    BasicComplex<T> det(0.0, 0.0);
     for (int j = 1; j <= cols; j++) {
-        Complex multiplier(j % 2 == 1 ? 1.0 : -1.0, 0.0);
+        BasicComplex<T> multiplier(j % 2 == 1 ? 1.0 : -1.0, 0.0);
         det += multiplier * (*this)(1, j) * submatrix(1, j).determinant();
     }
     return det;
 }
 
-int Matrix::getRows() const {
-    return rows;
-}
+template <typename T>
+void BasicMatrix<T>::qrDecomposition(BasicMatrix& q, BasicMatrix& r) const {
+    const int m = rows, n = cols, k = std::min(rows, cols);
+    // Column-major split copy, so each reflection runs down contiguous columns
+    std::vector<double> ar(std::size_t(m) * n), ai(ar.size());
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) {
+            ar[std::size_t(j) * m + i] = matrix_data[i * n + j].get_real();
+            ai[std::size_t(j) * m + i] = matrix_data[i * n + j].get_imag();
+        }
+    }
+    // Reflector j is I - 2 v v^dagger acting on rows [j, m); v is stored in rows [j, m) of column j
+    std::vector<double> vr(std::size_t(m) * k, 0.0), vi(vr.size(), 0.0);
+    auto reflect = [&](int j, double* xr, double* xi) {
+        const double* pr = &vr[std::size_t(j) * m];
+        const double* pi = &vi[std::size_t(j) * m];
+        double dr = 0.0, di = 0.0;  // v^dagger x
+        for (int i = j; i < m; ++i) {
+            dr += pr[i] * xr[i] + pi[i] * xi[i];
+            di += pr[i] * xi[i] - pi[i] * xr[i];
+        }
+        for (int i = j; i < m; ++i) {
+            xr[i] -= 2.0 * (pr[i] * dr - pi[i] * di);
+            xi[i] -= 2.0 * (pr[i] * di + pi[i] * dr);
+        }
+    };
+    for (int j = 0; j < k; ++j) {
+        double* xr = &ar[std::size_t(j) * m];
+        double* xi = &ai[std::size_t(j) * m];
+        double norm = 0.0;
+        for (int i = j; i < m; ++i) {
+            norm += xr[i] * xr[i] + xi[i] * xi[i];
+        }
+        norm = std::sqrt(norm);
+        if (norm == 0.0) {
+            continue;
+        }
+        // alpha = -e^(i arg x_j) |x| avoids cancellation in v = x - alpha e_j
+        const double lead = std::hypot(xr[j], xi[j]);
+        const double er = lead > 0.0 ? xr[j] / lead : 1.0, ei = lead > 0.0 ? xi[j] / lead : 0.0;
+        double* pr = &vr[std::size_t(j) * m];
+        double* pi = &vi[std::size_t(j) * m];
+        double vnorm = 0.0;
+        for (int i = j; i < m; ++i) {
+            pr[i] = xr[i] + (i == j ? er * norm : 0.0);
+            pi[i] = xi[i] + (i == j ? ei * norm : 0.0);
+            vnorm += pr[i] * pr[i] + pi[i] * pi[i];
+        }
+        vnorm = std::sqrt(vnorm);
+        for (int i = j; i < m; ++i) {
+            pr[i] /= vnorm;
+            pi[i] /= vnorm;
+        }
+        for (int c = j; c < n; ++c) {
+            reflect(j, &ar[std::size_t(c) * m], &ai[std::size_t(c) * m]);
+        }
+    }
 
-int Matrix::getCols() const {
-    return cols;
+    r = BasicMatrix(k, n);
+    for (int i = 0; i < k; ++i) {
+        for (int j = 0; j < n; ++j) {
+            r.matrix_data[i * n + j] = j < i ? BasicComplex<T>() : BasicComplex<T>(ar[std::size_t(j) * m + i], ai[std::size_t(j) * m + i]);
+        }
+    }
+    // q = H_0 ... H_(k-1) applied to the first k columns of the identity
+    std::vector<double> qr(std::size_t(m) * k, 0.0), qi(qr.size(), 0.0);
+    for (int c = 0; c < k; ++c) {
+        qr[std::size_t(c) * m + c] = 1.0;
+        for (int j = std::min(c, k - 1); j >= 0; --j) {
+            reflect(j, &qr[std::size_t(c) * m], &qi[std::size_t(c) * m]);
+        }
+    }
+    q = BasicMatrix(m, k);
+    for (int i = 0; i < m; ++i) {
+        for (int c = 0; c < k; ++c) {
+            q.matrix_data[i * k + c] = BasicComplex<T>(qr[std::size_t(c) * m + i], qi[std::size_t(c) * m + i]);
+        }
+    }
 }
 
+template <typename T>
+void BasicMatrix<T>::singularValueDecomposition(BasicMatrix& u, std::vector<T>& s, BasicMatrix& v) const {
+    if (rows < cols) {
+        // A^dagger = V S U^dagger
+        adjoint().singularValueDecomposition(v, s, u);
+        return;
+    }
+    const int m = rows, n = cols;
+    const int maxSweeps = 64;
+    const double tolerance = 1e-15;
+
+    // Column-major split copies of the working matrix W = A V and of V
+    std::vector<double> wr(std::size_t(m) * n), wi(wr.size());
+    for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) {
+            wr[std::size_t(j) * m + i] = matrix_data[i * n + j].get_real();
+            wi[std::size_t(j) * m + i] = matrix_data[i * n + j].get_imag();
+        }
+    }
+    std::vector<double> vr(std::size_t(n) * n, 0.0), vi(vr.size(), 0.0);
+    for (int j = 0; j < n; ++j) {
+        vr[std::size_t(j) * n + j] = 1.0;
+    }
+    std::vector<double> norms(n);
+    for (int j = 0; j < n; ++j) {
+        double sum = 0.0;
+        for (int i = 0; i < m; ++i) {
+            sum += wr[std::size_t(j) * m + i] * wr[std::size_t(j) * m + i] + wi[std::size_t(j) * m + i] * wi[std::size_t(j) * m + i];
+        }
+        norms[j] = sum;
+    }
 
+    // Rotate columns p and q by [[c, s e^(i phi)], [-s e^(-i phi), c]], chosen so they become
+    // orthogonal; phi is the phase of <w_p|w_q>
+    auto rotate = [](double* pr, double* pi, double* qr, double* qi, int length, double c, double s, double er, double ei) {
+        for (int i = 0; i < length; ++i) {
+            const double ar = pr[i], ai = pi[i], br = qr[i], bi = qi[i];
+            pr[i] = c * ar - s * (er * br + ei * bi);
+            pi[i] = c * ai - s * (er * bi - ei * br);
+            qr[i] = s * (er * ar - ei * ai) + c * br;
+            qi[i] = s * (er * ai + ei * ar) + c * bi;
+        }
+    };
+    for (int sweep = 0; sweep < maxSweeps; ++sweep) {
+        bool rotated = false;
+        for (int p = 0; p < n - 1; ++p) {
+            for (int q = p + 1; q < n; ++q) {
+                double* pr = &wr[std::size_t(p) * m];
+                double* pi = &wi[std::size_t(p) * m];
+                double* qr = &wr[std::size_t(q) * m];
+                double* qi = &wi[std::size_t(q) * m];
+                double gr = 0.0, gi = 0.0;
+                for (int i = 0; i < m; ++i) {
+                    gr += pr[i] * qr[i] + pi[i] * qi[i];
+                    gi += pr[i] * qi[i] - pi[i] * qr[i];
+                }
+                const double g = std::hypot(gr, gi);
+                if (g == 0.0 || g <= tolerance * std::sqrt(norms[p] * norms[q])) {
+                    continue;
+                }
+                rotated = true;
+                const double zeta = (norms[q] - norms[p]) / (2.0 * g);
+                const double t = (zeta >= 0.0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                const double c = 1.0 / std::sqrt(1.0 + t * t);
+                const double sn = c * t;
+                rotate(pr, pi, qr, qi, m, c, sn, gr / g, gi / g);
+                rotate(&vr[std::size_t(p) * n], &vi[std::size_t(p) * n], &vr[std::size_t(q) * n], &vi[std::size_t(q) * n], n, c, sn, gr / g, gi / g);
+                norms[p] -= t * g;
+                norms[q] += t * g;
+            }
+        }
+        if (!rotated) {
+            break;
+        }
+        // The running norms drift; refresh them once per sweep
+        for (int j = 0; j < n; ++j) {
+            double sum = 0.0;
+            for (int i = 0; i < m; ++i) {
+                sum += wr[std::size_t(j) * m + i] * wr[std::size_t(j) * m + i] + wi[std::size_t(j) * m + i] * wi[std::size_t(j) * m + i];
+            }
+            norms[j] = sum;
+        }
+    }
 
+    std::vector<int> order(n);
+    for (int j = 0; j < n; ++j) {
+        order[j] = j;
+        norms[j] = std::sqrt(std::max(norms[j], 0.0));
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return norms[a] > norms[b]; });
+    u = BasicMatrix(m, n);
+    v = BasicMatrix(n, n);
+    s.assign(n, T(0));
+    for (int c = 0; c < n; ++c) {
+        const int j = order[c];
+        s[c] = T(norms[j]);
+        const double scale = norms[j] > 0.0 ? 1.0 / norms[j] : 0.0;
+        for (int i = 0; i < m; ++i) {
+            u.matrix_data[i * n + c] = BasicComplex<T>(wr[std::size_t(j) * m + i] * scale, wi[std::size_t(j) * m + i] * scale);
+        }
+        for (int i = 0; i < n; ++i) {
+            v.matrix_data[i * n + c] = BasicComplex<T>(vr[std::size_t(j) * n + i], vi[std::size_t(j) * n + i]);
+        }
+    }
+}
 
+template <typename T>
+int BasicMatrix<T>::getRows() const {
+    return rows;
+}
 
+template <typename T>
+int BasicMatrix<T>::getCols() const {
+    return cols;
+}
+
+template <typename T>
+BasicComplex<T>* BasicMatrix<T>::data() {
+    return matrix_data;
+}
+
+template <typename T>
+const BasicComplex<T>* BasicMatrix<T>::data() const {
+    return matrix_data;
+}
 
+template class BasicMatrix<double>;
+template class BasicMatrix<float>;
+template std::ostream& operator<<(std::ostream&, const BasicMatrix<double>&);
+template std::ostream& operator<<(std::ostream&, const BasicMatrix<float>&);
+template std::istream& operator>>(std::istream&, BasicMatrix<double>&);
+template std::istream& operator>>(std::istream&, BasicMatrix<float>&);
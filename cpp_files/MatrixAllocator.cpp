@@ -0,0 +1,258 @@
+#include "../h_files/MatrixAllocator.h"
+
+#include <new>
+#include <atomic>
+#include <algorithm>
+#include <sys/mman.h>
+
+namespace {
+const std::size_t alignment = 64;
+
+std::atomic<MatrixAllocator*> currentAllocator{nullptr};
+
+void* alignedNew(std::size_t bytes) {
+    return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+void alignedDelete(void* memory) {
+    ::operator delete(memory, std::align_val_t(alignment));
+}
+
+std::size_t mappedSize(std::size_t bytes) {
+    return (bytes + HugePageArena::hugePageSize - 1) / HugePageArena::hugePageSize * HugePageArena::hugePageSize;
+}
+}
+
+std::ostream& operator<<(std::ostream& os, const AllocationStatistics& stats) {
+    os << "Matrix allocations: " << stats.allocations << " (" << stats.reused << " reused, " << stats.systemAllocations
+       << " from the system, " << stats.hugePageMappings << " on huge pages), " << stats.deallocations
+       << " deallocations, " << stats.bytesInUse / 1048576.0 << " MiB in use (peak " << stats.peakBytesInUse / 1048576.0
+       << " MiB), " << stats.bytesCached / 1048576.0 << " MiB cached";
+    return os;
+}
+
+AllocationStatistics MatrixAllocator::getStatistics() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
+
+MatrixAllocator& MatrixAllocator::current() {
+    MatrixAllocator* allocator = currentAllocator.load(std::memory_order_acquire);
+    return allocator ? *allocator : pool();
+}
+
+void MatrixAllocator::setCurrent(MatrixAllocator* allocator) {
+    currentAllocator.store(allocator, std::memory_order_release);
+}
+
+// Leaked on purpose: static matrices may be destroyed after any static allocator would be
+MatrixAllocator& MatrixAllocator::heap() {
+    static MatrixAllocator* instance = new HeapAllocator();
+    return *instance;
+}
+
+MatrixAllocator& MatrixAllocator::pool() {
+    static MatrixAllocator* instance = new PoolAllocator();
+    return *instance;
+}
+
+MatrixAllocator& MatrixAllocator::hugePages() {
+    static MatrixAllocator* instance = new HugePageArena();
+    return *instance;
+}
+
+void MatrixAllocator::recordAllocation(std::size_t bytes, bool reused, bool hugePages) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    ++stats.allocations;
+    ++(reused ? stats.reused : stats.systemAllocations);
+    stats.hugePageMappings += hugePages;
+    stats.bytesInUse += bytes;
+    stats.peakBytesInUse = std::max(stats.peakBytesInUse, stats.bytesInUse);
+}
+
+void MatrixAllocator::recordDeallocation(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    ++stats.deallocations;
+    stats.bytesInUse -= bytes;
+}
+
+void MatrixAllocator::setCachedBytes(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats.bytesCached = bytes;
+}
+
+void* HeapAllocator::allocate(std::size_t bytes) {
+    void* memory = alignedNew(bytes);
+    recordAllocation(bytes, false);
+    return memory;
+}
+
+void HeapAllocator::deallocate(void* memory, std::size_t bytes) {
+    alignedDelete(memory);
+    recordDeallocation(bytes);
+}
+
+HugePageArena::HugePageArena(std::size_t maxCachedBytes) : maxCached(maxCachedBytes), cached(0) {}
+
+HugePageArena::~HugePageArena() {
+    release();
+}
+
+void* HugePageArena::allocate(std::size_t bytes) {
+    bool reused = false, huge = false;
+    void* memory = acquire(bytes, reused, huge);
+    recordAllocation(bytes, reused, huge);
+    return memory;
+}
+
+void HugePageArena::deallocate(void* memory, std::size_t bytes) {
+    recordDeallocation(bytes);
+    recycle(memory, bytes);
+}
+
+void* HugePageArena::acquire(std::size_t bytes, bool& reused, bool& huge) {
+    const std::size_t size = mappedSize(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = freeMappings.find(size);
+        if (it != freeMappings.end()) {
+            void* memory = it->second;
+            freeMappings.erase(it);
+            cached -= size;
+            setCachedBytes(cached);
+            reused = true;
+            huge = false;
+            return memory;
+        }
+    }
+
+    reused = huge = false;
+    void* memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge = memory != MAP_FAILED;
+#endif
+    if (memory == MAP_FAILED) {
+        memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        ::madvise(memory, size, MADV_HUGEPAGE);
+#endif
+    }
+    return memory;
+}
+
+void HugePageArena::recycle(void* memory, std::size_t bytes) {
+    const std::size_t size = mappedSize(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cached + size <= maxCached) {
+            freeMappings.emplace(size, memory);
+            cached += size;
+            setCachedBytes(cached);
+            return;
+        }
+    }
+    ::munmap(memory, size);
+}
+
+std::size_t HugePageArena::getCachedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cached;
+}
+
+void HugePageArena::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& mapping : freeMappings) {
+        ::munmap(mapping.second, mapping.first);
+    }
+    freeMappings.clear();
+    cached = 0;
+    setCachedBytes(0);
+}
+
+PoolAllocator::PoolAllocator(std::size_t maxCachedBytes, std::size_t largeThresholdBytes)
+: maxCached(maxCachedBytes), cached(0), largeThreshold(largeThresholdBytes), large(maxCachedBytes) {}
+
+PoolAllocator::~PoolAllocator() {
+    release();
+}
+
+std::size_t PoolAllocator::classSize(std::size_t bytes) {
+    if (bytes <= alignment) {
+        return alignment;
+    }
+    std::size_t power = alignment;
+    while (power * 2 < bytes) {
+        power *= 2;
+    }
+    const std::size_t step = power / 4;
+    return (bytes + step - 1) / step * step;
+}
+
+void* PoolAllocator::allocate(std::size_t bytes) {
+    if (bytes >= largeThreshold) {
+        bool reused = false, huge = false;
+        void* memory = large.acquire(bytes, reused, huge);
+        recordAllocation(bytes, reused, huge);
+        return memory;
+    }
+    const std::size_t size = classSize(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = freeLists.find(size);
+        if (it != freeLists.end() && !it->second.empty()) {
+            void* memory = it->second.back();
+            it->second.pop_back();
+            cached -= size;
+            setCachedBytes(cached);
+            recordAllocation(bytes, true);
+            return memory;
+        }
+    }
+    void* memory = alignedNew(size);
+    recordAllocation(bytes, false);
+    return memory;
+}
+
+void PoolAllocator::deallocate(void* memory, std::size_t bytes) {
+    recordDeallocation(bytes);
+    if (bytes >= largeThreshold) {
+        large.recycle(memory, bytes);
+        return;
+    }
+    const std::size_t size = classSize(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cached + size <= maxCached) {
+            freeLists[size].push_back(memory);
+            cached += size;
+            setCachedBytes(cached);
+            return;
+        }
+    }
+    alignedDelete(memory);
+}
+
+void PoolAllocator::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& list : freeLists) {
+            for (void* memory : list.second) {
+                alignedDelete(memory);
+            }
+        }
+        freeLists.clear();
+        cached = 0;
+        setCachedBytes(0);
+    }
+    large.release();
+}
+
+AllocationStatistics PoolAllocator::getStatistics() const {
+    AllocationStatistics stats = MatrixAllocator::getStatistics();
+    stats.bytesCached += large.getCachedBytes();
+    return stats;
+}
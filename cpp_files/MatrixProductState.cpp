@@ -0,0 +1,420 @@
+#include "../h_files/MatrixProductState.h"
+
+#include <map>
+#include <mutex>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+const std::uint64_t shotsPerChunk = 1024;
+
+std::uint64_t mixSeed(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+// The same row-major elements in another shape; a site is (left * 2) x right or left x (2 * right)
+Matrix reshaped(const Matrix& m, int rows, int cols) {
+    Matrix result(rows, cols);
+    std::copy(m.data(), m.data() + std::size_t(rows) * cols, result.data());
+    return result;
+}
+}
+
+std::ostream& operator<<(std::ostream& os, const MPSStatistics& stats) {
+    os << "MPS: max bond " << stats.maxBond << ", " << stats.truncations << " truncations, discarded weight "
+       << stats.discardedWeight << ", fidelity estimate " << stats.fidelity << ", " << stats.swaps << " swaps";
+    return os;
+}
+
+MatrixProductState::MatrixProductState(int qubits, int maxBond, double cutoff)
+: qubits(qubits), maxBond(maxBond), cutoff(cutoff), sites(qubits), center(0) {
+    if (qubits < 0) {
+        throw std::invalid_argument("Number of qubits cannot be negative");
+    }
+    if (maxBond < 1) {
+        throw std::invalid_argument("Bond dimension must be at least 1");
+    }
+    for (Matrix& site : sites) {
+        site = Matrix(2, 1);
+        site(1, 1) = Complex(1, 0);
+    }
+}
+
+MatrixProductState MatrixProductState::fromStateVector(const Complex* amplitudes, int qubits, int maxBond, double cutoff) {
+    if (qubits < 1 || qubits > 30) {
+        throw std::length_error("State vector for " + std::to_string(qubits) + " qubits does not fit in a Matrix");
+    }
+    MatrixProductState state(qubits, maxBond, cutoff);
+    // Site 0 is the highest bit of the chain index, qubit 0 the lowest bit of the amplitude index
+    const std::size_t dimension = std::size_t(1) << qubits;
+    Matrix theta(dimension, 1);
+    for (std::size_t i = 0; i < dimension; ++i) {
+        std::size_t chain = 0;
+        for (int q = 0; q < qubits; ++q) {
+            chain |= ((i >> q) & 1) << (qubits - 1 - q);
+        }
+        theta.data()[chain] = amplitudes[i];
+    }
+    state.splitBlock(0, qubits, theta);
+    return state;
+}
+
+int MatrixProductState::getQubits() const {
+    return qubits;
+}
+
+void MatrixProductState::setTruncation(int newMaxBond, double newCutoff) {
+    if (newMaxBond < 1) {
+        throw std::invalid_argument("Bond dimension must be at least 1");
+    }
+    maxBond = newMaxBond;
+    cutoff = newCutoff;
+}
+
+std::vector<int> MatrixProductState::getBondDimensions() const {
+    std::vector<int> bonds;
+    for (int q = 0; q + 1 < qubits; ++q) {
+        bonds.push_back(sites[q].getCols());
+    }
+    return bonds;
+}
+
+const MPSStatistics& MatrixProductState::getStatistics() const {
+    return stats;
+}
+
+void MatrixProductState::checkQubit(int qubit) const {
+    if (qubit < 0 || qubit >= qubits) {
+        throw std::out_of_range("Qubit index out of range");
+    }
+}
+
+void MatrixProductState::moveCenter(int site) {
+    while (center < site) {
+        Matrix q, r;
+        sites[center].qrDecomposition(q, r);
+        Matrix& next = sites[center + 1];
+        const int right = next.getCols();
+        const Matrix product = Matrix::multiply(r, reshaped(next, next.getRows() / 2, 2 * right), nullptr);
+        next = reshaped(product, 2 * r.getRows(), right);
+        sites[center] = std::move(q);
+        ++center;
+    }
+    while (center > site) {
+        // site = L Q with Q right-orthonormal, from the QR decomposition of its adjoint
+        Matrix& current = sites[center];
+        const int left = current.getRows() / 2, right = current.getCols();
+        Matrix q, r;
+        reshaped(current, left, 2 * right).adjoint().qrDecomposition(q, r);
+        current = reshaped(q.adjoint(), 2 * q.getCols(), right);
+        sites[center - 1] = Matrix::multiply(sites[center - 1], r.adjoint(), nullptr);
+        --center;
+    }
+}
+
+void MatrixProductState::splitBlock(int first, int count, const Matrix& theta) {
+    const int right = theta.getCols();
+    int left = theta.getRows() >> count;
+    Matrix rest = theta;
+    for (int j = 0; j < count - 1; ++j) {
+        // (left * 2) x (2^(count - j - 1) * right): this site's bit against everything to its right
+        const int rows = left * 2;
+        const int cols = int(std::size_t(rest.getRows()) * rest.getCols() / rows);
+        Matrix u, v;
+        std::vector<double> s;
+        reshaped(rest, rows, cols).singularValueDecomposition(u, s, v);
+
+        int keep = 0;
+        while (keep < int(s.size()) && keep < maxBond && s[keep] > cutoff * s[0]) {
+            ++keep;
+        }
+        keep = std::max(keep, 1);
+        double total = 0, discarded = 0;
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            total += s[i] * s[i];
+            if (int(i) >= keep) {
+                discarded += s[i] * s[i];
+            }
+        }
+        if (discarded > 0) {
+            stats.discardedWeight += discarded / total;
+            stats.fidelity *= 1 - discarded / total;
+        }
+        if (keep < int(s.size()) && s[keep] > cutoff * s[0]) {
+            ++stats.truncations;
+        }
+        stats.maxBond = std::max(stats.maxBond, keep);
+        // The kept values are rescaled so the state keeps its norm
+        const double scale = discarded > 0 ? std::sqrt(total / (total - discarded)) : 1.0;
+
+        Matrix site(rows, keep);
+        for (int i = 0; i < rows; ++i) {
+            for (int c = 0; c < keep; ++c) {
+                site.data()[i * keep + c] = u.data()[i * u.getCols() + c];
+            }
+        }
+        Matrix next(keep, cols);
+        for (int c = 0; c < keep; ++c) {
+            const Complex weight(s[c] * scale, 0);
+            for (int i = 0; i < cols; ++i) {
+                next.data()[std::size_t(c) * cols + i] = weight * v.data()[i * v.getCols() + c].conjugate();
+            }
+        }
+        sites[first + j] = std::move(site);
+        rest = std::move(next);
+        left = keep;
+    }
+    sites[first + count - 1] = reshaped(rest, left * 2, right);
+    center = first + count - 1;
+}
+
+void MatrixProductState::applyBlock(int first, int count, const Matrix& block) {
+    // A single-site gate is unitary on the physical index and keeps the site's orthonormality
+    if (count > 1) {
+        if (center < first) {
+            moveCenter(first);
+        } else if (center > first + count - 1) {
+            moveCenter(first + count - 1);
+        }
+    }
+    Matrix theta = sites[first];
+    for (int j = 1; j < count; ++j) {
+        const Matrix& next = sites[first + j];
+        const int right = next.getCols();
+        const Matrix product = Matrix::multiply(theta, reshaped(next, next.getRows() / 2, 2 * right), nullptr);
+        theta = reshaped(product, product.getRows() * 2, right);
+    }
+
+    // (left, dim, right) -> (dim, left * right), one product with the block, and back
+    const int dim = 1 << count;
+    const int right = theta.getCols(), left = theta.getRows() / dim;
+    const std::size_t outer = std::size_t(left) * right;
+    Matrix gathered(dim, outer);
+    for (int l = 0; l < left; ++l) {
+        for (int b = 0; b < dim; ++b) {
+            for (int r = 0; r < right; ++r) {
+                gathered.data()[b * outer + std::size_t(l) * right + r] = theta.data()[(std::size_t(l) * dim + b) * right + r];
+            }
+        }
+    }
+    const Matrix product = Matrix::multiply(block, gathered, nullptr);
+    for (int l = 0; l < left; ++l) {
+        for (int b = 0; b < dim; ++b) {
+            for (int r = 0; r < right; ++r) {
+                theta.data()[(std::size_t(l) * dim + b) * right + r] = product.data()[b * outer + std::size_t(l) * right + r];
+            }
+        }
+    }
+
+    if (count == 1) {
+        sites[first] = std::move(theta);
+    } else {
+        splitBlock(first, count, theta);
+    }
+}
+
+void MatrixProductState::swapSites(int site) {
+    Matrix swap(4, 4);
+    swap(1, 1) = swap(2, 3) = swap(3, 2) = swap(4, 4) = Complex(1, 0);
+    applyBlock(site, 2, swap);
+    ++stats.swaps;
+}
+
+void MatrixProductState::applyOperation(const GateOperation& op) {
+    std::vector<int> order = op.targets;
+    order.insert(order.end(), op.controls.begin(), op.controls.end());
+    for (int qubit : order) {
+        checkQubit(qubit);
+    }
+    std::sort(order.begin(), order.end());
+    if (std::adjacent_find(order.begin(), order.end()) != order.end()) {
+        throw std::invalid_argument("Gate qubits must be distinct");
+    }
+    const int targetCount = op.targets.size();
+    if (targetCount < 1 || op.matrix.getRows() != (1 << targetCount) || op.matrix.getCols() != (1 << targetCount)) {
+        throw std::invalid_argument("Gate matrix does not match its targets");
+    }
+
+    // Bring the qubits onto consecutive sites after the lowest one, remembering the swaps
+    std::vector<int> swaps;
+    for (std::size_t j = 1; j < order.size(); ++j) {
+        for (int site = order[j] - 1; site >= order[0] + int(j); --site) {
+            swapSites(site);
+            swaps.push_back(site);
+        }
+    }
+
+    // Block bit of each qubit; the first site is the highest bit
+    const int count = order.size();
+    auto bitOf = [&](int qubit) {
+        return count - 1 - int(std::lower_bound(order.begin(), order.end(), qubit) - order.begin());
+    };
+    const int dim = 1 << count;
+    Matrix block(dim, dim);
+    for (int b = 0; b < dim; ++b) {
+        bool active = true;
+        for (int control : op.controls) {
+            active = active && ((b >> bitOf(control)) & 1);
+        }
+        if (!active) {
+            block(b + 1, b + 1) = Complex(1, 0);
+            continue;
+        }
+        int column = 0, cleared = b;
+        for (int t = 0; t < targetCount; ++t) {
+            column |= ((b >> bitOf(op.targets[t])) & 1) << t;
+            cleared &= ~(1 << bitOf(op.targets[t]));
+        }
+        for (int row = 0; row < (1 << targetCount); ++row) {
+            int image = cleared;
+            for (int t = 0; t < targetCount; ++t) {
+                if ((row >> t) & 1) {
+                    image |= 1 << bitOf(op.targets[t]);
+                }
+            }
+            block(image + 1, b + 1) = op.matrix(row + 1, column + 1);
+        }
+    }
+    applyBlock(order[0], count, block);
+
+    for (auto it = swaps.rbegin(); it != swaps.rend(); ++it) {
+        swapSites(*it);
+    }
+}
+
+Complex MatrixProductState::amplitude(const std::string& bitstring) const {
+    if (int(bitstring.size()) != qubits) {
+        throw std::invalid_argument("Bitstring length does not match the number of qubits");
+    }
+    Matrix row(1, 1);
+    row(1, 1) = Complex(1, 0);
+    for (int q = 0; q < qubits; ++q) {
+        const int bit = bitstring[qubits - 1 - q] == '1' ? 1 : 0;
+        const int left = sites[q].getRows() / 2, right = sites[q].getCols();
+        Matrix slice(left, right);
+        for (int l = 0; l < left; ++l) {
+            for (int r = 0; r < right; ++r) {
+                slice.data()[l * right + r] = sites[q].data()[(l * 2 + bit) * right + r];
+            }
+        }
+        row = Matrix::multiply(row, slice, nullptr);
+    }
+    return row(1, 1);
+}
+
+MeasurementCounts MatrixProductState::sample(std::uint64_t shots, std::uint64_t seed, ThreadPool* pool) const {
+    // With every site right of the first right-orthonormal, |env A(bit)|^2 is the probability
+    // of bit given the bits drawn so far
+    MatrixProductState canonical = *this;
+    canonical.moveCenter(0);
+    std::vector<std::vector<double>> re(qubits), im(qubits);
+    int widest = 1;
+    for (int q = 0; q < qubits; ++q) {
+        const Matrix& site = canonical.sites[q];
+        const std::size_t size = std::size_t(site.getRows()) * site.getCols();
+        re[q].resize(size);
+        im[q].resize(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            re[q][i] = site.data()[i].get_real();
+            im[q][i] = site.data()[i].get_imag();
+        }
+        widest = std::max(widest, site.getCols());
+    }
+
+    std::unordered_map<std::string, std::uint64_t> totals;
+    std::mutex totalsMutex;
+    const std::size_t chunks = (shots + shotsPerChunk - 1) / shotsPerChunk;
+    auto drawChunks = [&](std::size_t begin, std::size_t end) {
+        std::unordered_map<std::string, std::uint64_t> local;
+        std::vector<double> envRe(widest), envIm(widest), wRe[2], wIm[2];
+        for (int bit = 0; bit < 2; ++bit) {
+            wRe[bit].resize(widest);
+            wIm[bit].resize(widest);
+        }
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::string bitstring(qubits, '0');
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+            std::mt19937_64 rng(mixSeed(seed ^ mixSeed(chunk)));
+            const std::uint64_t count = std::min<std::uint64_t>(shotsPerChunk, shots - chunk * shotsPerChunk);
+            for (std::uint64_t shot = 0; shot < count; ++shot) {
+                envRe[0] = 1;
+                envIm[0] = 0;
+                for (int q = 0; q < qubits; ++q) {
+                    const int left = canonical.sites[q].getRows() / 2, right = canonical.sites[q].getCols();
+                    double p[2];
+                    for (int bit = 0; bit < 2; ++bit) {
+                        p[bit] = 0;
+                        for (int r = 0; r < right; ++r) {
+                            double sumRe = 0, sumIm = 0;
+                            for (int l = 0; l < left; ++l) {
+                                const std::size_t at = std::size_t(l * 2 + bit) * right + r;
+                                sumRe += envRe[l] * re[q][at] - envIm[l] * im[q][at];
+                                sumIm += envRe[l] * im[q][at] + envIm[l] * re[q][at];
+                            }
+                            wRe[bit][r] = sumRe;
+                            wIm[bit][r] = sumIm;
+                            p[bit] += sumRe * sumRe + sumIm * sumIm;
+                        }
+                    }
+                    const int bit = uniform(rng) * (p[0] + p[1]) < p[0] ? 0 : 1;
+                    const double scale = 1 / std::sqrt(p[bit]);
+                    for (int r = 0; r < right; ++r) {
+                        envRe[r] = wRe[bit][r] * scale;
+                        envIm[r] = wIm[bit][r] * scale;
+                    }
+                    bitstring[qubits - 1 - q] = bit ? '1' : '0';
+                }
+                ++local[bitstring];
+            }
+        }
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        for (const auto& entry : local) {
+            totals[entry.first] += entry.second;
+        }
+    };
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, chunks, 1, drawChunks);
+    } else {
+        drawChunks(0, chunks);
+    }
+    return MeasurementCounts(totals.begin(), totals.end());
+}
+
+Matrix MatrixProductState::toStateVector() const {
+    if (qubits < 1 || qubits > 30) {
+        throw std::length_error("State vector for " + std::to_string(qubits) + " qubits does not fit in a Matrix");
+    }
+    // Rows of psi run over the bits of the sites contracted so far, site 0 highest
+    Matrix psi = sites[0];
+    for (int q = 1; q < qubits; ++q) {
+        const int right = sites[q].getCols();
+        const Matrix product = Matrix::multiply(psi, reshaped(sites[q], sites[q].getRows() / 2, 2 * right), nullptr);
+        psi = reshaped(product, product.getRows() * 2, right);
+    }
+    const std::size_t dimension = std::size_t(1) << qubits;
+    Matrix result(dimension, 1);
+    for (std::size_t i = 0; i < dimension; ++i) {
+        std::size_t chain = 0;
+        for (int q = 0; q < qubits; ++q) {
+            chain |= ((i >> q) & 1) << (qubits - 1 - q);
+        }
+        result.data()[i] = psi.data()[chain];
+    }
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const MatrixProductState& state) {
+    os << state.qubits << " qubits, bonds [";
+    const std::vector<int> bonds = state.getBondDimensions();
+    for (std::size_t i = 0; i < bonds.size(); ++i) {
+        os << (i ? " " : "") << bonds[i];
+    }
+    os << "]\n" << state.stats << '\n';
+    return os;
+}
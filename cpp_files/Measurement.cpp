@@ -0,0 +1,144 @@
+#include "../h_files/Measurement.h"
+
+#include <random>
+#include <mutex>
+#include <unordered_map>
+#include <stdexcept>
+
+namespace {
+const std::uint64_t shotsPerChunk = 1 << 16;
+
+// SplitMix64 step, used to derive independent seeds for each chunk
+std::uint64_t mixSeed(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+}
+
+MeasurementSampler::MeasurementSampler(const Complex* amplitudes, int qubits)
+: MeasurementSampler([&] {
+      std::vector<double> probabilities(std::size_t(1) << qubits);
+      for (std::size_t i = 0; i < probabilities.size(); ++i) {
+          const double re = amplitudes[i].get_real(), im = amplitudes[i].get_imag();
+          probabilities[i] = re * re + im * im;
+      }
+      return probabilities;
+  }(), qubits) {}
+
+MeasurementSampler::MeasurementSampler(const std::vector<double>& probabilities, int numBits) : bits(numBits) {
+    const std::size_t n = probabilities.size();
+    if (n != std::size_t(1) << numBits) {
+        throw std::invalid_argument("Distribution size must be 2^bits");
+    }
+    double total = 0;
+    for (double p : probabilities) {
+        if (p < 0) {
+            throw std::invalid_argument("Probabilities cannot be negative");
+        }
+        total += p;
+    }
+    if (total <= 0) {
+        throw std::invalid_argument("Distribution has zero total probability");
+    }
+
+    // Vose's method: split outcomes into those below and above the mean, then pair them up
+    threshold.resize(n);
+    alias.resize(n);
+    std::vector<double> scaled(n);
+    std::vector<std::uint64_t> small, large;
+    for (std::size_t i = 0; i < n; ++i) {
+        scaled[i] = probabilities[i] * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        std::uint64_t low = small.back(), high = large.back();
+        small.pop_back();
+        threshold[low] = scaled[low];
+        alias[low] = high;
+        scaled[high] -= 1.0 - scaled[low];
+        if (scaled[high] < 1.0) {
+            large.pop_back();
+            small.push_back(high);
+        }
+    }
+    // Whatever is left is exactly 1 up to rounding
+    for (std::uint64_t i : large) {
+        threshold[i] = 1.0;
+        alias[i] = i;
+    }
+    for (std::uint64_t i : small) {
+        threshold[i] = 1.0;
+        alias[i] = i;
+    }
+}
+
+std::uint64_t MeasurementSampler::draw(double uniform) const {
+    const double scaled = uniform * threshold.size();
+    std::uint64_t column = std::min<std::uint64_t>(scaled, threshold.size() - 1);
+    return (scaled - column) < threshold[column] ? column : alias[column];
+}
+
+MeasurementCounts MeasurementSampler::sample(std::uint64_t shots, std::uint64_t seed, ThreadPool* pool) const {
+    std::unordered_map<std::uint64_t, std::uint64_t> totals;
+    std::mutex totalsMutex;
+
+    const std::size_t chunks = (shots + shotsPerChunk - 1) / shotsPerChunk;
+    auto drawChunks = [&](std::size_t begin, std::size_t end) {
+        std::unordered_map<std::uint64_t, std::uint64_t> local;
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+            std::mt19937_64 rng(mixSeed(seed ^ mixSeed(chunk)));
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            const std::uint64_t count = std::min<std::uint64_t>(shotsPerChunk, shots - chunk * shotsPerChunk);
+            for (std::uint64_t shot = 0; shot < count; ++shot) {
+                ++local[draw(uniform(rng))];
+            }
+        }
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        for (const auto& entry : local) {
+            totals[entry.first] += entry.second;
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, chunks, 1, drawChunks);
+    } else {
+        drawChunks(0, chunks);
+    }
+
+    MeasurementCounts counts;
+    for (const auto& entry : totals) {
+        counts[toBitstring(entry.first, bits)] = entry.second;
+    }
+    return counts;
+}
+
+std::vector<double> MeasurementSampler::marginalProbabilities(const Complex* amplitudes, int qubits, const std::vector<int>& measured) {
+    for (int qubit : measured) {
+        if (qubit < 0 || qubit >= qubits) {
+            throw std::out_of_range("Measured qubit out of range");
+        }
+    }
+    std::vector<double> probabilities(std::size_t(1) << measured.size(), 0.0);
+    const std::size_t dimension = std::size_t(1) << qubits;
+    for (std::size_t i = 0; i < dimension; ++i) {
+        std::size_t outcome = 0;
+        for (std::size_t bit = 0; bit < measured.size(); ++bit) {
+            outcome |= ((i >> measured[bit]) & 1) << bit;
+        }
+        const double re = amplitudes[i].get_real(), im = amplitudes[i].get_imag();
+        probabilities[outcome] += re * re + im * im;
+    }
+    return probabilities;
+}
+
+std::string MeasurementSampler::toBitstring(std::uint64_t index, int numBits) {
+    std::string bitstring(numBits, '0');
+    for (int bit = 0; bit < numBits; ++bit) {
+        if (index & (std::uint64_t(1) << bit)) {
+            bitstring[numBits - 1 - bit] = '1';
+        }
+    }
+    return bitstring;
+}
@@ -0,0 +1,110 @@
+#include "../h_files/Noise.h"
+
+#include <stdexcept>
+
+namespace {
+Matrix pauli(Complex a, Complex b, Complex c, Complex d, double scale) {
+    Matrix m(2, 2);
+    m(1, 1) = a * Complex(scale, 0);
+    m(1, 2) = b * Complex(scale, 0);
+    m(2, 1) = c * Complex(scale, 0);
+    m(2, 2) = d * Complex(scale, 0);
+    return m;
+}
+}
+
+NoiseModel::NoiseModel() : flipZeroToOne(0), flipOneToZero(0) {}
+
+void NoiseModel::addGateChannel(const std::vector<Matrix>& kraus) {
+    if (kraus.empty()) {
+        throw std::invalid_argument("Channel needs at least one Kraus operator");
+    }
+    Matrix completeness(2, 2);
+    for (const Matrix& k : kraus) {
+        if (k.getRows() != 2 || k.getCols() != 2) {
+            throw std::invalid_argument("Gate noise channels act on one qubit");
+        }
+        completeness = completeness + k.adjoint() * k;
+    }
+    const Matrix error = completeness - Matrix::identityMatrix(2);
+    for (int i = 1; i <= 2; ++i) {
+        for (int j = 1; j <= 2; ++j) {
+            if (error(i, j).modulus() > 1e-9) {
+                throw std::invalid_argument("Kraus operators are not trace preserving");
+            }
+        }
+    }
+    gateChannels.push_back(kraus);
+}
+
+void NoiseModel::setReadoutError(double zeroToOne, double oneToZero) {
+    if (zeroToOne < 0 || zeroToOne > 1 || oneToZero < 0 || oneToZero > 1) {
+        throw std::invalid_argument("Readout error probabilities must lie in [0, 1]");
+    }
+    flipZeroToOne = zeroToOne;
+    flipOneToZero = oneToZero;
+}
+
+const std::vector<std::vector<Matrix>>& NoiseModel::getGateChannels() const {
+    return gateChannels;
+}
+
+bool NoiseModel::hasGateNoise() const {
+    return !gateChannels.empty();
+}
+
+bool NoiseModel::hasReadoutError() const {
+    return flipZeroToOne > 0 || flipOneToZero > 0;
+}
+
+void NoiseModel::applyReadoutError(std::vector<double>& probabilities, int qubits) const {
+    if (!hasReadoutError()) {
+        return;
+    }
+    // Bit by bit, like a single-qubit gate on a real vector
+    for (int bit = 0; bit < qubits; ++bit) {
+        const std::size_t stride = std::size_t(1) << bit;
+        for (std::size_t block = 0; block < probabilities.size(); block += 2 * stride) {
+            for (std::size_t i = block; i < block + stride; ++i) {
+                const double zero = probabilities[i], one = probabilities[i + stride];
+                probabilities[i] = (1 - flipZeroToOne) * zero + flipOneToZero * one;
+                probabilities[i + stride] = flipZeroToOne * zero + (1 - flipOneToZero) * one;
+            }
+        }
+    }
+}
+
+std::uint64_t NoiseModel::applyReadoutError(std::uint64_t outcome, int qubits, std::mt19937_64& rng) const {
+    if (!hasReadoutError()) {
+        return outcome;
+    }
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int bit = 0; bit < qubits; ++bit) {
+        const std::uint64_t mask = std::uint64_t(1) << bit;
+        if (uniform(rng) < ((outcome & mask) ? flipOneToZero : flipZeroToOne)) {
+            outcome ^= mask;
+        }
+    }
+    return outcome;
+}
+
+std::vector<Matrix> NoiseModel::depolarizing(double p) {
+    if (p < 0 || p > 1) {
+        throw std::invalid_argument("Depolarizing probability must lie in [0, 1]");
+    }
+    const double identityWeight = std::sqrt(1 - 3 * p / 4), pauliWeight = std::sqrt(p / 4);
+    const Complex zero(0, 0), one(1, 0), i(0, 1);
+    return {pauli(one, zero, zero, one, identityWeight), pauli(zero, one, one, zero, pauliWeight),
+            pauli(zero, zero - i, i, zero, pauliWeight), pauli(one, zero, zero, zero - one, pauliWeight)};
+}
+
+std::vector<Matrix> NoiseModel::amplitudeDamping(double gamma) {
+    if (gamma < 0 || gamma > 1) {
+        throw std::invalid_argument("Damping probability must lie in [0, 1]");
+    }
+    Matrix keep(2, 2), decay(2, 2);
+    keep(1, 1) = Complex(1, 0);
+    keep(2, 2) = Complex(std::sqrt(1 - gamma), 0);
+    decay(1, 2) = Complex(std::sqrt(gamma), 0);
+    return {keep, decay};
+}
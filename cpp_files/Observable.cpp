@@ -0,0 +1,360 @@
+#include "../h_files/Observable.h"
+
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+// log2 of the amplitudes per block and per partial sum; fixed so the summation order never
+// depends on the thread count
+const int blockBits = 12;
+
+void skipSpaces(const std::string& text, std::size_t& pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+        ++pos;
+    }
+}
+
+// Reads factors such as "Z0 X12*Y3" into term, stopping at the first character that cannot
+// start a factor. Returns whether any factor was read.
+bool readFactors(const std::string& text, std::size_t& pos, PauliTerm& term) {
+    bool any = false;
+    while (true) {
+        std::size_t next = pos;
+        skipSpaces(text, next);
+        if (any && next < text.size() && text[next] == '*') {
+            ++next;
+            skipSpaces(text, next);
+        }
+        if (next >= text.size()) {
+            return any;
+        }
+        const char letter = std::toupper(static_cast<unsigned char>(text[next]));
+        if (letter != 'X' && letter != 'Y' && letter != 'Z' && letter != 'I') {
+            return any;
+        }
+        ++next;
+        if (next >= text.size() || !std::isdigit(static_cast<unsigned char>(text[next]))) {
+            if (letter != 'I') {
+                throw std::invalid_argument("Pauli factor " + std::string(1, letter) + " needs a qubit index");
+            }
+            pos = next;
+            any = true;
+            continue;
+        }
+        int qubit = 0;
+        while (next < text.size() && std::isdigit(static_cast<unsigned char>(text[next]))) {
+            qubit = qubit * 10 + (text[next] - '0');
+            if (qubit >= 64) {
+                throw std::out_of_range("Pauli strings act on qubits 0-63");
+            }
+            ++next;
+        }
+        pos = next;
+        any = true;
+        if (letter == 'I') {
+            continue;
+        }
+        const std::uint64_t bit = std::uint64_t(1) << qubit;
+        if ((term.xMask | term.zMask) & bit) {
+            throw std::invalid_argument("Qubit " + std::to_string(qubit) + " appears twice in a Pauli string");
+        }
+        if (letter != 'Z') {
+            term.xMask |= bit;
+        }
+        if (letter != 'X') {
+            term.zMask |= bit;
+        }
+    }
+}
+
+inline bool oddParity(std::uint64_t value) {
+    return __builtin_parityll(value);
+}
+}
+
+PauliObservable PauliObservable::parse(const std::string& text) {
+    PauliObservable observable;
+    std::size_t pos = 0;
+    bool first = true;
+    while (true) {
+        skipSpaces(text, pos);
+        if (pos >= text.size()) {
+            if (first) {
+                throw std::invalid_argument("Observable has no terms");
+            }
+            return observable;
+        }
+
+        double sign = 1;
+        if (text[pos] == '+' || text[pos] == '-') {
+            sign = text[pos] == '-' ? -1 : 1;
+            ++pos;
+            skipSpaces(text, pos);
+        } else if (!first) {
+            throw std::invalid_argument("Expected + or - at position " + std::to_string(pos) + " of the observable");
+        }
+
+        PauliTerm term{sign, 0, 0};
+        bool hasCoefficient = false;
+        if (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '.')) {
+            char* end = nullptr;
+            term.coefficient *= std::strtod(text.c_str() + pos, &end);
+            pos = end - text.c_str();
+            hasCoefficient = true;
+            skipSpaces(text, pos);
+            if (pos < text.size() && text[pos] == '*') {
+                ++pos;
+            }
+        }
+        if (!readFactors(text, pos, term) && !hasCoefficient) {
+            throw std::invalid_argument("Expected a Pauli term at position " + std::to_string(pos) + " of the observable");
+        }
+        observable.addTerm(term);
+        first = false;
+    }
+}
+
+void PauliObservable::addTerm(double coefficient, const std::string& paulis) {
+    PauliTerm term{coefficient, 0, 0};
+    std::size_t pos = 0;
+    readFactors(paulis, pos, term);
+    skipSpaces(paulis, pos);
+    if (pos != paulis.size()) {
+        throw std::invalid_argument("Invalid Pauli string \"" + paulis + "\"");
+    }
+    addTerm(term);
+}
+
+void PauliObservable::addTerm(const PauliTerm& term) {
+    const auto key = std::make_pair(term.xMask, term.zMask);
+    auto it = termIndex.find(key);
+    if (it == termIndex.end()) {
+        termIndex.emplace(key, terms.size());
+        terms.push_back(term);
+    } else {
+        terms[it->second].coefficient += term.coefficient;
+    }
+}
+
+const std::vector<PauliTerm>& PauliObservable::getTerms() const {
+    return terms;
+}
+
+int PauliObservable::getQubits() const {
+    std::uint64_t used = 0;
+    for (const PauliTerm& term : terms) {
+        used |= term.xMask | term.zMask;
+    }
+    int qubits = 0;
+    while (qubits < 64 && (used >> qubits) != 0) {
+        ++qubits;
+    }
+    return qubits;
+}
+
+std::size_t PauliObservable::getGroupCount() const {
+    return groups().size();
+}
+
+std::vector<PauliObservable::Group> PauliObservable::groups() const {
+    // i^(number of Y) for Y = iXZ
+    static const double yPhaseReal[4] = {1, 0, -1, 0};
+    static const double yPhaseImag[4] = {0, 1, 0, -1};
+    std::map<std::uint64_t, Group> byMask;
+    for (const PauliTerm& term : terms) {
+        if (term.coefficient == 0) {
+            continue;
+        }
+        Group& group = byMask[term.xMask];
+        group.xMask = term.xMask;
+        group.zMasks.push_back(term.zMask);
+        const int yCount = __builtin_popcountll(term.xMask & term.zMask) % 4;
+        group.weightReal.push_back(term.coefficient * yPhaseReal[yCount]);
+        group.weightImag.push_back(term.coefficient * yPhaseImag[yCount]);
+    }
+    std::vector<Group> result;
+    for (auto& entry : byMask) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+void PauliObservable::blockWeights(const Group& group, std::uint64_t high, int bits, std::vector<double>& real, std::vector<double>& imag) {
+    const std::size_t size = std::size_t(1) << bits;
+    const std::uint64_t lowMask = size - 1;
+    real.assign(size, 0.0);
+    imag.assign(size, 0.0);
+    const std::size_t termCount = group.zMasks.size();
+    // Fold the high bits into each coefficient, bucket by the low part of the Z mask, then
+    // w(low) = sum_m c[m] (-1)^popcount(low & m) is the unnormalized Walsh-Hadamard transform
+    for (std::size_t t = 0; t < termCount; ++t) {
+        const double sign = oddParity(high & group.zMasks[t]) ? -1.0 : 1.0;
+        real[group.zMasks[t] & lowMask] += sign * group.weightReal[t];
+        imag[group.zMasks[t] & lowMask] += sign * group.weightImag[t];
+    }
+    for (std::size_t half = 1; half < size; half <<= 1) {
+        for (std::size_t first = 0; first < size; first += 2 * half) {
+            for (std::size_t j = first; j < first + half; ++j) {
+                const double re0 = real[j], im0 = imag[j];
+                real[j] = re0 + real[j + half];
+                imag[j] = im0 + imag[j + half];
+                real[j + half] = re0 - real[j + half];
+                imag[j + half] = im0 - imag[j + half];
+            }
+        }
+    }
+}
+
+void PauliObservable::checkQubits(int qubits) const {
+    if (qubits < 1 || qubits > 62 || getQubits() > qubits) {
+        throw std::invalid_argument("Observable acts on qubits outside the state");
+    }
+}
+
+double PauliObservable::expectation(const Complex* amplitudes, int qubits, ThreadPool* pool) const {
+    checkQubits(qubits);
+    const int bits = std::min(qubits, blockBits);
+    const std::size_t size = std::size_t(1) << bits;
+    const std::size_t blocks = std::size_t(1) << (qubits - bits);
+    std::vector<double> partial(blocks, 0.0);
+
+    // One sweep per group of Re sum_i conj(psi[i ^ x]) psi[i] w(i); each block's partial sum
+    // takes the groups in the same order whatever the thread count
+    for (const Group& group : groups()) {
+        const bool useTable = group.zMasks.size() > std::size_t(bits);
+        auto sumBlocks = [&](std::size_t begin, std::size_t end) {
+            std::vector<double> tableReal, tableImag;
+            for (std::size_t block = begin; block < end; ++block) {
+                const std::size_t first = block * size;
+                if (useTable) {
+                    blockWeights(group, first, bits, tableReal, tableImag);
+                }
+                double sum = 0;
+                for (std::size_t low = 0; low < size; ++low) {
+                    const std::size_t i = first + low;
+                    double weightReal = 0, weightImag = 0;
+                    if (useTable) {
+                        weightReal = tableReal[low];
+                        weightImag = tableImag[low];
+                    } else {
+                        for (std::size_t t = 0; t < group.zMasks.size(); ++t) {
+                            const double sign = oddParity(i & group.zMasks[t]) ? -1.0 : 1.0;
+                            weightReal += sign * group.weightReal[t];
+                            weightImag += sign * group.weightImag[t];
+                        }
+                    }
+                    const Complex& a = amplitudes[i ^ group.xMask];
+                    const Complex& b = amplitudes[i];
+                    const double aReal = a.get_real(), aImag = a.get_imag(), bReal = b.get_real(), bImag = b.get_imag();
+                    sum += (aReal * bReal + aImag * bImag) * weightReal - (aReal * bImag - aImag * bReal) * weightImag;
+                }
+                partial[block] += sum;
+            }
+        };
+        if (pool && pool->size() > 1) {
+            pool->parallelFor(0, blocks, 1, sumBlocks);
+        } else {
+            sumBlocks(0, blocks);
+        }
+    }
+
+    double total = 0;
+    for (double value : partial) {
+        total += value;
+    }
+    return total;
+}
+
+void PauliObservable::apply(const Complex* amplitudes, Complex* output, int qubits, ThreadPool* pool) const {
+    checkQubits(qubits);
+    if (amplitudes == output) {
+        throw std::invalid_argument("Observable output must not alias its input");
+    }
+    const int bits = std::min(qubits, blockBits);
+    const std::size_t size = std::size_t(1) << bits;
+    const std::size_t blocks = std::size_t(1) << (qubits - bits);
+    const std::uint64_t lowMask = size - 1;
+    std::fill(output, output + (std::size_t(1) << qubits), Complex(0, 0));
+
+    // (H psi)[j] = sum over groups of w(j ^ x) psi[j ^ x]; every output block is written by one thread
+    for (const Group& group : groups()) {
+        const bool useTable = group.zMasks.size() > std::size_t(bits);
+        auto applyBlocks = [&](std::size_t begin, std::size_t end) {
+            std::vector<double> tableReal, tableImag;
+            for (std::size_t block = begin; block < end; ++block) {
+                const std::size_t first = block * size;
+                // The sources j ^ x all lie in one block, whose table is indexed by low ^ (x & lowMask)
+                if (useTable) {
+                    blockWeights(group, first ^ (group.xMask & ~lowMask), bits, tableReal, tableImag);
+                }
+                for (std::size_t low = 0; low < size; ++low) {
+                    const std::size_t source = (first + low) ^ group.xMask;
+                    double weightReal = 0, weightImag = 0;
+                    if (useTable) {
+                        weightReal = tableReal[source & lowMask];
+                        weightImag = tableImag[source & lowMask];
+                    } else {
+                        for (std::size_t t = 0; t < group.zMasks.size(); ++t) {
+                            const double sign = oddParity(source & group.zMasks[t]) ? -1.0 : 1.0;
+                            weightReal += sign * group.weightReal[t];
+                            weightImag += sign * group.weightImag[t];
+                        }
+                    }
+                    output[first + low] += Complex(weightReal, weightImag) * amplitudes[source];
+                }
+            }
+        };
+        if (pool && pool->size() > 1) {
+            pool->parallelFor(0, blocks, 1, applyBlocks);
+        } else {
+            applyBlocks(0, blocks);
+        }
+    }
+}
+
+Matrix PauliObservable::toMatrix(int qubits) const {
+    checkQubits(qubits);
+    if (qubits > 14) {
+        throw std::length_error("Dense observable for " + std::to_string(qubits) + " qubits is too large");
+    }
+    const int dimension = 1 << qubits;
+    Matrix result(dimension, dimension);
+    for (const Group& group : groups()) {
+        for (int i = 0; i < dimension; ++i) {
+            for (std::size_t t = 0; t < group.zMasks.size(); ++t) {
+                const double sign = oddParity(i & group.zMasks[t]) ? -1.0 : 1.0;
+                result(int(i ^ group.xMask) + 1, i + 1) += Complex(sign * group.weightReal[t], sign * group.weightImag[t]);
+            }
+        }
+    }
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const PauliObservable& observable) {
+    bool first = true;
+    for (const PauliTerm& term : observable.terms) {
+        double coefficient = term.coefficient;
+        if (!first) {
+            os << (coefficient < 0 ? " - " : " + ");
+            coefficient = std::abs(coefficient);
+        }
+        os << coefficient;
+        if (term.xMask | term.zMask) {
+            os << '*';
+        }
+        for (int q = 0; q < 64; ++q) {
+            const bool x = (term.xMask >> q) & 1, z = (term.zMask >> q) & 1;
+            if (x || z) {
+                os << (x && z ? 'Y' : x ? 'X' : 'Z') << q;
+            }
+        }
+        first = false;
+    }
+    if (first) {
+        os << 0;
+    }
+    return os;
+}
@@ -0,0 +1,270 @@
+#include "../h_files/OutOfCore.h"
+#include "../h_files/StateVector.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+namespace {
+// rusage block counts are in 512-byte units
+void diskCounters(std::uint64_t& read, std::uint64_t& written) {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    read = std::uint64_t(usage.ru_inblock) * 512;
+    written = std::uint64_t(usage.ru_oublock) * 512;
+}
+
+std::runtime_error systemError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+}
+
+std::ostream& operator<<(std::ostream& os, const OutOfCoreStatistics& stats) {
+    os << "Out-of-core: " << stats.passes << " passes, " << stats.swaps << " block swaps, "
+       << stats.bytesRead / 1048576.0 << " MiB read, " << stats.bytesWritten / 1048576.0 << " MiB written (disk: "
+       << stats.diskBytesRead / 1048576.0 << " MiB in, " << stats.diskBytesWritten / 1048576.0 << " MiB out)";
+    return os;
+}
+
+OutOfCoreStateVector::OutOfCoreStateVector(const std::string& path, int qubits, int blockQubits)
+: path(path), qubits(qubits), blockQubits(std::min(blockQubits, qubits)), fd(-1), bytes(0), amplitudes(nullptr), current(nullptr) {
+    if (qubits < 1 || qubits > 48 || blockQubits < 1) {
+        throw std::invalid_argument("Out-of-core state needs 1-48 qubits and at least one block qubit");
+    }
+    bytes = (std::size_t(1) << qubits) * sizeof(Complex);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw systemError("Cannot create", path);
+    }
+    // The file starts sparse and zero-filled; pages are allocated as the gates write them
+    if (::ftruncate(fd, off_t(bytes)) != 0) {
+        ::close(fd);
+        throw systemError("Cannot size", path);
+    }
+    void* mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        throw systemError("Cannot map", path);
+    }
+    amplitudes = static_cast<Complex*>(mapping);
+    amplitudes[0] = Complex(1, 0);
+
+    position.resize(qubits);
+    logicalAt.resize(qubits);
+    for (int q = 0; q < qubits; ++q) {
+        position[q] = logicalAt[q] = q;
+    }
+}
+
+OutOfCoreStateVector::~OutOfCoreStateVector() {
+    ::munmap(amplitudes, bytes);
+    ::close(fd);
+}
+
+int OutOfCoreStateVector::getQubits() const {
+    return qubits;
+}
+
+int OutOfCoreStateVector::getBlockQubits() const {
+    return blockQubits;
+}
+
+OutOfCoreStatistics OutOfCoreStateVector::run(const std::vector<GateOperation>& operations, ThreadPool* pool, bool restoreOrder) {
+    OutOfCoreStatistics stats;
+    current = &stats;
+    std::uint64_t readBefore, writtenBefore;
+    diskCounters(readBefore, writtenBefore);
+
+    // Position of the next operation that targets a logical qubit, for choosing which low qubit to evict
+    auto nextUse = [&](int logical, std::size_t after) {
+        for (std::size_t k = after; k < operations.size(); ++k) {
+            const std::vector<int>& targets = operations[k].targets;
+            if (std::find(targets.begin(), targets.end(), logical) != targets.end()) {
+                return k;
+            }
+        }
+        return operations.size();
+    };
+
+    std::vector<GateOperation> pass;
+    for (std::size_t k = 0; k < operations.size(); ++k) {
+        const GateOperation& op = operations[k];
+        if (int(op.targets.size()) > blockQubits) {
+            throw std::invalid_argument("Operation has more targets than the block has qubits");
+        }
+        for (const std::vector<int>* list : {&op.targets, &op.controls}) {
+            for (int qubit : *list) {
+                if (qubit < 0 || qubit >= qubits) {
+                    throw std::out_of_range("Gate qubit out of range");
+                }
+            }
+        }
+
+        for (int target : op.targets) {
+            if (position[target] < blockQubits) {
+                continue;
+            }
+            // A swap changes the layout, so the gates gathered so far go first
+            applyPass(pass, pool);
+            pass.clear();
+
+            int victim = -1;
+            std::size_t furthest = 0;
+            for (int low = 0; low < blockQubits; ++low) {
+                const int logical = logicalAt[low];
+                if (std::find(op.targets.begin(), op.targets.end(), logical) != op.targets.end()) {
+                    continue;
+                }
+                const std::size_t use = nextUse(logical, k);
+                if (victim < 0 || use > furthest) {
+                    victim = low;
+                    furthest = use;
+                }
+            }
+            const int high = position[target];
+            swapQubits(high, victim, pool);
+            swapLog.emplace_back(high, victim);
+        }
+
+        GateOperation physical{op.matrix, op.targets, op.controls};
+        for (int& target : physical.targets) {
+            target = position[target];
+        }
+        for (int& control : physical.controls) {
+            control = position[control];
+        }
+        pass.push_back(std::move(physical));
+    }
+    applyPass(pass, pool);
+
+    if (restoreOrder) {
+        restoreQubitOrder(pool);
+    }
+    ::msync(amplitudes, bytes, MS_SYNC);
+
+    std::uint64_t readAfter, writtenAfter;
+    diskCounters(readAfter, writtenAfter);
+    stats.diskBytesRead = readAfter - readBefore;
+    stats.diskBytesWritten = writtenAfter - writtenBefore;
+    current = nullptr;
+    return stats;
+}
+
+void OutOfCoreStateVector::applyPass(const std::vector<GateOperation>& pass, ThreadPool* pool) {
+    if (pass.empty()) {
+        return;
+    }
+    // Controls on high qubits select whole blocks; the rest of each op acts inside a block
+    std::vector<GateOperation> local;
+    std::vector<std::uint64_t> blockMask;
+    for (const GateOperation& op : pass) {
+        GateOperation inBlock{op.matrix, op.targets, {}};
+        std::uint64_t mask = 0;
+        for (int control : op.controls) {
+            if (control < blockQubits) {
+                inBlock.controls.push_back(control);
+            } else {
+                mask |= std::uint64_t(1) << (control - blockQubits);
+            }
+        }
+        local.push_back(std::move(inBlock));
+        blockMask.push_back(mask);
+    }
+
+    const std::uint64_t blocks = std::uint64_t(1) << (qubits - blockQubits);
+    const std::size_t blockSize = std::size_t(1) << blockQubits;
+    for (std::uint64_t block = 0; block < blocks; ++block) {
+        bool touched = false;
+        for (std::size_t i = 0; i < local.size(); ++i) {
+            if ((block & blockMask[i]) == blockMask[i]) {
+                StateVectorSimulator::applyOperation(amplitudes + block * blockSize, blockQubits, local[i], pool);
+                touched = true;
+            }
+        }
+        if (touched && current) {
+            current->bytesRead += blockSize * sizeof(Complex);
+            current->bytesWritten += blockSize * sizeof(Complex);
+        }
+    }
+    if (current) {
+        ++current->passes;
+    }
+}
+
+void OutOfCoreStateVector::swapQubits(int high, int low, ThreadPool* pool) {
+    const std::size_t blockSize = std::size_t(1) << blockQubits;
+    const std::uint64_t blockBit = std::uint64_t(1) << (high - blockQubits);
+    const std::uint64_t blocks = std::uint64_t(1) << (qubits - blockQubits);
+    const std::size_t lowBit = std::size_t(1) << low;
+
+    // Amplitudes with (high, low) = (0, 1) trade places with those at (1, 0)
+    for (std::uint64_t first = 0; first < blocks; ++first) {
+        if (first & blockBit) {
+            continue;
+        }
+        Complex* zeroHalf = amplitudes + first * blockSize;
+        Complex* oneHalf = amplitudes + (first | blockBit) * blockSize;
+        auto exchange = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t j = begin; j < end; ++j) {
+                const std::size_t i = ((j >> low) << (low + 1)) | lowBit | (j & (lowBit - 1));
+                std::swap(zeroHalf[i], oneHalf[i ^ lowBit]);
+            }
+        };
+        const std::size_t pairs = blockSize / 2;
+        if (pool && pool->size() > 1) {
+            pool->parallelFor(0, pairs, StateVectorSimulator::chunkSize(pairs, lowBit, pool->size()), exchange);
+        } else {
+            exchange(0, pairs);
+        }
+        if (current) {
+            current->bytesRead += 2 * blockSize * sizeof(Complex);
+            current->bytesWritten += 2 * blockSize * sizeof(Complex);
+        }
+    }
+    if (current) {
+        ++current->swaps;
+    }
+
+    std::swap(logicalAt[high], logicalAt[low]);
+    position[logicalAt[high]] = high;
+    position[logicalAt[low]] = low;
+}
+
+void OutOfCoreStateVector::restoreQubitOrder(ThreadPool* pool) {
+    // Each swap is its own inverse
+    for (auto it = swapLog.rbegin(); it != swapLog.rend(); ++it) {
+        swapQubits(it->first, it->second, pool);
+    }
+    swapLog.clear();
+}
+
+std::uint64_t OutOfCoreStateVector::physicalIndex(std::uint64_t logical) const {
+    std::uint64_t physical = 0;
+    for (int q = 0; q < qubits; ++q) {
+        if (logical & (std::uint64_t(1) << q)) {
+            physical |= std::uint64_t(1) << position[q];
+        }
+    }
+    return physical;
+}
+
+Complex OutOfCoreStateVector::amplitude(std::uint64_t index) const {
+    if (index >> qubits) {
+        throw std::out_of_range("Basis state out of range");
+    }
+    return amplitudes[physicalIndex(index)];
+}
+
+double OutOfCoreStateVector::norm() const {
+    double sum = 0;
+    for (std::size_t i = 0; i < bytes / sizeof(Complex); ++i) {
+        sum += amplitudes[i].get_real() * amplitudes[i].get_real() + amplitudes[i].get_imag() * amplitudes[i].get_imag();
+    }
+    return std::sqrt(sum);
+}
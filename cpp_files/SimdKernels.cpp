@@ -0,0 +1,179 @@
+#include "../h_files/SimdKernels.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void scalarAxpy(std::size_t begin, std::size_t n, double ar, double ai,
+                const double* xr, const double* xi, double* yr, double* yi) {
+    for (std::size_t k = begin; k < n; ++k) {
+        yr[k] += ar * xr[k] - ai * xi[k];
+        yi[k] += ar * xi[k] + ai * xr[k];
+    }
+}
+
+void scalarScale(std::size_t begin, std::size_t n, double ar, double ai,
+                 const double* xr, const double* xi, double* outR, double* outI) {
+    for (std::size_t k = begin; k < n; ++k) {
+        double re = ar * xr[k] - ai * xi[k];
+        double im = ar * xi[k] + ai * xr[k];
+        outR[k] = re;
+        outI[k] = im;
+    }
+}
+
+void scalarPairs(std::size_t begin, std::size_t n, const double u[8],
+                 double* x0r, double* x0i, double* x1r, double* x1i) {
+    for (std::size_t k = begin; k < n; ++k) {
+        const double ar = x0r[k], ai = x0i[k], br = x1r[k], bi = x1i[k];
+        x0r[k] = u[0] * ar - u[1] * ai + u[2] * br - u[3] * bi;
+        x0i[k] = u[0] * ai + u[1] * ar + u[2] * bi + u[3] * br;
+        x1r[k] = u[4] * ar - u[5] * ai + u[6] * br - u[7] * bi;
+        x1i[k] = u[4] * ai + u[5] * ar + u[6] * bi + u[7] * br;
+    }
+}
+
+}
+
+#if defined(__AVX512F__)
+
+void SimdKernels::complexAxpy(std::size_t n, double aReal, double aImag,
+                              const double* xReal, const double* xImag, double* yReal, double* yImag) {
+    const __m512d ar = _mm512_set1_pd(aReal), ai = _mm512_set1_pd(aImag);
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512d xr = _mm512_loadu_pd(xReal + k), xi = _mm512_loadu_pd(xImag + k);
+        __m512d yr = _mm512_loadu_pd(yReal + k), yi = _mm512_loadu_pd(yImag + k);
+        yr = _mm512_fmadd_pd(ar, xr, _mm512_fnmadd_pd(ai, xi, yr));
+        yi = _mm512_fmadd_pd(ar, xi, _mm512_fmadd_pd(ai, xr, yi));
+        _mm512_storeu_pd(yReal + k, yr);
+        _mm512_storeu_pd(yImag + k, yi);
+    }
+    scalarAxpy(k, n, aReal, aImag, xReal, xImag, yReal, yImag);
+}
+
+void SimdKernels::complexScale(std::size_t n, double aReal, double aImag,
+                               const double* xReal, const double* xImag, double* outReal, double* outImag) {
+    const __m512d ar = _mm512_set1_pd(aReal), ai = _mm512_set1_pd(aImag);
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512d xr = _mm512_loadu_pd(xReal + k), xi = _mm512_loadu_pd(xImag + k);
+        _mm512_storeu_pd(outReal + k, _mm512_fmsub_pd(ar, xr, _mm512_mul_pd(ai, xi)));
+        _mm512_storeu_pd(outImag + k, _mm512_fmadd_pd(ar, xi, _mm512_mul_pd(ai, xr)));
+    }
+    scalarScale(k, n, aReal, aImag, xReal, xImag, outReal, outImag);
+}
+
+void SimdKernels::pairUpdate(std::size_t n, const double u[8],
+                             double* x0Real, double* x0Imag, double* x1Real, double* x1Imag) {
+    const __m512d u0r = _mm512_set1_pd(u[0]), u0i = _mm512_set1_pd(u[1]);
+    const __m512d u1r = _mm512_set1_pd(u[2]), u1i = _mm512_set1_pd(u[3]);
+    const __m512d u2r = _mm512_set1_pd(u[4]), u2i = _mm512_set1_pd(u[5]);
+    const __m512d u3r = _mm512_set1_pd(u[6]), u3i = _mm512_set1_pd(u[7]);
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m512d ar = _mm512_loadu_pd(x0Real + k), ai = _mm512_loadu_pd(x0Imag + k);
+        __m512d br = _mm512_loadu_pd(x1Real + k), bi = _mm512_loadu_pd(x1Imag + k);
+        __m512d r0 = _mm512_fmsub_pd(u0r, ar, _mm512_mul_pd(u0i, ai));
+        __m512d i0 = _mm512_fmadd_pd(u0r, ai, _mm512_mul_pd(u0i, ar));
+        r0 = _mm512_add_pd(r0, _mm512_fmsub_pd(u1r, br, _mm512_mul_pd(u1i, bi)));
+        i0 = _mm512_add_pd(i0, _mm512_fmadd_pd(u1r, bi, _mm512_mul_pd(u1i, br)));
+        __m512d r1 = _mm512_fmsub_pd(u2r, ar, _mm512_mul_pd(u2i, ai));
+        __m512d i1 = _mm512_fmadd_pd(u2r, ai, _mm512_mul_pd(u2i, ar));
+        r1 = _mm512_add_pd(r1, _mm512_fmsub_pd(u3r, br, _mm512_mul_pd(u3i, bi)));
+        i1 = _mm512_add_pd(i1, _mm512_fmadd_pd(u3r, bi, _mm512_mul_pd(u3i, br)));
+        _mm512_storeu_pd(x0Real + k, r0);
+        _mm512_storeu_pd(x0Imag + k, i0);
+        _mm512_storeu_pd(x1Real + k, r1);
+        _mm512_storeu_pd(x1Imag + k, i1);
+    }
+    scalarPairs(k, n, u, x0Real, x0Imag, x1Real, x1Imag);
+}
+
+const char* SimdKernels::instructionSet() {
+    return "AVX-512";
+}
+
+#elif defined(__AVX2__)
+
+void SimdKernels::complexAxpy(std::size_t n, double aReal, double aImag,
+                              const double* xReal, const double* xImag, double* yReal, double* yImag) {
+    const __m256d ar = _mm256_set1_pd(aReal), ai = _mm256_set1_pd(aImag);
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256d xr = _mm256_loadu_pd(xReal + k), xi = _mm256_loadu_pd(xImag + k);
+        __m256d yr = _mm256_loadu_pd(yReal + k), yi = _mm256_loadu_pd(yImag + k);
+        yr = _mm256_add_pd(yr, _mm256_sub_pd(_mm256_mul_pd(ar, xr), _mm256_mul_pd(ai, xi)));
+        yi = _mm256_add_pd(yi, _mm256_add_pd(_mm256_mul_pd(ar, xi), _mm256_mul_pd(ai, xr)));
+        _mm256_storeu_pd(yReal + k, yr);
+        _mm256_storeu_pd(yImag + k, yi);
+    }
+    scalarAxpy(k, n, aReal, aImag, xReal, xImag, yReal, yImag);
+}
+
+void SimdKernels::complexScale(std::size_t n, double aReal, double aImag,
+                               const double* xReal, const double* xImag, double* outReal, double* outImag) {
+    const __m256d ar = _mm256_set1_pd(aReal), ai = _mm256_set1_pd(aImag);
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256d xr = _mm256_loadu_pd(xReal + k), xi = _mm256_loadu_pd(xImag + k);
+        _mm256_storeu_pd(outReal + k, _mm256_sub_pd(_mm256_mul_pd(ar, xr), _mm256_mul_pd(ai, xi)));
+        _mm256_storeu_pd(outImag + k, _mm256_add_pd(_mm256_mul_pd(ar, xi), _mm256_mul_pd(ai, xr)));
+    }
+    scalarScale(k, n, aReal, aImag, xReal, xImag, outReal, outImag);
+}
+
+void SimdKernels::pairUpdate(std::size_t n, const double u[8],
+                             double* x0Real, double* x0Imag, double* x1Real, double* x1Imag) {
+    const __m256d u0r = _mm256_set1_pd(u[0]), u0i = _mm256_set1_pd(u[1]);
+    const __m256d u1r = _mm256_set1_pd(u[2]), u1i = _mm256_set1_pd(u[3]);
+    const __m256d u2r = _mm256_set1_pd(u[4]), u2i = _mm256_set1_pd(u[5]);
+    const __m256d u3r = _mm256_set1_pd(u[6]), u3i = _mm256_set1_pd(u[7]);
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256d ar = _mm256_loadu_pd(x0Real + k), ai = _mm256_loadu_pd(x0Imag + k);
+        __m256d br = _mm256_loadu_pd(x1Real + k), bi = _mm256_loadu_pd(x1Imag + k);
+        __m256d r0 = _mm256_sub_pd(_mm256_mul_pd(u0r, ar), _mm256_mul_pd(u0i, ai));
+        __m256d i0 = _mm256_add_pd(_mm256_mul_pd(u0r, ai), _mm256_mul_pd(u0i, ar));
+        r0 = _mm256_add_pd(r0, _mm256_sub_pd(_mm256_mul_pd(u1r, br), _mm256_mul_pd(u1i, bi)));
+        i0 = _mm256_add_pd(i0, _mm256_add_pd(_mm256_mul_pd(u1r, bi), _mm256_mul_pd(u1i, br)));
+        __m256d r1 = _mm256_sub_pd(_mm256_mul_pd(u2r, ar), _mm256_mul_pd(u2i, ai));
+        __m256d i1 = _mm256_add_pd(_mm256_mul_pd(u2r, ai), _mm256_mul_pd(u2i, ar));
+        r1 = _mm256_add_pd(r1, _mm256_sub_pd(_mm256_mul_pd(u3r, br), _mm256_mul_pd(u3i, bi)));
+        i1 = _mm256_add_pd(i1, _mm256_add_pd(_mm256_mul_pd(u3r, bi), _mm256_mul_pd(u3i, br)));
+        _mm256_storeu_pd(x0Real + k, r0);
+        _mm256_storeu_pd(x0Imag + k, i0);
+        _mm256_storeu_pd(x1Real + k, r1);
+        _mm256_storeu_pd(x1Imag + k, i1);
+    }
+    scalarPairs(k, n, u, x0Real, x0Imag, x1Real, x1Imag);
+}
+
+const char* SimdKernels::instructionSet() {
+    return "AVX2";
+}
+
+#else
+
+void SimdKernels::complexAxpy(std::size_t n, double aReal, double aImag,
+                              const double* xReal, const double* xImag, double* yReal, double* yImag) {
+    scalarAxpy(0, n, aReal, aImag, xReal, xImag, yReal, yImag);
+}
+
+void SimdKernels::complexScale(std::size_t n, double aReal, double aImag,
+                               const double* xReal, const double* xImag, double* outReal, double* outImag) {
+    scalarScale(0, n, aReal, aImag, xReal, xImag, outReal, outImag);
+}
+
+void SimdKernels::pairUpdate(std::size_t n, const double u[8],
+                             double* x0Real, double* x0Imag, double* x1Real, double* x1Imag) {
+    scalarPairs(0, n, u, x0Real, x0Imag, x1Real, x1Imag);
+}
+
+const char* SimdKernels::instructionSet() {
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "../h_files/SplitComplex.h"
+#include "../h_files/MatrixAllocator.h"
+
+#include <cstring>
+
+namespace {
+// Zeroed storage for n doubles; the allocator's buffers are 64-byte aligned
+double* allocateZeroed(MatrixAllocator* allocator, std::size_t n) {
+    if (n == 0) {
+        return nullptr;
+    }
+    void* memory = allocator->allocate(n * sizeof(double));
+    std::memset(memory, 0, n * sizeof(double));
+    return static_cast<double*>(memory);
+}
+}
+
+SplitComplexArray::SplitComplexArray(std::size_t n)
+: length(n), allocator(&MatrixAllocator::current()), realData(allocateZeroed(allocator, n)), imagData(nullptr) {
+    try {
+        imagData = allocateZeroed(allocator, n);
+    } catch (...) {
+        releaseStorage();
+        throw;
+    }
+}
+
+SplitComplexArray::SplitComplexArray(const Complex* values, std::size_t n) : SplitComplexArray(n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        realData[i] = values[i].get_real();
+        imagData[i] = values[i].get_imag();
+    }
+}
+
+SplitComplexArray::SplitComplexArray(const SplitComplexArray& other) : SplitComplexArray(other.length) {
+    if (length > 0) {
+        std::memcpy(realData, other.realData, length * sizeof(double));
+        std::memcpy(imagData, other.imagData, length * sizeof(double));
+    }
+}
+
+SplitComplexArray::SplitComplexArray(SplitComplexArray&& other)
+: length(other.length), allocator(other.allocator), realData(other.realData), imagData(other.imagData) {
+    other.length = 0;
+    other.realData = nullptr;
+    other.imagData = nullptr;
+}
+
+SplitComplexArray::~SplitComplexArray() {
+    releaseStorage();
+}
+
+void SplitComplexArray::releaseStorage() {
+    for (double* part : {realData, imagData}) {
+        if (part) {
+            allocator->deallocate(part, length * sizeof(double));
+        }
+    }
+    realData = imagData = nullptr;
+}
+
+SplitComplexArray& SplitComplexArray::operator=(const SplitComplexArray& other) {
+    if (this != &other) {
+        SplitComplexArray copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+SplitComplexArray& SplitComplexArray::operator=(SplitComplexArray&& other) {
+    if (this != &other) {
+        releaseStorage();
+        length = other.length;
+        allocator = other.allocator;
+        realData = other.realData;
+        imagData = other.imagData;
+        other.length = 0;
+        other.realData = nullptr;
+        other.imagData = nullptr;
+    }
+    return *this;
+}
+
+std::size_t SplitComplexArray::size() const {
+    return length;
+}
+
+double* SplitComplexArray::real() {
+    return realData;
+}
+
+double* SplitComplexArray::imag() {
+    return imagData;
+}
+
+const double* SplitComplexArray::real() const {
+    return realData;
+}
+
+const double* SplitComplexArray::imag() const {
+    return imagData;
+}
+
+Complex SplitComplexArray::get(std::size_t index) const {
+    return Complex(realData[index], imagData[index]);
+}
+
+void SplitComplexArray::set(std::size_t index, const Complex& value) {
+    realData[index] = value.get_real();
+    imagData[index] = value.get_imag();
+}
+
+void SplitComplexArray::copyTo(Complex* values) const {
+    for (std::size_t i = 0; i < length; ++i) {
+        values[i] = Complex(realData[i], imagData[i]);
+    }
+}
@@ -0,0 +1,468 @@
+#include "../h_files/Stabilizer.h"
+
+#include <map>
+#include <mutex>
+#include <random>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+const std::uint64_t shotsPerChunk = 1024;
+
+std::uint64_t mixSeed(std::uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+bool sameUpToPhase(const Matrix& a, const Matrix& b) {
+    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+        return false;
+    }
+    const int size = a.getRows() * a.getCols();
+    int reference = 0;
+    while (reference < size && b.data()[reference].modulus() < 1e-9) {
+        ++reference;
+    }
+    if (reference == size || a.data()[reference].modulus() < 1e-9) {
+        return false;
+    }
+    const Complex ratio = a.data()[reference] / b.data()[reference];
+    if (std::abs(ratio.modulus() - 1) > 1e-9) {
+        return false;
+    }
+    for (int i = 0; i < size; ++i) {
+        if ((a.data()[i] - ratio * b.data()[i]).modulus() > 1e-9) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameMatrix(const Matrix& a, const Matrix& b) {
+    if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+        return false;
+    }
+    for (int i = 0; i < a.getRows() * a.getCols(); ++i) {
+        if ((a.data()[i] - b.data()[i]).modulus() > 1e-9) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The 24 single-qubit Cliffords modulo phase, each as the H/S sequence that builds it
+struct CliffordWord {
+    Matrix matrix;
+    std::string gates;
+};
+
+const std::vector<CliffordWord>& singleQubitCliffords() {
+    static const std::vector<CliffordWord> table = [] {
+        const Matrix& h = QuantumComponentFactory::create(GateId::Hadamard)->getMatrixRef();
+        const Matrix& s = QuantumComponentFactory::create(GateId::SGate)->getMatrixRef();
+        std::vector<CliffordWord> words{{Matrix::identityMatrix(2), ""}};
+        // Breadth first, so every element gets one of its shortest words
+        for (std::size_t next = 0; next < words.size(); ++next) {
+            for (char gate : {'H', 'S'}) {
+                Matrix product = (gate == 'H' ? h : s) * words[next].matrix;
+                bool known = false;
+                for (const CliffordWord& word : words) {
+                    known = known || sameUpToPhase(product, word.matrix);
+                }
+                if (!known) {
+                    words.push_back({product, words[next].gates + gate});
+                }
+            }
+        }
+        return words;
+    }();
+    return table;
+}
+
+const CliffordWord* findClifford(const Matrix& gate) {
+    for (const CliffordWord& word : singleQubitCliffords()) {
+        if (sameUpToPhase(gate, word.matrix)) {
+            return &word;
+        }
+    }
+    return nullptr;
+}
+
+// 'X', 'Y', 'Z' or 'I' when gate is exactly that Pauli, 0 otherwise
+char exactPauli(const Matrix& gate) {
+    for (GateId id : {GateId::PauliX, GateId::PauliY, GateId::PauliZ, GateId::Identity}) {
+        if (sameMatrix(gate, QuantumComponentFactory::create(id)->getMatrixRef())) {
+            return id == GateId::PauliX ? 'X' : id == GateId::PauliY ? 'Y' : id == GateId::PauliZ ? 'Z' : 'I';
+        }
+    }
+    return 0;
+}
+
+// Row h <- row i * row h, with the phase rule of Aaronson and Gottesman. Per qubit, multiplying
+// by i's Pauli contributes a power of i in {-1, 0, 1}; the masks below mark the +1 and -1 qubits.
+void multiplyRows(std::uint64_t* xh, std::uint64_t* zh, std::uint8_t& ph,
+                  const std::uint64_t* xi, const std::uint64_t* zi, std::uint8_t pi, int words) {
+    int exponent = 2 * ph + 2 * pi;
+    for (int w = 0; w < words; ++w) {
+        const std::uint64_t x1 = xi[w], z1 = zi[w], x2 = xh[w], z2 = zh[w];
+        const std::uint64_t plus = (x1 & z1 & z2 & ~x2) | (x1 & ~z1 & z2 & x2) | (~x1 & z1 & x2 & ~z2);
+        const std::uint64_t minus = (x1 & z1 & x2 & ~z2) | (x1 & ~z1 & z2 & ~x2) | (~x1 & z1 & x2 & z2);
+        exponent += __builtin_popcountll(plus) - __builtin_popcountll(minus);
+        xh[w] ^= x1;
+        zh[w] ^= z1;
+    }
+    ph = ((exponent % 4) + 4) % 4 == 2 ? 1 : 0;
+}
+
+// Computational-basis outcomes of a stabilizer state: s is possible iff parity(s & zRow) equals
+// the row's phase for every Z-only stabilizer. The Z-only rows are kept in reduced echelon form,
+// so the free qubits can be drawn at random and each pivot qubit then follows from its row.
+struct OutcomeSpace {
+    int words;
+    std::vector<std::uint64_t> freeMask;
+    std::vector<std::uint64_t> zRows;  // one row of `words` words per constraint
+    std::vector<std::uint8_t> zPhase;
+    std::vector<int> pivot;
+
+    void complete(std::uint64_t* outcome) const {
+        for (std::size_t j = 0; j < pivot.size(); ++j) {
+            const std::uint64_t* row = zRows.data() + j * words;
+            std::uint64_t parity = zPhase[j];
+            for (int w = 0; w < words; ++w) {
+                parity ^= __builtin_parityll(row[w] & outcome[w]);
+            }
+            if (parity) {
+                outcome[pivot[j] >> 6] |= std::uint64_t(1) << (pivot[j] & 63);
+            }
+        }
+    }
+};
+
+OutcomeSpace outcomeSpace(const std::uint64_t* stabilizerX, const std::uint64_t* stabilizerZ,
+                          const std::uint8_t* stabilizerPhase, int qubits, int words) {
+    std::vector<std::uint64_t> x(stabilizerX, stabilizerX + std::size_t(qubits) * words);
+    std::vector<std::uint64_t> z(stabilizerZ, stabilizerZ + std::size_t(qubits) * words);
+    std::vector<std::uint8_t> phase(stabilizerPhase, stabilizerPhase + qubits);
+    auto swapRows = [&](int a, int b) {
+        std::swap_ranges(x.begin() + std::size_t(a) * words, x.begin() + std::size_t(a + 1) * words, x.begin() + std::size_t(b) * words);
+        std::swap_ranges(z.begin() + std::size_t(a) * words, z.begin() + std::size_t(a + 1) * words, z.begin() + std::size_t(b) * words);
+        std::swap(phase[a], phase[b]);
+    };
+    auto bitSet = [&](const std::vector<std::uint64_t>& bits, int row, int qubit) {
+        return (bits[std::size_t(row) * words + (qubit >> 6)] >> (qubit & 63)) & 1;
+    };
+
+    // Echelon form on the X part; the rows left over have no X and constrain the outcomes
+    int rank = 0;
+    for (int qubit = 0; qubit < qubits && rank < qubits; ++qubit) {
+        int found = rank;
+        while (found < qubits && !bitSet(x, found, qubit)) {
+            ++found;
+        }
+        if (found == qubits) {
+            continue;
+        }
+        swapRows(rank, found);
+        for (int row = 0; row < qubits; ++row) {
+            if (row != rank && bitSet(x, row, qubit)) {
+                multiplyRows(x.data() + std::size_t(row) * words, z.data() + std::size_t(row) * words, phase[row],
+                             x.data() + std::size_t(rank) * words, z.data() + std::size_t(rank) * words, phase[rank], words);
+            }
+        }
+        ++rank;
+    }
+
+    // Reduced echelon form of the Z-only rows; Z strings commute, so phases simply add
+    OutcomeSpace space;
+    space.words = words;
+    space.freeMask.assign(words, ~std::uint64_t(0));
+    if (qubits % 64 != 0) {
+        space.freeMask[words - 1] = (std::uint64_t(1) << (qubits % 64)) - 1;
+    }
+    int next = rank;
+    for (int qubit = 0; qubit < qubits && next < qubits; ++qubit) {
+        int found = next;
+        while (found < qubits && !bitSet(z, found, qubit)) {
+            ++found;
+        }
+        if (found == qubits) {
+            continue;
+        }
+        swapRows(next, found);
+        for (int row = rank; row < qubits; ++row) {
+            if (row != next && bitSet(z, row, qubit)) {
+                for (int w = 0; w < words; ++w) {
+                    z[std::size_t(row) * words + w] ^= z[std::size_t(next) * words + w];
+                }
+                phase[row] ^= phase[next];
+            }
+        }
+        space.pivot.push_back(qubit);
+        space.freeMask[qubit >> 6] &= ~(std::uint64_t(1) << (qubit & 63));
+        ++next;
+    }
+    space.zRows.assign(z.begin() + std::size_t(rank) * words, z.begin() + std::size_t(next) * words);
+    space.zPhase.assign(phase.begin() + rank, phase.begin() + next);
+    return space;
+}
+}
+
+StabilizerTableau::StabilizerTableau(int qubits)
+: qubits(qubits), words((qubits + 63) / 64), xBits(std::size_t(2) * qubits * words, 0),
+  zBits(xBits.size(), 0), phase(2 * std::size_t(qubits), 0) {
+    if (qubits < 0) {
+        throw std::invalid_argument("Number of qubits must not be negative");
+    }
+    // Destabilizer q is X_q and stabilizer q is Z_q
+    for (int q = 0; q < qubits; ++q) {
+        xRow(q)[q >> 6] |= std::uint64_t(1) << (q & 63);
+        zRow(qubits + q)[q >> 6] |= std::uint64_t(1) << (q & 63);
+    }
+}
+
+std::uint64_t* StabilizerTableau::xRow(int row) {
+    return xBits.data() + std::size_t(row) * words;
+}
+
+std::uint64_t* StabilizerTableau::zRow(int row) {
+    return zBits.data() + std::size_t(row) * words;
+}
+
+const std::uint64_t* StabilizerTableau::xRow(int row) const {
+    return xBits.data() + std::size_t(row) * words;
+}
+
+const std::uint64_t* StabilizerTableau::zRow(int row) const {
+    return zBits.data() + std::size_t(row) * words;
+}
+
+void StabilizerTableau::checkQubit(int qubit) const {
+    if (qubit < 0 || qubit >= qubits) {
+        throw std::out_of_range("Gate qubit out of range");
+    }
+}
+
+int StabilizerTableau::getQubits() const {
+    return qubits;
+}
+
+void StabilizerTableau::hadamard(int qubit) {
+    checkQubit(qubit);
+    const int w = qubit >> 6;
+    const std::uint64_t bit = std::uint64_t(1) << (qubit & 63);
+    for (int row = 0; row < 2 * qubits; ++row) {
+        std::uint64_t& x = xRow(row)[w];
+        std::uint64_t& z = zRow(row)[w];
+        phase[row] ^= (x & z & bit) != 0;
+        const std::uint64_t swapped = (x ^ z) & bit;
+        x ^= swapped;
+        z ^= swapped;
+    }
+}
+
+void StabilizerTableau::phaseGate(int qubit) {
+    checkQubit(qubit);
+    const int w = qubit >> 6;
+    const std::uint64_t bit = std::uint64_t(1) << (qubit & 63);
+    for (int row = 0; row < 2 * qubits; ++row) {
+        const std::uint64_t x = xRow(row)[w];
+        std::uint64_t& z = zRow(row)[w];
+        phase[row] ^= (x & z & bit) != 0;
+        z ^= x & bit;
+    }
+}
+
+void StabilizerTableau::pauliX(int qubit) {
+    checkQubit(qubit);
+    const int w = qubit >> 6;
+    const std::uint64_t bit = std::uint64_t(1) << (qubit & 63);
+    for (int row = 0; row < 2 * qubits; ++row) {
+        phase[row] ^= (zRow(row)[w] & bit) != 0;
+    }
+}
+
+void StabilizerTableau::pauliY(int qubit) {
+    checkQubit(qubit);
+    const int w = qubit >> 6;
+    const std::uint64_t bit = std::uint64_t(1) << (qubit & 63);
+    for (int row = 0; row < 2 * qubits; ++row) {
+        phase[row] ^= ((xRow(row)[w] ^ zRow(row)[w]) & bit) != 0;
+    }
+}
+
+void StabilizerTableau::pauliZ(int qubit) {
+    checkQubit(qubit);
+    const int w = qubit >> 6;
+    const std::uint64_t bit = std::uint64_t(1) << (qubit & 63);
+    for (int row = 0; row < 2 * qubits; ++row) {
+        phase[row] ^= (xRow(row)[w] & bit) != 0;
+    }
+}
+
+void StabilizerTableau::cnot(int control, int target) {
+    checkQubit(control);
+    checkQubit(target);
+    if (control == target) {
+        throw std::invalid_argument("Gate uses the same qubit twice");
+    }
+    const int cw = control >> 6, tw = target >> 6;
+    const int cs = control & 63, ts = target & 63;
+    for (int row = 0; row < 2 * qubits; ++row) {
+        std::uint64_t* x = xRow(row);
+        std::uint64_t* z = zRow(row);
+        const std::uint64_t xc = (x[cw] >> cs) & 1, zc = (z[cw] >> cs) & 1;
+        const std::uint64_t xt = (x[tw] >> ts) & 1, zt = (z[tw] >> ts) & 1;
+        phase[row] ^= xc & zt & (xt ^ zc ^ 1);
+        x[tw] ^= xc << ts;
+        z[cw] ^= zt << cs;
+    }
+}
+
+void StabilizerTableau::cz(int control, int target) {
+    hadamard(target);
+    cnot(control, target);
+    hadamard(target);
+}
+
+void StabilizerTableau::cy(int control, int target) {
+    // CY = S CX S^dagger on the target, with S^dagger = S^3
+    phaseGate(target);
+    phaseGate(target);
+    phaseGate(target);
+    cnot(control, target);
+    phaseGate(target);
+}
+
+bool StabilizerTableau::isClifford(const GateOperation& op) {
+    if (op.targets.size() != 1 || op.controls.size() > 1) {
+        return false;
+    }
+    return op.controls.empty() ? findClifford(op.matrix) != nullptr : exactPauli(op.matrix) != 0;
+}
+
+void StabilizerTableau::applyOperation(const GateOperation& op) {
+    if (op.targets.size() != 1 || op.controls.size() > 1) {
+        throw std::invalid_argument("Stabilizer tableau supports single-qubit gates with at most one control");
+    }
+    const int target = op.targets[0];
+    if (op.controls.empty()) {
+        const CliffordWord* word = findClifford(op.matrix);
+        if (!word) {
+            throw std::invalid_argument("Gate is not a Clifford gate");
+        }
+        checkQubit(target);
+        for (char gate : word->gates) {
+            if (gate == 'H') {
+                hadamard(target);
+            } else {
+                phaseGate(target);
+            }
+        }
+        return;
+    }
+    switch (exactPauli(op.matrix)) {
+    case 'X':
+        cnot(op.controls[0], target);
+        break;
+    case 'Y':
+        cy(op.controls[0], target);
+        break;
+    case 'Z':
+        cz(op.controls[0], target);
+        break;
+    case 'I':
+        break;
+    default:
+        throw std::invalid_argument("Only controlled X, Y and Z are Clifford gates");
+    }
+}
+
+MeasurementCounts StabilizerTableau::sample(std::uint64_t shots, std::uint64_t seed, ThreadPool* pool) const {
+    const OutcomeSpace space = outcomeSpace(xRow(qubits), zRow(qubits), phase.data() + qubits, qubits, words);
+
+    std::unordered_map<std::string, std::uint64_t> totals;
+    std::mutex totalsMutex;
+    const std::size_t chunks = (shots + shotsPerChunk - 1) / shotsPerChunk;
+    auto drawChunks = [&](std::size_t begin, std::size_t end) {
+        std::unordered_map<std::string, std::uint64_t> local;
+        std::vector<std::uint64_t> outcome(words);
+        std::string bitstring(qubits, '0');
+        for (std::size_t chunk = begin; chunk < end; ++chunk) {
+            std::mt19937_64 rng(mixSeed(seed ^ mixSeed(chunk)));
+            const std::uint64_t count = std::min<std::uint64_t>(shotsPerChunk, shots - chunk * shotsPerChunk);
+            for (std::uint64_t shot = 0; shot < count; ++shot) {
+                for (int w = 0; w < words; ++w) {
+                    outcome[w] = rng() & space.freeMask[w];
+                }
+                space.complete(outcome.data());
+                for (int q = 0; q < qubits; ++q) {
+                    bitstring[qubits - 1 - q] = ((outcome[q >> 6] >> (q & 63)) & 1) ? '1' : '0';
+                }
+                ++local[bitstring];
+            }
+        }
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        for (const auto& entry : local) {
+            totals[entry.first] += entry.second;
+        }
+    };
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, chunks, 1, drawChunks);
+    } else {
+        drawChunks(0, chunks);
+    }
+    return MeasurementCounts(totals.begin(), totals.end());
+}
+
+Matrix StabilizerTableau::toStateVector() const {
+    if (qubits < 1 || qubits > 30) {
+        throw std::length_error("State vector for " + std::to_string(qubits) + " qubits does not fit in a Matrix");
+    }
+    // Start from a basis state in the support and project with (I + g)/2 for every stabilizer g
+    const OutcomeSpace space = outcomeSpace(xRow(qubits), zRow(qubits), phase.data() + qubits, qubits, words);
+    std::uint64_t basis = 0;
+    space.complete(&basis);
+
+    const std::size_t dimension = std::size_t(1) << qubits;
+    std::vector<Complex> psi(dimension), image(dimension);
+    psi[basis] = Complex(1, 0);
+    static const Complex yPhase[4] = {Complex(1, 0), Complex(0, 1), Complex(-1, 0), Complex(0, -1)};
+    for (int g = qubits; g < 2 * qubits; ++g) {
+        const std::uint64_t x = xRow(g)[0], z = zRow(g)[0];
+        const Complex factor = yPhase[__builtin_popcountll(x & z) % 4] * Complex(phase[g] ? -0.5 : 0.5, 0);
+        for (std::size_t i = 0; i < dimension; ++i) {
+            const Complex term = __builtin_parityll(i & z) ? Complex(-1, 0) * factor : factor;
+            image[i ^ x] = term * psi[i];
+        }
+        for (std::size_t i = 0; i < dimension; ++i) {
+            psi[i] = psi[i] * Complex(0.5, 0) + image[i];
+        }
+    }
+
+    double norm = 0;
+    for (const Complex& amplitude : psi) {
+        norm += amplitude.get_real() * amplitude.get_real() + amplitude.get_imag() * amplitude.get_imag();
+    }
+    Matrix result(dimension, 1);
+    const Complex scale(1 / std::sqrt(norm), 0);
+    for (std::size_t i = 0; i < dimension; ++i) {
+        result.data()[i] = psi[i] * scale;
+    }
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const StabilizerTableau& tableau) {
+    for (int g = tableau.qubits; g < 2 * tableau.qubits; ++g) {
+        os << (tableau.phase[g] ? '-' : '+');
+        for (int q = 0; q < tableau.qubits; ++q) {
+            const bool x = (tableau.xRow(g)[q >> 6] >> (q & 63)) & 1;
+            const bool z = (tableau.zRow(g)[q >> 6] >> (q & 63)) & 1;
+            os << (x && z ? 'Y' : x ? 'X' : z ? 'Z' : 'I');
+        }
+        os << '\n';
+    }
+    return os;
+}
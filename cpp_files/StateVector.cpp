@@ -0,0 +1,392 @@
+#include "../h_files/StateVector.h"
+#include "../h_files/SimdKernels.h"
+
+namespace {
+// Below this many pairs a chunk is not worth waking a worker for
+const std::size_t minimumChunk = std::size_t(1) << 12;
+
+void validateOperation(int qubits, const GateOperation& op) {
+    std::vector<bool> used(qubits, false);
+    for (const std::vector<int>* list : {&op.targets, &op.controls}) {
+        for (int qubit : *list) {
+            if (qubit < 0 || qubit >= qubits) {
+                throw std::out_of_range("Gate qubit out of range");
+            }
+            if (used[qubit]) {
+                throw std::invalid_argument("Gate uses the same qubit twice");
+            }
+            used[qubit] = true;
+        }
+    }
+    if (op.matrix.getRows() != (1 << op.targets.size()) || op.matrix.getCols() != op.matrix.getRows()) {
+        throw std::invalid_argument("Gate matrix does not match the number of target qubits");
+    }
+}
+
+// Offset of local basis state j within a group of the target subspace
+std::vector<std::size_t> subspaceOffsets(const std::vector<int>& targets) {
+    const int subspace = 1 << targets.size();
+    std::vector<std::size_t> offsets(subspace, 0);
+    for (int j = 0; j < subspace; ++j) {
+        for (std::size_t bit = 0; bit < targets.size(); ++bit) {
+            if (j & (1 << bit)) {
+                offsets[j] |= std::size_t(1) << targets[bit];
+            }
+        }
+    }
+    return offsets;
+}
+
+// Gate entries rounded once to the precision of the state they are applied to
+template <typename T>
+std::vector<BasicComplex<T>> gateEntries(const Matrix& gate) {
+    std::vector<BasicComplex<T>> entries(std::size_t(gate.getRows()) * gate.getCols());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        entries[i] = BasicComplex<T>(gate.data()[i]);
+    }
+    return entries;
+}
+}
+
+template <typename T>
+void StateVectorSimulator::applyOperation(BasicComplex<T>* amplitudes, int qubits, const GateOperation& op, ThreadPool* pool) {
+    validateOperation(qubits, op);
+
+    if (!op.controls.empty()) {
+        applyControlledGate(amplitudes, qubits, op.matrix, op.targets, op.controls, pool);
+    } else if (op.targets.size() == 1) {
+        applySingleQubitGate(amplitudes, qubits, op.matrix, op.targets[0], pool);
+    } else if (!op.targets.empty()) {
+        applyMultiQubitGate(amplitudes, qubits, op.matrix, op.targets, pool);
+    }
+}
+
+template <typename T>
+void StateVectorSimulator::applySingleQubitGate(BasicComplex<T>* amplitudes, int qubits, const Matrix& gate, int target, ThreadPool* pool) {
+    const std::size_t pairs = std::size_t(1) << (qubits - 1);
+    const std::size_t stride = std::size_t(1) << target;
+    const BasicComplex<T> u00(gate(1, 1)), u01(gate(1, 2));
+    const BasicComplex<T> u10(gate(2, 1)), u11(gate(2, 2));
+
+    // Pair p pairs amplitude i (target bit clear) with i + stride. Consecutive pairs form runs
+    // of at most `stride` contiguous amplitudes, one run per block of 2*stride.
+    auto updatePairs = [&](std::size_t begin, std::size_t end) {
+        std::size_t p = begin;
+        while (p < end) {
+            const std::size_t offset = p & (stride - 1);
+            const std::size_t run = std::min(stride - offset, end - p);
+            const std::size_t first = ((p >> target) << (target + 1)) | offset;
+            for (std::size_t i = first; i < first + run; ++i) {
+                const BasicComplex<T> a0 = amplitudes[i];
+                const BasicComplex<T> a1 = amplitudes[i + stride];
+                amplitudes[i] = u00 * a0 + u01 * a1;
+                amplitudes[i + stride] = u10 * a0 + u11 * a1;
+            }
+            p += run;
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, pairs, chunkSize(pairs, stride, pool->size()), updatePairs);
+    } else {
+        updatePairs(0, pairs);
+    }
+}
+
+template <typename T>
+void StateVectorSimulator::applyMultiQubitGate(BasicComplex<T>* amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets, ThreadPool* pool) {
+    const int k = targets.size();
+    const int subspace = 1 << k;
+    const std::size_t groups = std::size_t(1) << (qubits - k);
+
+    std::vector<int> sortedTargets(targets);
+    std::sort(sortedTargets.begin(), sortedTargets.end());
+
+    const std::vector<std::size_t> offsets = subspaceOffsets(targets);
+    const std::vector<BasicComplex<T>> u = gateEntries<T>(gate);
+    auto updateGroups = [&](std::size_t begin, std::size_t end) {
+        std::vector<BasicComplex<T>> in(subspace), out(subspace);
+        for (std::size_t group = begin; group < end; ++group) {
+            const std::size_t base = insertZeroBits(group, sortedTargets);
+            for (int j = 0; j < subspace; ++j) {
+                in[j] = amplitudes[base + offsets[j]];
+            }
+            for (int row = 0; row < subspace; ++row) {
+                BasicComplex<T> sum(0, 0);
+                for (int col = 0; col < subspace; ++col) {
+                    sum += u[row * subspace + col] * in[col];
+                }
+                out[row] = sum;
+            }
+            for (int j = 0; j < subspace; ++j) {
+                amplitudes[base + offsets[j]] = out[j];
+            }
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, groups, chunkSize(groups, std::size_t(1) << sortedTargets[0], pool->size()), updateGroups);
+    } else {
+        updateGroups(0, groups);
+    }
+}
+
+void StateVectorSimulator::applyOperation(SplitComplexArray& amplitudes, int qubits, const GateOperation& op, ThreadPool* pool) {
+    validateOperation(qubits, op);
+    if (amplitudes.size() != std::size_t(1) << qubits) {
+        throw std::invalid_argument("State size does not match the number of qubits");
+    }
+
+    if (!op.controls.empty()) {
+        applyControlledGate(amplitudes, qubits, op.matrix, op.targets, op.controls, pool);
+    } else if (op.targets.size() == 1) {
+        applySingleQubitGate(amplitudes, qubits, op.matrix, op.targets[0], pool);
+    } else if (!op.targets.empty()) {
+        applyMultiQubitGate(amplitudes, qubits, op.matrix, op.targets, pool);
+    }
+}
+
+void StateVectorSimulator::applySingleQubitGate(SplitComplexArray& amplitudes, int qubits, const Matrix& gate, int target, ThreadPool* pool) {
+    const std::size_t pairs = std::size_t(1) << (qubits - 1);
+    const std::size_t stride = std::size_t(1) << target;
+    double u[8];
+    for (int entry = 0; entry < 4; ++entry) {
+        u[2 * entry] = gate.data()[entry].get_real();
+        u[2 * entry + 1] = gate.data()[entry].get_imag();
+    }
+    double* re = amplitudes.real();
+    double* im = amplitudes.imag();
+
+    // Same pair runs as the interleaved kernel; each run is one contiguous SIMD sweep
+    auto updatePairs = [&](std::size_t begin, std::size_t end) {
+        std::size_t p = begin;
+        while (p < end) {
+            const std::size_t offset = p & (stride - 1);
+            const std::size_t run = std::min(stride - offset, end - p);
+            const std::size_t first = ((p >> target) << (target + 1)) | offset;
+            SimdKernels::pairUpdate(run, u, re + first, im + first, re + first + stride, im + first + stride);
+            p += run;
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, pairs, chunkSize(pairs, stride, pool->size()), updatePairs);
+    } else {
+        updatePairs(0, pairs);
+    }
+}
+
+void StateVectorSimulator::applyMultiQubitGate(SplitComplexArray& amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets, ThreadPool* pool) {
+    const int subspace = 1 << targets.size();
+    const std::size_t groups = std::size_t(1) << (qubits - targets.size());
+
+    std::vector<int> sortedTargets(targets);
+    std::sort(sortedTargets.begin(), sortedTargets.end());
+    const std::vector<std::size_t> offsets = subspaceOffsets(targets);
+    double* re = amplitudes.real();
+    double* im = amplitudes.imag();
+
+    std::vector<double> uReal(subspace * subspace), uImag(subspace * subspace);
+    for (int entry = 0; entry < subspace * subspace; ++entry) {
+        uReal[entry] = gate.data()[entry].get_real();
+        uImag[entry] = gate.data()[entry].get_imag();
+    }
+
+    auto updateGroups = [&](std::size_t begin, std::size_t end) {
+        std::vector<double> inReal(subspace), inImag(subspace);
+        for (std::size_t group = begin; group < end; ++group) {
+            const std::size_t base = insertZeroBits(group, sortedTargets);
+            for (int j = 0; j < subspace; ++j) {
+                inReal[j] = re[base + offsets[j]];
+                inImag[j] = im[base + offsets[j]];
+            }
+            for (int row = 0; row < subspace; ++row) {
+                double sumReal = 0, sumImag = 0;
+                for (int col = 0; col < subspace; ++col) {
+                    const double ur = uReal[row * subspace + col], ui = uImag[row * subspace + col];
+                    sumReal += ur * inReal[col] - ui * inImag[col];
+                    sumImag += ur * inImag[col] + ui * inReal[col];
+                }
+                re[base + offsets[row]] = sumReal;
+                im[base + offsets[row]] = sumImag;
+            }
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, groups, chunkSize(groups, std::size_t(1) << sortedTargets[0], pool->size()), updateGroups);
+    } else {
+        updateGroups(0, groups);
+    }
+}
+
+template <typename T>
+void StateVectorSimulator::applyControlledGate(BasicComplex<T>* amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets,
+                                               const std::vector<int>& controls, ThreadPool* pool) {
+    const int subspace = 1 << targets.size();
+    const int fixedBits = targets.size() + controls.size();
+    const std::size_t groups = std::size_t(1) << (qubits - fixedBits);
+
+    // Groups enumerate the free qubits; controls are then forced to 1 and targets span the subspace
+    std::vector<int> fixed(targets);
+    fixed.insert(fixed.end(), controls.begin(), controls.end());
+    std::sort(fixed.begin(), fixed.end());
+    std::size_t controlMask = 0;
+    for (int control : controls) {
+        controlMask |= std::size_t(1) << control;
+    }
+    const std::vector<std::size_t> offsets = subspaceOffsets(targets);
+    const std::vector<BasicComplex<T>> u = gateEntries<T>(gate);
+
+    auto updateGroups = [&](std::size_t begin, std::size_t end) {
+        std::vector<BasicComplex<T>> in(subspace);
+        for (std::size_t group = begin; group < end; ++group) {
+            const std::size_t base = insertZeroBits(group, fixed) | controlMask;
+            for (int j = 0; j < subspace; ++j) {
+                in[j] = amplitudes[base + offsets[j]];
+            }
+            for (int row = 0; row < subspace; ++row) {
+                BasicComplex<T> sum(0, 0);
+                for (int col = 0; col < subspace; ++col) {
+                    sum += u[row * subspace + col] * in[col];
+                }
+                amplitudes[base + offsets[row]] = sum;
+            }
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, groups, chunkSize(groups, std::size_t(1) << fixed[0], pool->size()), updateGroups);
+    } else {
+        updateGroups(0, groups);
+    }
+}
+
+void StateVectorSimulator::applyControlledGate(SplitComplexArray& amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets,
+                                               const std::vector<int>& controls, ThreadPool* pool) {
+    const int subspace = 1 << targets.size();
+    const int fixedBits = targets.size() + controls.size();
+    const std::size_t groups = std::size_t(1) << (qubits - fixedBits);
+
+    std::vector<int> fixed(targets);
+    fixed.insert(fixed.end(), controls.begin(), controls.end());
+    std::sort(fixed.begin(), fixed.end());
+    std::size_t controlMask = 0;
+    for (int control : controls) {
+        controlMask |= std::size_t(1) << control;
+    }
+    const std::vector<std::size_t> offsets = subspaceOffsets(targets);
+    double* re = amplitudes.real();
+    double* im = amplitudes.imag();
+
+    auto updateGroups = [&](std::size_t begin, std::size_t end) {
+        std::vector<double> inReal(subspace), inImag(subspace);
+        for (std::size_t group = begin; group < end; ++group) {
+            const std::size_t base = insertZeroBits(group, fixed) | controlMask;
+            for (int j = 0; j < subspace; ++j) {
+                inReal[j] = re[base + offsets[j]];
+                inImag[j] = im[base + offsets[j]];
+            }
+            for (int row = 0; row < subspace; ++row) {
+                double sumReal = 0, sumImag = 0;
+                for (int col = 0; col < subspace; ++col) {
+                    const Complex& entry = gate.data()[row * subspace + col];
+                    const double ur = entry.get_real(), ui = entry.get_imag();
+                    sumReal += ur * inReal[col] - ui * inImag[col];
+                    sumImag += ur * inImag[col] + ui * inReal[col];
+                }
+                re[base + offsets[row]] = sumReal;
+                im[base + offsets[row]] = sumImag;
+            }
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        pool->parallelFor(0, groups, chunkSize(groups, std::size_t(1) << fixed[0], pool->size()), updateGroups);
+    } else {
+        updateGroups(0, groups);
+    }
+}
+
+void StateVectorSimulator::applyOperationBatch(Complex* block, int qubits, int batch, const GateOperation& op, ThreadPool* pool) {
+    validateOperation(qubits, op);
+    if (batch < 1) {
+        throw std::invalid_argument("Batch must hold at least one state");
+    }
+    if (op.targets.empty()) {
+        return;
+    }
+
+    const int subspace = 1 << op.targets.size();
+    const std::size_t groups = std::size_t(1) << (qubits - op.targets.size() - op.controls.size());
+    std::vector<int> fixed(op.targets);
+    fixed.insert(fixed.end(), op.controls.begin(), op.controls.end());
+    std::sort(fixed.begin(), fixed.end());
+    std::size_t controlMask = 0;
+    for (int control : op.controls) {
+        controlMask |= std::size_t(1) << control;
+    }
+    const std::vector<std::size_t> offsets = subspaceOffsets(op.targets);
+    const Complex* u = op.matrix.data();
+    const std::size_t columns = batch;
+
+    auto updateGroups = [&](std::size_t begin, std::size_t end) {
+        // Scratch rows for the subspace, reused for every group in the chunk
+        std::vector<Complex> in(subspace * columns);
+        for (std::size_t group = begin; group < end; ++group) {
+            const std::size_t base = insertZeroBits(group, fixed) | controlMask;
+            for (int j = 0; j < subspace; ++j) {
+                std::copy(block + (base + offsets[j]) * columns, block + (base + offsets[j] + 1) * columns,
+                          in.begin() + j * columns);
+            }
+            for (int row = 0; row < subspace; ++row) {
+                Complex* out = block + (base + offsets[row]) * columns;
+                std::fill(out, out + columns, Complex(0, 0));
+                for (int col = 0; col < subspace; ++col) {
+                    const Complex entry = u[row * subspace + col];
+                    if (entry.get_real() == 0 && entry.get_imag() == 0) {
+                        continue;
+                    }
+                    const Complex* source = in.data() + col * columns;
+                    for (std::size_t b = 0; b < columns; ++b) {
+                        out[b] += entry * source[b];
+                    }
+                }
+            }
+        }
+    };
+
+    if (pool && pool->size() > 1) {
+        // Each group already carries `batch` columns of work, so chunks can be smaller
+        std::size_t chunk = std::max<std::size_t>(1, chunkSize(groups, 1, pool->size()) / columns);
+        pool->parallelFor(0, groups, chunk, updateGroups);
+    } else {
+        updateGroups(0, groups);
+    }
+}
+
+template void StateVectorSimulator::applyOperation(Complex*, int, const GateOperation&, ThreadPool*);
+template void StateVectorSimulator::applyOperation(ComplexF*, int, const GateOperation&, ThreadPool*);
+template void StateVectorSimulator::applySingleQubitGate(Complex*, int, const Matrix&, int, ThreadPool*);
+template void StateVectorSimulator::applySingleQubitGate(ComplexF*, int, const Matrix&, int, ThreadPool*);
+template void StateVectorSimulator::applyMultiQubitGate(Complex*, int, const Matrix&, const std::vector<int>&, ThreadPool*);
+template void StateVectorSimulator::applyMultiQubitGate(ComplexF*, int, const Matrix&, const std::vector<int>&, ThreadPool*);
+template void StateVectorSimulator::applyControlledGate(Complex*, int, const Matrix&, const std::vector<int>&, const std::vector<int>&, ThreadPool*);
+template void StateVectorSimulator::applyControlledGate(ComplexF*, int, const Matrix&, const std::vector<int>&, const std::vector<int>&, ThreadPool*);
+
+std::size_t StateVectorSimulator::insertZeroBits(std::size_t index, const std::vector<int>& sortedBits) {
+    for (int bit : sortedBits) {
+        const std::size_t low = index & ((std::size_t(1) << bit) - 1);
+        index = ((index >> bit) << (bit + 1)) | low;
+    }
+    return index;
+}
+
+std::size_t StateVectorSimulator::chunkSize(std::size_t pairs, std::size_t stride, int threads) {
+    // Aim for a few chunks per thread so uneven progress still balances out
+    std::size_t chunk = std::max(minimumChunk, pairs / (std::size_t(threads) * 4));
+    if (stride < chunk) {
+        chunk = (chunk + stride - 1) / stride * stride;
+    }
+    return std::min(chunk, pairs);
+}
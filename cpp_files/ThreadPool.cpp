@@ -0,0 +1,111 @@
+#include "../h_files/ThreadPool.h"
+
+namespace {
+thread_local bool insidePoolJob = false;
+}
+
+ThreadPool::ThreadPool(int threads)
+: job(nullptr), jobEnd(0), jobChunk(1), nextIndex(0), generation(0), busyWorkers(0), stopping(false) {
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // The calling thread takes part in every job, so it counts as one of the threads
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::size() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, std::size_t chunk,
+                             const std::function<void(std::size_t, std::size_t)>& body) {
+    if (begin >= end) {
+        return;
+    }
+    if (chunk == 0) {
+        chunk = 1;
+    }
+    if (workers.empty() || insidePoolJob || end - begin <= chunk) {
+        body(begin, end);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        job = &body;
+        jobEnd = end;
+        jobChunk = chunk;
+        nextIndex.store(begin);
+        firstError = nullptr;
+        busyWorkers = workers.size();
+        ++generation;
+    }
+    wakeWorkers.notify_all();
+
+    insidePoolJob = true;
+    runChunks();
+    insidePoolJob = false;
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    jobDone.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+void ThreadPool::runChunks() {
+    while (true) {
+        std::size_t chunkBegin = nextIndex.fetch_add(jobChunk);
+        if (chunkBegin >= jobEnd) {
+            return;
+        }
+        std::size_t chunkEnd = std::min(jobEnd, chunkBegin + jobChunk);
+        try {
+            (*job)(chunkBegin, chunkEnd);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+            // Let the remaining chunks drain quickly
+            nextIndex.store(jobEnd);
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    insidePoolJob = true;
+    std::size_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeWorkers.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--busyWorkers == 0) {
+            jobDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,324 @@
+#include "../h_files/Transport.h"
+
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+namespace {
+const std::size_t cacheLine = 64;
+
+std::runtime_error socketError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+template <typename Ready>
+void spinUntil(Ready ready) {
+    for (int spins = 0; !ready(); ++spins) {
+        if (spins > 64) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+struct BarrierState {
+    std::atomic<std::uint32_t> arrived;
+    std::atomic<std::uint32_t> generation;
+};
+}
+
+struct SharedMemoryTransport::Mailbox {
+    std::atomic<std::uint64_t> written;   // slots filled by the sender
+    std::atomic<std::uint64_t> consumed;  // slots emptied by the receiver
+    char* data() {
+        return reinterpret_cast<char*>(this) + cacheLine;
+    }
+};
+
+SharedMemoryTransport::SharedMemoryTransport(int processes, std::size_t slotBytes)
+: processes(processes), self(-1), slotBytes(slotBytes), mailboxBytes(cacheLine + slotBytes), regionBytes(0), region(nullptr) {
+    if (processes < 1 || slotBytes == 0) {
+        throw std::invalid_argument("Shared memory transport needs at least one process and a non-empty slot");
+    }
+    mailboxBytes = (mailboxBytes + cacheLine - 1) / cacheLine * cacheLine;
+    regionBytes = cacheLine + std::size_t(processes) * processes * mailboxBytes;
+    region = ::mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        throw socketError("Cannot map shared mailboxes");
+    }
+    new (region) BarrierState{{0}, {0}};
+    for (int from = 0; from < processes; ++from) {
+        for (int to = 0; to < processes; ++to) {
+            new (mailbox(from, to)) Mailbox{{0}, {0}};
+        }
+    }
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    ::munmap(region, regionBytes);
+}
+
+SharedMemoryTransport::Mailbox* SharedMemoryTransport::mailbox(int from, int to) const {
+    char* base = static_cast<char*>(region) + cacheLine;
+    return reinterpret_cast<Mailbox*>(base + (std::size_t(from) * processes + to) * mailboxBytes);
+}
+
+void SharedMemoryTransport::attach(int rank) {
+    if (rank < 0 || rank >= processes) {
+        throw std::out_of_range("Rank out of range");
+    }
+    self = rank;
+}
+
+int SharedMemoryTransport::rank() const {
+    return self;
+}
+
+int SharedMemoryTransport::size() const {
+    return processes;
+}
+
+void SharedMemoryTransport::putSlot(int peer, const char* data, std::size_t bytes) {
+    Mailbox* box = mailbox(self, peer);
+    spinUntil([&] { return box->consumed.load(std::memory_order_acquire) == box->written.load(std::memory_order_relaxed); });
+    std::memcpy(box->data(), data, bytes);
+    box->written.fetch_add(1, std::memory_order_release);
+}
+
+void SharedMemoryTransport::takeSlot(int peer, char* data, std::size_t bytes) {
+    Mailbox* box = mailbox(peer, self);
+    spinUntil([&] { return box->written.load(std::memory_order_acquire) > box->consumed.load(std::memory_order_relaxed); });
+    std::memcpy(data, box->data(), bytes);
+    box->consumed.fetch_add(1, std::memory_order_release);
+}
+
+void SharedMemoryTransport::send(int peer, const void* data, std::size_t bytes) {
+    const char* bytesIn = static_cast<const char*>(data);
+    for (std::size_t offset = 0; offset < bytes; offset += slotBytes) {
+        putSlot(peer, bytesIn + offset, std::min(slotBytes, bytes - offset));
+    }
+}
+
+void SharedMemoryTransport::receive(int peer, void* data, std::size_t bytes) {
+    char* bytesOut = static_cast<char*>(data);
+    for (std::size_t offset = 0; offset < bytes; offset += slotBytes) {
+        takeSlot(peer, bytesOut + offset, std::min(slotBytes, bytes - offset));
+    }
+}
+
+void SharedMemoryTransport::exchange(int peer, const void* sendData, void* receiveData, std::size_t bytes) {
+    // Both sides alternate put and take, so neither waits on a slot the other has not drained
+    const char* bytesIn = static_cast<const char*>(sendData);
+    char* bytesOut = static_cast<char*>(receiveData);
+    for (std::size_t offset = 0; offset < bytes; offset += slotBytes) {
+        const std::size_t length = std::min(slotBytes, bytes - offset);
+        putSlot(peer, bytesIn + offset, length);
+        takeSlot(peer, bytesOut + offset, length);
+    }
+}
+
+void SharedMemoryTransport::barrier() {
+    BarrierState* state = static_cast<BarrierState*>(region);
+    const std::uint32_t generation = state->generation.load(std::memory_order_acquire);
+    if (state->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == std::uint32_t(processes)) {
+        state->arrived.store(0, std::memory_order_relaxed);
+        state->generation.fetch_add(1, std::memory_order_release);
+    } else {
+        spinUntil([&] { return state->generation.load(std::memory_order_acquire) != generation; });
+    }
+}
+
+TcpTransport::TcpTransport(int processes, const std::string& host)
+: processes(processes), self(-1), host(host), listeners(processes, -1), ports(processes, 0), peers(processes, -1) {
+    if (processes < 1) {
+        throw std::invalid_argument("TCP transport needs at least one process");
+    }
+    for (int rank = 0; rank < processes; ++rank) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw socketError("Cannot create socket");
+        }
+        listeners[rank] = fd;
+        const int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = 0;
+        if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+            throw std::invalid_argument("Bad IPv4 address " + host);
+        }
+        socklen_t length = sizeof(address);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(fd, processes) != 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            throw socketError("Cannot listen on " + host);
+        }
+        ports[rank] = ntohs(address.sin_port);
+    }
+}
+
+TcpTransport::~TcpTransport() {
+    for (int fd : listeners) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    for (int fd : peers) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+void TcpTransport::attach(int rank) {
+    if (rank < 0 || rank >= processes) {
+        throw std::out_of_range("Rank out of range");
+    }
+    self = rank;
+    for (int other = 0; other < processes; ++other) {
+        if (other != rank) {
+            ::close(listeners[other]);
+            listeners[other] = -1;
+        }
+    }
+
+    const int on = 1;
+    // Connect to every lower rank (the listen backlog holds the connection until it is accepted),
+    // then accept every higher rank; each side announces its rank first
+    for (int lower = 0; lower < rank; ++lower) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(ports[lower]);
+        ::inet_pton(AF_INET, host.c_str(), &address.sin_addr);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            throw socketError("Cannot connect to rank " + std::to_string(lower));
+        }
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        peers[lower] = fd;
+        const std::int32_t id = rank;
+        send(lower, &id, sizeof(id));
+    }
+    for (int accepted = rank + 1; accepted < processes; ++accepted) {
+        const int fd = ::accept(listeners[rank], nullptr, nullptr);
+        if (fd < 0) {
+            throw socketError("Cannot accept a peer");
+        }
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        std::int32_t id = -1;
+        std::size_t got = 0;
+        while (got < sizeof(id)) {
+            const ssize_t n = ::recv(fd, reinterpret_cast<char*>(&id) + got, sizeof(id) - got, 0);
+            if (n <= 0) {
+                throw socketError("Peer closed during connection setup");
+            }
+            got += n;
+        }
+        if (id <= rank || id >= processes || peers[id] >= 0) {
+            throw std::runtime_error("Unexpected peer rank " + std::to_string(id));
+        }
+        peers[id] = fd;
+    }
+    ::close(listeners[rank]);
+    listeners[rank] = -1;
+}
+
+int TcpTransport::rank() const {
+    return self;
+}
+
+int TcpTransport::size() const {
+    return processes;
+}
+
+void TcpTransport::send(int peer, const void* data, std::size_t bytes) {
+    const char* bytesIn = static_cast<const char*>(data);
+    while (bytes > 0) {
+        const ssize_t n = ::send(peers[peer], bytesIn, bytes, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Send to rank " + std::to_string(peer) + " failed");
+        }
+        bytesIn += n;
+        bytes -= n;
+    }
+}
+
+void TcpTransport::receive(int peer, void* data, std::size_t bytes) {
+    char* bytesOut = static_cast<char*>(data);
+    while (bytes > 0) {
+        const ssize_t n = ::recv(peers[peer], bytesOut, bytes, 0);
+        if (n == 0) {
+            throw std::runtime_error("Rank " + std::to_string(peer) + " closed the connection");
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Receive from rank " + std::to_string(peer) + " failed");
+        }
+        bytesOut += n;
+        bytes -= n;
+    }
+}
+
+void TcpTransport::exchange(int peer, const void* sendData, void* receiveData, std::size_t bytes) {
+    // Blocking send on both ends would stall once the socket buffers fill, so wait for
+    // readiness and move whatever each direction allows
+    const char* bytesIn = static_cast<const char*>(sendData);
+    char* bytesOut = static_cast<char*>(receiveData);
+    std::size_t sent = 0, received = 0;
+    const int fd = peers[peer];
+    while (sent < bytes || received < bytes) {
+        pollfd ready{fd, short((sent < bytes ? POLLOUT : 0) | (received < bytes ? POLLIN : 0)), 0};
+        if (::poll(&ready, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Poll failed");
+        }
+        if ((ready.revents & POLLOUT) && sent < bytes) {
+            const ssize_t n = ::send(fd, bytesIn + sent, bytes - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                throw socketError("Send to rank " + std::to_string(peer) + " failed");
+            }
+            sent += n > 0 ? n : 0;
+        }
+        if ((ready.revents & (POLLIN | POLLHUP)) && received < bytes) {
+            const ssize_t n = ::recv(fd, bytesOut + received, bytes - received, MSG_DONTWAIT);
+            if (n == 0) {
+                throw std::runtime_error("Rank " + std::to_string(peer) + " closed the connection");
+            }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                throw socketError("Receive from rank " + std::to_string(peer) + " failed");
+            }
+            received += n > 0 ? n : 0;
+        }
+    }
+}
+
+void TcpTransport::barrier() {
+    char token = 0;
+    if (self == 0) {
+        for (int peer = 1; peer < processes; ++peer) {
+            receive(peer, &token, 1);
+        }
+        for (int peer = 1; peer < processes; ++peer) {
+            send(peer, &token, 1);
+        }
+    } else {
+        send(0, &token, 1);
+        receive(0, &token, 1);
+    }
+}
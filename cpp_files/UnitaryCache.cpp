@@ -0,0 +1,70 @@
+#include "../h_files/UnitaryCache.h"
+
+namespace {
+std::size_t matrixBytes(const Matrix& m) {
+    return std::size_t(m.getRows()) * m.getCols() * sizeof(Complex);
+}
+}
+
+std::ostream& operator<<(std::ostream& os, const UnitaryCacheStatistics& stats) {
+    os << "Unitary cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+       << " evictions, " << stats.entries << " entries (" << stats.bytes / 1048576.0 << " MiB)";
+    return os;
+}
+
+UnitaryCache::UnitaryCache(std::size_t capacityBytes) : capacity(capacityBytes), bytes(0) {}
+
+std::shared_ptr<const Matrix> UnitaryCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++stats.misses;
+        return nullptr;
+    }
+    ++stats.hits;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void UnitaryCache::insert(const std::string& key, std::shared_ptr<const Matrix> matrix) {
+    const std::size_t size = matrixBytes(*matrix);
+    if (size > capacity) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        bytes -= matrixBytes(*existing->second->second);
+        entries.erase(existing->second);
+        index.erase(existing);
+    }
+    while (bytes + size > capacity && !entries.empty()) {
+        bytes -= matrixBytes(*entries.back().second);
+        index.erase(entries.back().first);
+        entries.pop_back();
+        ++stats.evictions;
+    }
+    entries.emplace_front(key, std::move(matrix));
+    index[key] = entries.begin();
+    bytes += size;
+    stats.entries = entries.size();
+    stats.bytes = bytes;
+}
+
+void UnitaryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    bytes = 0;
+    stats.entries = 0;
+    stats.bytes = 0;
+}
+
+std::size_t UnitaryCache::getCapacity() const {
+    return capacity;
+}
+
+UnitaryCacheStatistics UnitaryCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
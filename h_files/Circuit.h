@@ -6,37 +6,281 @@
 #include <algorithm>
 #include <complex>
 #include <limits>
+#include <functional>
+#include <map>
+#include <string>
 
 #include "Matrix.h"
+#include "MatrixExpression.h"
 #include "Gates.h"
 #include "Complex.h"           
+#include "StateVector.h"
+#include "GateFusion.h"
+#include "CircuitOptimizer.h"
+#include "Measurement.h"
+#include "Noise.h"
+#include "DensityMatrix.h"
+#include "OutOfCore.h"
+#include "Distributed.h"
+#include "Observable.h"
+#include "Stabilizer.h"
+#include "MatrixProductState.h"
+#include "UnitaryCache.h"
+
+enum class SimulationMode {
+    Dense,        // reference: build the full 2^n x 2^n unitary and multiply
+    StateVector,  // apply each gate in place to the state vector, O(2^n) per gate
+    DensityMatrix, // evolve rho with gates and the noise model's Kraus channels, O(4^n) per gate
+    Stabilizer,   // Clifford circuits only, on a stabilizer tableau: O(n) per gate, thousands of qubits
+    Automatic,    // Stabilizer when the circuit is noise-free and Clifford, otherwise StateVector
+    MatrixProductState  // tensor chain with bonds of at most maxBondDimension: O(maxBond^3) per gate,
+                        // exact for weakly entangled states of many qubits, truncated beyond that
+};
+
+enum class Precision {
+    Double,  // fp64 amplitudes, 16 bytes each
+    Single,  // fp32 amplitudes, half the memory; rounding error grows with circuit depth
+    Mixed    // fp32 amplitudes, renormalized with fp64-accumulated norms as the circuit runs
+};
+
+enum class StorageLayout {
+    Interleaved,  // Complex {real, imag} pairs, as held by Matrix
+    Split         // separate 64-byte aligned real and imaginary arrays, SIMD kernels
+};
+
+struct CheckpointStatistics {
+    std::size_t checkpoints = 0;  // stored states, including the circuit's input
+    std::size_t bytes = 0;
+    int interval = 0;             // timesteps between checkpoints after budget thinning
+    int resumedFrom = 0;          // timestep the last applyCircuit restarted at
+    int timestepsRun = 0;         // timesteps it simulated
+};
+
+std::ostream& operator<<(std::ostream& os, const CheckpointStatistics& stats);
+
+// One gate placed on the circuit. Qubits without an op at a timestep hold the identity,
+// so no padding is stored.
+struct CircuitOp {
+    GateId gate;
+    int timestep;
+    int target;
+    std::uint32_t firstControl;    // controls are controlQubits[firstControl, firstControl + controlCount)
+    std::uint32_t controlCount;
+    std::uint32_t firstParameter;  // angles are parameterValues[firstParameter, firstParameter + parameterCount)
+    std::uint32_t parameterCount;
+};
 
 class Circuit {
 private:
     int qubits;
-    Matrix stateVector;
-    std::vector<std::vector<std::shared_ptr<QuantumComponent>>> Qcircuit;  // outer vector: timesteps, inner vector: gates for each qubit
+    int timesteps;
+    SimulationMode mode;
+    StorageLayout layout;
+    Precision precision;
+    bool fidelityCheck;                // rerun in fp64 after reduced-precision runs and compare
+    double fidelity;                   // |<psi64|psi32>|^2 of the normalized states of the last checked run, NaN before one
+    std::shared_ptr<ThreadPool> pool;  // persistent workers for the state vector kernels, null when serial
+    int fusionQubits;                  // widest fused operation, 0 disables fusion
+    FusionStatistics fusionStatistics;
+    bool verbose;                      // print the state after applyCircuit
+    mutable Matrix stateVector;        // allocated on first use; |0...0> until then
+    mutable MatrixF singleStateVector; // the state after a Single/Mixed run; only one of the two is held
+    mutable SplitComplexArray splitStateVector;  // the state between Split layout runs, instead of stateVector
+    mutable StabilizerTableau tableau; // the state after a Stabilizer run, while stabilizerActive
+    mutable bool stabilizerActive;
+    mutable MatrixProductState mps;    // the state after a MatrixProductState run, while mpsActive
+    mutable bool mpsActive;
+    int maxBondDimension;
+    double truncationCutoff;           // singular values below cutoff * largest are dropped
+    mutable Matrix densityState;       // rho as a 4^n x 1 vector after a DensityMatrix run; while held it is the state and no amplitudes are
+    NoiseModel noise;
+    Matrix stateBatch;                 // 2^n x B block of states for batch runs, one state per column
+    mutable std::shared_ptr<MeasurementSampler> sampler;  // alias table of the current state, built on first sample
+    std::vector<CircuitOp> Qcircuit;   // sorted by (timestep, target)
+    std::vector<int> controlQubits;    // control lists of controlled ops, referenced by offset
+    std::vector<double> parameterValues;  // angles of parameterized ops, referenced by offset
     std::vector<std::shared_ptr<QuantumComponent>> componentLibrary;
+    std::shared_ptr<UnitaryCache> unitaryCache;  // dense timestep and block operators, shared by copies; null when off
+    int checkpointInterval;            // 0 disables incremental re-simulation
+    std::size_t checkpointBudget;      // bytes of checkpoints kept besides the input state
+    std::map<int, Matrix> checkpoints; // state before each timestep key; 0 is the state the circuit was applied to
+    std::vector<std::string> checkpointKeys;  // layerKey of every timestep at the last checkpointed run
+    CheckpointStatistics checkpointStatistics;
+
+    void runOperations(const std::vector<GateOperation>& operations);
+    Matrix& state() const;
+    MatrixF& singleState() const;
+    SplitComplexArray& splitState() const;
+    // Copy of the amplitudes that leaves them in whichever layout holds them
+    Matrix stateSnapshot() const;
+    void restoreState(const Matrix& amplitudes);
+    void runSingleOperations(const std::vector<GateOperation>& operations);
+    // Re-simulates from the last checkpoint before the first timestep that changed since the previous run
+    void runFromCheckpoints();
+    void clearCheckpoints();
+    // Whether the operations can run on the tableau; otherwise reason says why not
+    bool stabilizerApplies(const std::vector<GateOperation>& operations, std::string& reason) const;
+    // Turns the pure state into rho on the first DensityMatrix run, dropping the amplitudes
+    Matrix& density() const;
+    // Throws while rho is the state: amplitudes of a mixed state do not exist
+    void requirePureState() const;
+    // Outcome distribution of the current state (rho's diagonal after a DensityMatrix run), readout error applied
+    std::vector<double> outcomeProbabilities() const;
+    // Uncontrolled op on every qubit at one timestep, null where the qubit idles
+    std::vector<const CircuitOp*> timestepOps(int timestep) const;
+    std::shared_ptr<QuantumComponent> componentFor(const CircuitOp& op) const;
+    // Identifies a timestep by its content: every op's gate, qubits and angles
+    std::string layerKey(int timestep) const;
+    // Uncontrolled gates of a timestep as a lazy Kronecker product; gates keeps the factors alive
+    KroneckerExpression<double> timestepKronecker(int timestep, std::vector<std::shared_ptr<QuantumComponent>>& gates) const;
+    bool hasControlledOps(int timestep) const;
+    Matrix buildTimestepMatrix(int timestep) const;
+    std::shared_ptr<const Matrix> timestepMatrix(int timestep, const std::string& key) const;
+    // (L[first + period - 1] ... L[first])^count, by repeated squaring
+    std::shared_ptr<const Matrix> blockPower(const std::vector<std::string>& keys, int first, int period, int count) const;
+    // firstParameter is the index in getParameters() of the timestep's first angle
+    std::vector<GateOperation> compileTimestep(int timestep, int firstParameter) const;
+    // Runs operations on a copy of the current state
+    Matrix simulate(const std::vector<GateOperation>& operations) const;
+    // Adjoint gradient shared by both observable types; observe(psi) returns O psi
+    std::vector<double> adjointGradient(const std::function<Matrix(const Matrix&)>& observe) const;
+    std::vector<CircuitOp>::iterator timestepBegin(int timestep);
+    std::vector<CircuitOp>::const_iterator timestepBegin(int timestep) const;
+    // Removes every op at the timestep whose target or controls touch one of the qubits
+    void clearQubits(int timestep, const std::vector<int>& cells);
+    void insertOp(const CircuitOp& op);
 
 public:
     // Constructor
     Circuit(int num_qubits);
-    // Copy constructor & assignment operator
-    Circuit(const Circuit& other);
-    Circuit& operator=(const Circuit& other);
+    // Copy constructor & assignment operator; ops are plain values, so copies are cheap
+    Circuit(const Circuit& other) = default;
+    Circuit& operator=(const Circuit& other) = default;
 
     // Initialization methods
     void initializeStateVector(const std::vector<Complex>& initialValues);
     void addGate(std::shared_ptr<QuantumComponent> gate, int qubit, int timestep);
+    // Applies a single-qubit gate to target only where every control qubit is |1>.
+    // Qubits need not be adjacent or ordered; any gates already on them at that timestep are replaced.
+    void addControlledGate(std::shared_ptr<QuantumComponent> gate, const std::vector<int>& controls, int target, int timestep);
     void addComponentToLibrary(const std::string& name);
 
     // Calculation methods
     Matrix calculateTimestepMatrix(int timestep) const;
+    // Runs of a repeated block of up to 64 timesteps are multiplied once and raised to their repeat count
     Matrix calculateTotalMatrix() const;
+    // Both keep their timestep operators and repeated block products in an LRU cache of `bytes`
+    // (default 256 MiB, 0 turns it off); this replaces the cache with an empty one
+    void setUnitaryCacheCapacity(std::size_t bytes);
+    UnitaryCacheStatistics getUnitaryCacheStatistics() const;
+
+    // Lowers a timestep to the gate operations it applies, following the Kronecker ordering
+    std::vector<GateOperation> compileTimestep(int timestep) const;
+    // Every timestep's operations in execution order, before fusion
+    std::vector<GateOperation> compileCircuit() const;
+
+    void setSimulationMode(SimulationMode newMode);
+    SimulationMode getSimulationMode() const;
+    // Storage used by the state vector kernels while the circuit is applied
+    void setStorageLayout(StorageLayout newLayout);
+    StorageLayout getStorageLayout() const;
+    // Amplitude precision of StateVector runs; the other modes always use double. The state is
+    // kept in the precision it was last updated in and converted when the other one is needed.
+    void setPrecision(Precision newPrecision);
+    Precision getPrecision() const;
+    // After each Single/Mixed run, also runs the circuit in fp64 from the same input and records
+    // the fidelity between the two final states (doubles the run time and memory)
+    void setFidelityCheck(bool enabled);
+    double getFidelity() const;
+    // Fuses gates into operations of up to maxFusedQubits qubits before execution (0 = off)
+    void setGateFusion(int maxFusedQubits);
+    // Totals over the last run, which checkpointed runs fuse in several segments
+    const FusionStatistics& getFusionStatistics() const;
+    // Rewrites the circuit with the peephole pass of CircuitOptimizer: cancels inverse pairs and
+    // merges phase gates and rotations, then drops timesteps left empty. The unitary is unchanged,
+    // but parameterized gates may merge, so getParameters() can shrink.
+    OptimizationStatistics optimize();
+    // Incremental re-simulation for StateVector runs in double precision. applyCircuit keeps the
+    // state it was first applied to plus a copy every `interval` timesteps, within budgetBytes (the
+    // interval doubles until they fit). Each later applyCircuit recomputes the circuit on that same
+    // input, resuming from the last checkpoint before the first timestep whose gates or angles
+    // changed; without changes it leaves the state as it is. initializeStateVector, a run in another
+    // mode or interval 0 (the default) discard the checkpoints.
+    void setCheckpointInterval(int interval, std::size_t budgetBytes = std::size_t(1) << 30);
+    const CheckpointStatistics& getCheckpointStatistics() const;
+    // Bond dimension limit and singular value cutoff of MatrixProductState runs (default 64, 1e-12)
+    void setMaxBondDimension(int maxBond, double cutoff = 1e-12);
+    int getMaxBondDimension() const;
+    // Largest bond reached and weight discarded by truncation so far
+    MPSStatistics getMPSStatistics() const;
+    // Runs the state vector kernels on a persistent pool of `threads` threads (0 = all cores, 1 = serial)
+    void setThreadCount(int threads);
+    int getThreadCount() const;
+    const Matrix& getStateVector() const;
+
+    int getQubits() const;
+    int getTimesteps() const;
+    const std::vector<CircuitOp>& getOperations() const;
+    std::vector<int> getControls(const CircuitOp& op) const;
+    std::vector<double> getParameters(const CircuitOp& op) const;
+
+    // Every angle of every parameterized gate, in op order; setParameters rewrites them in place
+    std::vector<double> getParameters() const;
+    void setParameters(const std::vector<double>& values);
+
+    // <psi|O|psi> for the current state
+    double expectation(const Matrix& observable) const;
+    // Same for a sum of Pauli strings, evaluated on the state vector without a 2^n x 2^n matrix
+    double expectation(const PauliObservable& observable) const;
+    // d<psi|O|psi>/d(angle) for every entry of getParameters(), where psi is the circuit applied
+    // to the current state. Adjoint method: one forward pass storing checkpoints, then one
+    // backward pass over the state and the co-state, about three simulations in total.
+    std::vector<double> gradient(const Matrix& observable) const;
+    std::vector<double> gradient(const PauliObservable& observable) const;
+    // Parameter-shift rule, two simulations per angle; uncontrolled parameterized gates only
+    std::vector<double> parameterShiftGradient(const Matrix& observable) const;
+    // Grid view with one component per (timestep, qubit) cell, derived from the op list.
+    // A controlled gate appears on its target cell; its control cells hold the identity. When
+    // controlTargets is given it gets the same shape, holding on each control cell the target
+    // qubit of the gate it controls and -1 elsewhere.
+    std::vector<std::vector<std::shared_ptr<QuantumComponent>>> getGrid(
+        std::vector<std::vector<int>>* controlTargets = nullptr) const;
+
+    // Batch mode: each column of states is one input state; applyCircuitBatch updates all columns per gate
+    void initializeStateBatch(const Matrix& states);
+    // One column per listed computational basis state
+    void initializeBasisBatch(const std::vector<std::size_t>& basisStates);
+    void applyCircuitBatch();
+    const Matrix& getStateBatch() const;
+
+    // Draws shots from the current state; the alias table is built once per state
+    MeasurementCounts sample(std::uint64_t shots, std::uint64_t seed = 0) const;
+    // Samples only the listed qubits (measured[0] is the rightmost bit) from their marginal distribution
+    MeasurementCounts sampleMarginal(const std::vector<int>& measured, std::uint64_t shots, std::uint64_t seed = 0) const;
+    // Gate noise is applied in DensityMatrix mode and by sampleTrajectories; readout error by every sampler
+    void setNoiseModel(const NoiseModel& model);
+    const NoiseModel& getNoiseModel() const;
+    // rho as a 2^n x 2^n matrix (|psi><psi| before the first DensityMatrix run). A DensityMatrix
+    // run replaces the amplitudes with rho, so until initializeStateVector starts a new pure state,
+    // getStateVector, expectation and runs in other modes throw.
+    Matrix getDensityMatrix() const;
+    // Quantum trajectories: runs the circuit on `trajectories` copies of the current state, each
+    // picking Kraus operators at random, and measures each once. Memory is one state per thread
+    // instead of 4^n; trajectories run in parallel and the counts do not depend on the thread count.
+    MeasurementCounts sampleTrajectories(std::uint64_t trajectories, std::uint64_t seed = 0) const;
+    // Turns off the amplitude listing printed by applyCircuit, for large runs
+    void setVerbose(bool printState);
 
     // Circuit configuration and application
     void configureCircuit();
     void applyCircuit();
+    // Applies the circuit to a memory-mapped state instead of the in-memory one, for registers
+    // beyond the 30 qubits a Matrix can hold
+    OutOfCoreStatistics applyCircuit(OutOfCoreStateVector& storage) const;
+    // Splits the state over `processes` forked processes (a power of two) by its top qubits and
+    // applies the circuit across them; the result is gathered back into this circuit's state
+    DistributedStatistics applyCircuitDistributed(int processes, TransportKind transport = TransportKind::SharedMemory,
+                                                  int threadsPerProcess = 1);
 
     // Printing
     void printCircuit() const;
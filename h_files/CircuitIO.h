@@ -0,0 +1,28 @@
+#ifndef CIRCUITIO_H
+#define CIRCUITIO_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "Circuit.h"
+
+// Builds circuits from files instead of the interactive prompts of Circuit::configureCircuit.
+class CircuitIO {
+public:
+    // OpenQASM 2.0 subset: qreg/creg, id x y z h s sdg t tdg, rx ry rz u1 p u2 u3 u, cx cy cz ch crx cry crz
+    // cu1 cp cu3, ccx, swap, barrier and measure (ignored; sample the final state instead).
+    // Statements are parsed one at a time from the stream, and each gate is placed at the
+    // earliest timestep its qubits are free.
+    static Circuit readQasm(std::istream& in);
+
+    // Compact binary format: "QCB1", qubit count, op count, then one fixed-layout record per op
+    // (gate id, control and angle counts, timestep, target, controls, angles) in timestep order.
+    // Integers and doubles are stored in host byte order.
+    static Circuit readBinary(std::istream& in);
+    static void writeBinary(const Circuit& circuit, std::ostream& out);
+
+    // Picks the reader from the extension: ".qcb" is binary, anything else is read as QASM
+    static Circuit readFile(const std::string& path);
+};
+
+#endif // CIRCUITIO_H
@@ -0,0 +1,44 @@
+#ifndef CIRCUIT_OPTIMIZER_H
+#define CIRCUIT_OPTIMIZER_H
+
+#include <vector>
+#include <cstddef>
+#include <iostream>
+#include "Gates.h"
+
+// A gate with its qubits and angles spelled out, independent of any circuit's storage
+struct PlacedGate {
+    GateId gate;
+    int timestep;
+    int target;
+    std::vector<int> controls;
+    std::vector<double> parameters;
+};
+
+struct OptimizationStatistics {
+    std::size_t inputGates = 0;
+    std::size_t outputGates = 0;
+    std::size_t cancelledPairs = 0;     // self-inverse gates removed together with an identical partner
+    std::size_t mergedRotations = 0;    // phase and rotation gates folded into an earlier one on the same qubits
+    std::size_t removedIdentities = 0;  // identity gates, including merged rotations that came to a full turn
+    std::size_t commutations = 0;       // gates moved past a commuting gate to reach their partner
+    int inputTimesteps = 0;
+    int outputTimesteps = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const OptimizationStatistics& stats);
+
+// Peephole pass over a circuit's gates in execution order. Each gate looks back past gates it
+// commutes with for an earlier one on the same target and controls: H, X, Y and Z pairs cancel,
+// S/T/Z/Phase gates add their angles into one diagonal phase, and Rx, Ry or Rz gates add into one
+// rotation. Two gates commute when on every shared qubit both are diagonal (a control, or a Z, S,
+// T, Phase or Rz target), or both are X-type (X or Rx targets) or Y-type, so diagonal gates pass
+// through controls and CNOTs sharing a target pass each other. Every rewrite is an exact identity.
+// Timesteps holding the fixed CNOT/Toffoli blocks are left untouched and nothing moves across them.
+class CircuitOptimizer {
+public:
+    // gates must be sorted by timestep; survivors keep the timestep of the earliest gate they absorbed
+    static std::vector<PlacedGate> optimize(const std::vector<PlacedGate>& gates, OptimizationStatistics* stats = nullptr);
+};
+
+#endif // CIRCUIT_OPTIMIZER_H
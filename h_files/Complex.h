@@ -4,35 +4,78 @@
 #include <iostream>
 #include <cmath>
 #include <sstream>
+#include <stdexcept>
 
-class Complex {
+// Complex number over a floating-point scalar. Construction, access and arithmetic are inline
+// so the kernels' per-amplitude loops compile to plain scalar code; modulus, argument and the
+// stream operators are defined in Complex.cpp and instantiated there for double and float only.
+template <typename T>
+class BasicComplex {
 private:
-    double real, imag;
+    T real, imag;
 
 public:
-    Complex(double real_i = 0, double imag_i = 0);
-    Complex(const Complex& other);
-    ~Complex();
-
-    double get_real() const;
-    double get_imag() const;
-    void set_real(double r);
-    void set_imag(double i);
-
-    double modulus() const;
-    double argument() const;
-
-    Complex operator+(const Complex& other) const;
-    Complex operator-(const Complex& other) const;
-    Complex operator*(const Complex& other) const;
-    Complex operator/(const Complex& other) const;
-    Complex& operator+=(const Complex& other);
-    Complex conjugate() const;
-
-    friend std::ostream& operator<<(std::ostream& os, const Complex& cn);
-    friend std::istream& operator>>(std::istream& is, Complex& cn);
+    using Scalar = T;
+
+    BasicComplex(T real_i = 0, T imag_i = 0) : real(real_i), imag(imag_i) {}
+    BasicComplex(const BasicComplex& other) = default;
+    // Precision conversion, e.g. BasicComplex<float>(doubleValue)
+    template <typename U>
+    explicit BasicComplex(const BasicComplex<U>& other) : real(T(other.get_real())), imag(T(other.get_imag())) {}
+    ~BasicComplex() = default;
+
+    BasicComplex& operator=(const BasicComplex& other) = default;
+
+    T get_real() const { return real; }
+    T get_imag() const { return imag; }
+    void set_real(T r) { real = r; }
+    void set_imag(T i) { imag = i; }
+
+    T modulus() const;
+    T argument() const;
+
+    BasicComplex operator+(const BasicComplex& other) const {
+        return BasicComplex(real + other.real, imag + other.imag);
+    }
+
+    BasicComplex operator-(const BasicComplex& other) const {
+        return BasicComplex(real - other.real, imag - other.imag);
+    }
+
+    BasicComplex operator*(const BasicComplex& other) const {
+        return BasicComplex(real * other.real - imag * other.imag, real * other.imag + imag * other.real);
+    }
+
+    BasicComplex operator/(const BasicComplex& other) const {
+        T denominator = other.real * other.real + other.imag * other.imag;
+        if (denominator == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        return BasicComplex((real * other.real + imag * other.imag) / denominator,
+                            (imag * other.real - real * other.imag) / denominator);
+    }
+
+    BasicComplex& operator+=(const BasicComplex& other) {
+        real += other.real;
+        imag += other.imag;
+        return *this;
+    }
+
+    BasicComplex conjugate() const { return BasicComplex(real, -imag); }
+
+    template <typename U>
+    friend std::ostream& operator<<(std::ostream& os, const BasicComplex<U>& cn);
+    template <typename U>
+    friend std::istream& operator>>(std::istream& is, BasicComplex<U>& cn);
 };
 
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const BasicComplex<T>& cn);
+template <typename T>
+std::istream& operator>>(std::istream& is, BasicComplex<T>& cn);
+
+using Complex = BasicComplex<double>;
+using ComplexF = BasicComplex<float>;
 
-#endif // Complex_H
 
+#endif // Complex_H
@@ -0,0 +1,37 @@
+#ifndef DENSITYMATRIX_H
+#define DENSITYMATRIX_H
+
+#include <vector>
+#include "Matrix.h"
+#include "Gates.h"
+#include "Complex.h"
+#include "ThreadPool.h"
+#include "StateVector.h"
+
+// Mixed-state kernels. rho is stored as a vector over 2n qubits: entry (r, c) sits at index
+// r + (c << n), so the row bits are qubits 0..n-1 and the column bits are qubits n..2n-1.
+// U rho U^dagger is then U on the row qubits followed by conj(U) on the column qubits, which
+// the StateVectorSimulator kernels apply in place. No 4^n x 4^n superoperator is formed.
+class DensityMatrixSimulator {
+public:
+    // |psi><psi| as a 4^n x 1 vector
+    static Matrix fromState(const Complex* amplitudes, int qubits);
+    // Unpacks the vector into the 2^n x 2^n matrix
+    static Matrix toMatrix(const Complex* rho, int qubits);
+
+    static void applyOperation(Complex* rho, int qubits, const GateOperation& op, ThreadPool* pool = nullptr);
+    // sum_k K rho K^dagger for single-qubit Kraus operators, applied as one 4x4 update of the
+    // (row bit, column bit) pair of the qubit
+    static void applyChannel(Complex* rho, int qubits, const std::vector<Matrix>& kraus, int qubit, ThreadPool* pool = nullptr);
+
+    // The diagonal of rho
+    static std::vector<double> probabilities(const Complex* rho, int qubits);
+
+    // One quantum-trajectory step on a pure state: Kraus operator k is chosen with probability
+    // ||K_k psi||^2 (uniform is a draw in [0, 1)), applied and the state renormalised.
+    // Returns the chosen k.
+    static int applyTrajectoryChannel(Complex* amplitudes, int qubits, const std::vector<Matrix>& kraus, int qubit,
+                                      double uniform, ThreadPool* pool = nullptr);
+};
+
+#endif // DENSITYMATRIX_H
@@ -0,0 +1,66 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include "Complex.h"
+#include "Gates.h"
+#include "ThreadPool.h"
+#include "Transport.h"
+
+enum class TransportKind {
+    SharedMemory,  // mailboxes in a shared mapping, single host
+    Tcp            // sockets on 127.0.0.1, the same protocol that would span hosts
+};
+
+struct DistributedStatistics {
+    int processes = 1;
+    int globalQubits = 0;              // top qubits that select the process
+    std::uint64_t exchanges = 0;       // half-partition swaps this process took part in
+    std::uint64_t bytesExchanged = 0;  // bytes this process sent
+    double computeSeconds = 0;         // local gate kernels
+    double exchangeSeconds = 0;        // swaps, with packing and unpacking overlapped with the transfer
+};
+
+std::ostream& operator<<(std::ostream& os, const DistributedStatistics& stats);
+
+// One process's share of a state vector split over P = 2^g processes by its top g qubits:
+// rank r holds the 2^(n-g) amplitudes whose top bits equal r. Gates on local qubits run with
+// no communication, and a control on a global qubit just decides whether this rank applies
+// the gate. A gate targeting a global qubit first swaps that qubit with a local one, which
+// costs each rank of a pair half its slice. The swap streams in chunks, packing the next
+// chunk and unpacking the previous one while the current chunk is in flight. Gates do not run
+// during a swap: every local gate sweeps the whole slice, half of which the swap rewrites. The
+// evicted local qubit is the one whose next use lies furthest ahead.
+class DistributedStateVector {
+public:
+    // initialSlice points at this rank's 2^(n-g) amplitudes
+    DistributedStateVector(Transport& transport, int qubits, const Complex* initialSlice, ThreadPool* pool = nullptr);
+
+    DistributedStatistics run(const std::vector<GateOperation>& operations);
+    // Swaps every moved qubit back, then collects the slices on rank 0 in logical order.
+    // output (2^n amplitudes) is only written on rank 0.
+    void gather(Complex* output);
+
+    // Forks processes - 1 workers, runs the operations across all of them with the calling
+    // process as rank 0, and gathers the final state back into amplitudes. Rank 0's
+    // statistics are returned.
+    static DistributedStatistics simulate(Complex* amplitudes, int qubits, const std::vector<GateOperation>& operations,
+                                          int processes, TransportKind kind, int threadsPerProcess = 1);
+
+private:
+    Transport& transport;
+    ThreadPool* pool;
+    int qubits;
+    int localQubits;
+    std::vector<Complex> local;
+    std::vector<int> position;     // physical bit of every logical qubit
+    std::vector<int> logicalAt;    // logical qubit held by every physical bit
+    std::vector<std::pair<int, int>> swapLog;
+    DistributedStatistics stats;
+
+    void swapQubits(int global, int low);
+};
+
+#endif // DISTRIBUTED_H
@@ -0,0 +1,34 @@
+#ifndef GATEFUSION_H
+#define GATEFUSION_H
+
+#include <vector>
+#include <iostream>
+#include "Matrix.h"
+#include "Gates.h"
+
+struct FusionStatistics {
+    std::size_t inputOperations = 0;
+    std::size_t outputOperations = 0;
+    std::size_t singleQubitMerges = 0;   // 2x2 gates multiplied into a neighbouring 2x2 gate
+    std::size_t absorbedIntoWider = 0;   // gates folded into a two- or three-qubit operation
+
+    // Totals over several fuse calls, e.g. the segments of one run
+    FusionStatistics& operator+=(const FusionStatistics& other);
+};
+
+std::ostream& operator<<(std::ostream& os, const FusionStatistics& stats);
+
+// Multiplies adjacent gates on the same qubits into one unitary, so each fused group
+// costs a single sweep over the state vector instead of one per gate.
+class GateFusion {
+public:
+    // maxFusedQubits = 1 only merges single-qubit runs; 2 (or 3) also folds single-qubit
+    // gates into neighbouring multi-qubit operations of at most that many qubits.
+    static std::vector<GateOperation> fuse(const std::vector<GateOperation>& operations, int maxFusedQubits,
+                                           FusionStatistics* stats = nullptr);
+
+    // Embeds a gate acting on `from` into a matrix acting on the superset `to`
+    static Matrix expandToTargets(const Matrix& gate, const std::vector<int>& from, const std::vector<int>& to);
+};
+
+#endif // GATEFUSION_H
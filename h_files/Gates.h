@@ -3,90 +3,206 @@
 #include <cmath>
 #include <memory>
 #include <iostream>
+#include <vector>
+#include <cstdint>
 #include "Matrix.h"
 #include "Complex.h"
 
+// Compact identifier for each gate type, used by the flat circuit representation
+enum class GateId : std::uint8_t {
+    Identity,
+    Hadamard,
+    PauliX,
+    PauliY,
+    PauliZ,
+    CNOTcontrol,
+    CNOTtarget,
+    Toffoli,
+    SGate,
+    TGate,
+    RotationX,
+    RotationY,
+    RotationZ,
+    Phase,
+    U3
+};
+
 class QuantumComponent {
 public:
     virtual ~QuantumComponent() = default;
-    virtual Matrix getMatrix() const = 0;
+    // Copy of the gate's matrix; hot loops should use getMatrixRef instead
+    virtual Matrix getMatrix() const;
+    // Precomputed matrix shared by every instance of the gate type, built once on first use
+    virtual const Matrix& getMatrixRef() const = 0;
     virtual std::string getName() const = 0;
+    virtual GateId getId() const = 0;
     virtual std::shared_ptr<QuantumComponent> clone() const = 0;  //clone method to allow copy of circuits
+    // Runtime angles of parameterized gates; empty for fixed gates
+    virtual std::vector<double> getParameters() const;
 };
 
 class QuantumComponentFactory {
 public:
+    // Gates are immutable, so every call for the same name returns the same shared instance
     static std::shared_ptr<QuantumComponent> create(const std::string& name);
+    static std::shared_ptr<QuantumComponent> create(GateId id);
+    // Parameterized gates ("Rx", "Ry", "Rz", "Phase", "U3") are built fresh with the given angles
+    static std::shared_ptr<QuantumComponent> create(const std::string& name, const std::vector<double>& parameters);
+    static std::shared_ptr<QuantumComponent> create(GateId id, const std::vector<double>& parameters);
 };
 
 class HadamardGate : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class PauliXGate : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class PauliYGate : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class PauliZGate : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class CNOTcontrol : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class CNOTtarget : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class ToffoliGatetarget : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class Identity : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class SGate : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
 class TGate : public QuantumComponent {
 public:
-    Matrix getMatrix() const override;
+    const Matrix& getMatrixRef() const override;
     std::string getName() const override;
+    GateId getId() const override;
     std::shared_ptr<QuantumComponent> clone() const override;
 };
 
+// Gate whose matrix depends on runtime angles. The matrix is computed once at construction,
+// so getMatrixRef stays allocation-free; a new angle means a new instance.
+class ParameterizedGate : public QuantumComponent {
+protected:
+    std::vector<double> parameters;
+    Matrix matrix;
+
+public:
+    ParameterizedGate(std::vector<double> values, Matrix gateMatrix);
+    const Matrix& getMatrixRef() const override;
+    std::vector<double> getParameters() const override;
+    // dU/d(parameters[index])
+    virtual Matrix getDerivative(int index) const = 0;
+};
+
+// exp(-i theta X / 2)
+class RxGate : public ParameterizedGate {
+public:
+    explicit RxGate(double theta);
+    std::string getName() const override;
+    GateId getId() const override;
+    std::shared_ptr<QuantumComponent> clone() const override;
+    Matrix getDerivative(int index) const override;
+};
+
+// exp(-i theta Y / 2)
+class RyGate : public ParameterizedGate {
+public:
+    explicit RyGate(double theta);
+    std::string getName() const override;
+    GateId getId() const override;
+    std::shared_ptr<QuantumComponent> clone() const override;
+    Matrix getDerivative(int index) const override;
+};
+
+// exp(-i theta Z / 2)
+class RzGate : public ParameterizedGate {
+public:
+    explicit RzGate(double theta);
+    std::string getName() const override;
+    GateId getId() const override;
+    std::shared_ptr<QuantumComponent> clone() const override;
+    Matrix getDerivative(int index) const override;
+};
+
+// diag(1, e^(i lambda)); lambda = pi/2 is the S gate and pi/4 the T gate
+class PhaseGate : public ParameterizedGate {
+public:
+    explicit PhaseGate(double lambda);
+    std::string getName() const override;
+    GateId getId() const override;
+    std::shared_ptr<QuantumComponent> clone() const override;
+    Matrix getDerivative(int index) const override;
+};
+
+// General single-qubit rotation U3(theta, phi, lambda), as in OpenQASM
+class U3Gate : public ParameterizedGate {
+public:
+    U3Gate(double theta, double phi, double lambda);
+    std::string getName() const override;
+    GateId getId() const override;
+    std::shared_ptr<QuantumComponent> clone() const override;
+    Matrix getDerivative(int index) const override;
+};
+
+// A gate lowered onto concrete qubits: bit i of the matrix index is qubit targets[i].
+// The matrix only acts on amplitudes where every control qubit is |1>.
+struct GateOperation {
+    Matrix matrix;
+    std::vector<int> targets;
+    std::vector<int> controls;
+    int firstParameter = -1;  // index of the gate's first angle in Circuit::getParameters, -1 if fixed
+};
+
 #endif // GATES_H
\ No newline at end of file
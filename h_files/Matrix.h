@@ -5,42 +5,100 @@
 #include <iomanip>
 #include <cmath>
 #include <sstream>
+#include <vector>
 #include "Complex.h"
 
-class Matrix {
+class ThreadPool;
+class MatrixAllocator;
+template <typename E>
+class MatrixExpression;
+
+// Dense complex matrix over BasicComplex<T>, 1-based element access. Members are defined in
+// Matrix.cpp and instantiated for double and float; products are always accumulated in double.
+// Storage comes from MatrixAllocator::current() (MatrixAllocator.h), a pool by default.
+template <typename T>
+class BasicMatrix {
 private:
     int rows, cols;
-    Complex* matrix_data;
+    BasicComplex<T>* matrix_data;
+    MatrixAllocator* allocator;  // where matrix_data came from, null when there is none
+
+    // Uninitialised storage for rows * cols elements from the current allocator
+    void allocateStorage();
+    void releaseStorage();
 
 public:
-    Matrix(int nrows, int ncols);
-    Matrix(const Matrix& other);
-    Matrix(Matrix&& other);
-    ~Matrix();
+    BasicMatrix();  // empty 0 x 0 matrix
+    BasicMatrix(int nrows, int ncols);
+    BasicMatrix(const BasicMatrix& other);
+    BasicMatrix(BasicMatrix&& other);
+    // Precision conversion, e.g. BasicMatrix<float>(doubleMatrix)
+    template <typename U>
+    explicit BasicMatrix(const BasicMatrix<U>& other) : BasicMatrix(other.getRows(), other.getCols()) {
+        for (int i = 0; i < rows * cols; i++) {
+            matrix_data[i] = BasicComplex<T>(other.data()[i]);
+        }
+    }
+    // Evaluates a lazy expression (MatrixExpression.h) in one pass, without temporaries
+    template <typename E>
+    BasicMatrix(const MatrixExpression<E>& expression);
+    ~BasicMatrix();
 
-    Matrix& operator=(const Matrix& other);
-    Matrix& operator=(Matrix&& other);
+    // Keeps the buffer when the element count matches
+    BasicMatrix& operator=(const BasicMatrix& other);
+    BasicMatrix& operator=(BasicMatrix&& other);
+    // Reuses the storage when the shape matches; the expression may read this matrix
+    template <typename E>
+    BasicMatrix& operator=(const MatrixExpression<E>& expression);
 
-    friend std::ostream& operator<<(std::ostream& os, const Matrix& mat);
-    friend std::istream& operator>>(std::istream& is, Matrix& mat);
+    template <typename U>
+    friend std::ostream& operator<<(std::ostream& os, const BasicMatrix<U>& mat);
+    template <typename U>
+    friend std::istream& operator>>(std::istream& is, BasicMatrix<U>& mat);
 
-    Complex& operator()(int i, int j); //modifcation to take place
-    Complex operator()(int i, int j) const; //promises not to modify the object.
+    BasicComplex<T>& operator()(int i, int j); //modifcation to take place
+    BasicComplex<T> operator()(int i, int j) const; //promises not to modify the object.
 
-    Matrix operator+(const Matrix& other) const;
-    Matrix operator-(const Matrix& other) const;
-    Matrix operator*(const Matrix& other) const;
+    BasicMatrix operator+(const BasicMatrix& other) const;
+    BasicMatrix operator-(const BasicMatrix& other) const;
+    BasicMatrix operator*(const BasicMatrix& other) const;
 
-    Matrix transpose() const;
-    Matrix submatrix(int row, int col) const;
-    Complex determinant() const;
+    BasicMatrix transpose() const;
+    BasicMatrix adjoint() const;  // conjugate transpose
+    BasicMatrix submatrix(int row, int col) const;
+    BasicComplex<T> determinant() const;
+    // Thin QR by Householder reflections: *this (m x n) = q (m x k) * r (k x n), k = min(m, n),
+    // with orthonormal columns in q and r upper triangular
+    void qrDecomposition(BasicMatrix& q, BasicMatrix& r) const;
+    // Thin SVD by one-sided Jacobi rotations: *this = u * diag(s) * v^dagger with u (m x k),
+    // v (n x k), k = min(m, n) and s in descending order. Columns of u or v that belong to a
+    // zero singular value are left zero. Accumulates in double for either precision.
+    void singularValueDecomposition(BasicMatrix& u, std::vector<T>& s, BasicMatrix& v) const;
     int getRows() const;
     int getCols() const;
 
+    // Raw row-major storage, used by the in-place state vector kernels
+    BasicComplex<T>* data();
+    const BasicComplex<T>* data() const;
+
     // Add the static function declarations
-    static Matrix identityMatrix(int size);
-    static Matrix kroneckerProduct(const Matrix& a, const Matrix& b);
+    static BasicMatrix identityMatrix(int size);
+    static BasicMatrix kroneckerProduct(const BasicMatrix& a, const BasicMatrix& b);
+
+    // Cache-blocked product: operands are packed into split real/imaginary panels and row
+    // blocks of the result are spread over the pool (null = calling thread only)
+    static BasicMatrix multiply(const BasicMatrix& a, const BasicMatrix& b, ThreadPool* pool);
+    // Kronecker product written row by row, rows spread over the pool
+    static BasicMatrix kroneckerProduct(const BasicMatrix& a, const BasicMatrix& b, ThreadPool* pool);
 };
 
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const BasicMatrix<T>& mat);
+template <typename T>
+std::istream& operator>>(std::istream& is, BasicMatrix<T>& mat);
+
+using Matrix = BasicMatrix<double>;
+using MatrixF = BasicMatrix<float>;
+
 
 #endif // MATRIX_H
@@ -0,0 +1,120 @@
+#ifndef MATRIX_ALLOCATOR_H
+#define MATRIX_ALLOCATOR_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <unordered_map>
+
+struct AllocationStatistics {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t reused = 0;             // allocations served from a cached buffer
+    std::uint64_t systemAllocations = 0;  // allocations that needed fresh memory from the heap or mmap
+    std::uint64_t hugePageMappings = 0;   // fresh mappings backed by explicit huge pages (MAP_HUGETLB)
+    std::size_t bytesInUse = 0;
+    std::size_t peakBytesInUse = 0;
+    std::size_t bytesCached = 0;          // freed buffers kept for reuse
+};
+
+std::ostream& operator<<(std::ostream& os, const AllocationStatistics& stats);
+
+// Source of Matrix storage. Each matrix remembers the allocator its buffer came from and
+// returns it there, so switching the current allocator only affects later allocations; an
+// allocator must outlive every matrix it allocated. Buffers are 64-byte aligned.
+class MatrixAllocator {
+public:
+    virtual ~MatrixAllocator() = default;
+
+    virtual void* allocate(std::size_t bytes) = 0;
+    // bytes is the size passed to allocate
+    virtual void deallocate(void* memory, std::size_t bytes) = 0;
+    // Returns cached buffers to the system
+    virtual void release() {}
+    virtual AllocationStatistics getStatistics() const;
+
+    // Allocator of newly created matrices, for every thread; the pool until changed
+    static MatrixAllocator& current();
+    // nullptr restores the pool
+    static void setCurrent(MatrixAllocator* allocator);
+
+    // Process-wide instances, never destroyed
+    static MatrixAllocator& heap();
+    static MatrixAllocator& pool();
+    static MatrixAllocator& hugePages();
+
+protected:
+    // Thread-safe; the counters have their own lock
+    void recordAllocation(std::size_t bytes, bool reused, bool hugePages = false);
+    void recordDeallocation(std::size_t bytes);
+    void setCachedBytes(std::size_t bytes);
+
+private:
+    mutable std::mutex statsMutex;
+    AllocationStatistics stats;
+};
+
+// new/delete on every call, as Matrix did before allocators
+class HeapAllocator : public MatrixAllocator {
+public:
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* memory, std::size_t bytes) override;
+};
+
+// Anonymous mappings in multiples of 2 MiB, for state vectors. Each mapping asks for explicit
+// huge pages and falls back to transparent huge pages (madvise) when none are reserved, so a
+// sweep over the state takes far fewer TLB misses and page faults. Freed mappings are kept by
+// size, up to maxCachedBytes, and handed out again to requests of the same rounded size.
+class HugePageArena : public MatrixAllocator {
+private:
+    std::size_t maxCached;
+    std::size_t cached;
+    std::multimap<std::size_t, void*> freeMappings;  // by mapped size
+    mutable std::mutex mutex;
+
+public:
+    static constexpr std::size_t hugePageSize = std::size_t(2) << 20;
+
+    explicit HugePageArena(std::size_t maxCachedBytes = std::size_t(1) << 30);
+    ~HugePageArena() override;
+
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* memory, std::size_t bytes) override;
+    void release() override;
+
+    // The same without updating this arena's counters, for allocators built on it
+    void* acquire(std::size_t bytes, bool& reused, bool& huge);
+    void recycle(void* memory, std::size_t bytes);
+    std::size_t getCachedBytes() const;
+};
+
+// Size-bucketed free lists. Requests are rounded up to one of four classes per power of two
+// (at most 25% slack) and freed buffers wait in their class's list, up to maxCachedBytes in
+// all, so the matrices a simulation loop creates and destroys stop reaching the heap. Requests
+// of largeThreshold bytes or more go to a HugePageArena, which caches them the same way.
+class PoolAllocator : public MatrixAllocator {
+private:
+    std::size_t maxCached;
+    std::size_t cached;
+    std::size_t largeThreshold;
+    std::unordered_map<std::size_t, std::vector<void*>> freeLists;  // by class size
+    HugePageArena large;
+    mutable std::mutex mutex;
+
+    static std::size_t classSize(std::size_t bytes);
+
+public:
+    explicit PoolAllocator(std::size_t maxCachedBytes = std::size_t(256) << 20,
+                           std::size_t largeThresholdBytes = HugePageArena::hugePageSize);
+    ~PoolAllocator() override;
+
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* memory, std::size_t bytes) override;
+    void release() override;
+    AllocationStatistics getStatistics() const override;
+};
+
+#endif // MATRIX_ALLOCATOR_H
@@ -0,0 +1,325 @@
+#ifndef MATRIX_EXPRESSION_H
+#define MATRIX_EXPRESSION_H
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// Lazy matrix arithmetic. An expression only records its operands; assigning it to a BasicMatrix
+// evaluates every element in one pass straight into the matrix's storage, so
+// lazy(a) + b - c * Complex(2) allocates once instead of once per operator. Operands are held by
+// reference and must outlive the expression: evaluate it within the statement that builds it.
+// The eager BasicMatrix operators are unchanged.
+template <typename E>
+class MatrixExpression {
+public:
+    const E& derived() const { return static_cast<const E&>(*this); }
+
+    // Default evaluation: element by element from at(), rows spread over the pool
+    template <typename T>
+    void evaluateInto(BasicComplex<T>* out, ThreadPool* pool) const {
+        const E& expression = derived();
+        const std::size_t cols = expression.getCols();
+        auto body = [&](std::size_t firstRow, std::size_t lastRow) {
+            for (std::size_t row = firstRow; row < lastRow; ++row) {
+                for (std::size_t col = 0; col < cols; ++col) {
+                    out[row * cols + col] = expression.at(row, col);
+                }
+            }
+        };
+        runRows(expression.getRows(), pool, body);
+    }
+
+protected:
+    static void runRows(std::size_t rows, ThreadPool* pool, const std::function<void(std::size_t, std::size_t)>& body) {
+        if (pool && rows > 32) {
+            pool->parallelFor(0, rows, 32, body);
+        } else {
+            body(0, rows);
+        }
+    }
+};
+
+template <typename T>
+class MatrixView : public MatrixExpression<MatrixView<T>> {
+private:
+    const BasicMatrix<T>& matrix;
+
+public:
+    using Scalar = T;
+
+    explicit MatrixView(const BasicMatrix<T>& m) : matrix(m) {}
+    int getRows() const { return matrix.getRows(); }
+    int getCols() const { return matrix.getCols(); }
+    BasicComplex<T> at(std::size_t row, std::size_t col) const { return matrix.data()[row * matrix.getCols() + col]; }
+};
+
+struct AddElements {
+    template <typename T>
+    BasicComplex<T> operator()(const BasicComplex<T>& a, const BasicComplex<T>& b) const { return a + b; }
+};
+
+struct SubtractElements {
+    template <typename T>
+    BasicComplex<T> operator()(const BasicComplex<T>& a, const BasicComplex<T>& b) const { return a - b; }
+};
+
+template <typename L, typename R, typename Op>
+class ElementwiseExpression : public MatrixExpression<ElementwiseExpression<L, R, Op>> {
+private:
+    L left;
+    R right;
+
+public:
+    using Scalar = typename L::Scalar;
+
+    ElementwiseExpression(const L& a, const R& b) : left(a), right(b) {
+        if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+            throw std::invalid_argument("Matrix dimensions must match");
+        }
+    }
+    int getRows() const { return left.getRows(); }
+    int getCols() const { return left.getCols(); }
+    BasicComplex<Scalar> at(std::size_t row, std::size_t col) const { return Op()(left.at(row, col), right.at(row, col)); }
+};
+
+template <typename E>
+class ScaledExpression : public MatrixExpression<ScaledExpression<E>> {
+private:
+    E inner;
+    BasicComplex<typename E::Scalar> factor;
+
+public:
+    using Scalar = typename E::Scalar;
+
+    ScaledExpression(const E& expression, const BasicComplex<Scalar>& scale) : inner(expression), factor(scale) {}
+    int getRows() const { return inner.getRows(); }
+    int getCols() const { return inner.getCols(); }
+    BasicComplex<Scalar> at(std::size_t row, std::size_t col) const { return inner.at(row, col) * factor; }
+};
+
+// F_0 (x) F_1 (x) ... (x) F_k-1, F_0 the most significant factor
+template <typename T>
+class KroneckerExpression : public MatrixExpression<KroneckerExpression<T>> {
+private:
+    std::vector<const BasicMatrix<T>*> factors;
+    std::size_t rows, cols;
+
+    static bool isIdentity(const BasicMatrix<T>& m) {
+        const int size = m.getRows();
+        for (int i = 0; i < size; ++i) {
+            for (int j = 0; j < size; ++j) {
+                const BasicComplex<T>& value = m.data()[i * size + j];
+                if (value.get_imag() != 0 || value.get_real() != (i == j ? 1 : 0)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    using Scalar = T;
+
+    explicit KroneckerExpression(std::vector<const BasicMatrix<T>*> factorList) : factors(std::move(factorList)), rows(1), cols(1) {
+        for (const BasicMatrix<T>* factor : factors) {
+            rows *= factor->getRows();
+            cols *= factor->getCols();
+        }
+    }
+    int getRows() const { return int(rows); }
+    int getCols() const { return int(cols); }
+
+    BasicComplex<T> at(std::size_t row, std::size_t col) const {
+        BasicComplex<T> value(1, 0);
+        for (auto it = factors.rbegin(); it != factors.rend(); ++it) {
+            const int r = (*it)->getRows(), c = (*it)->getCols();
+            value = value * (*it)->data()[(row % r) * c + col % c];
+            row /= r;
+            col /= c;
+        }
+        return value;
+    }
+
+    // Each row is expanded factor by factor from the least significant, about two operations
+    // per element and no intermediate matrices
+    void evaluateInto(BasicComplex<T>* out, ThreadPool* pool) const {
+        auto body = [&](std::size_t firstRow, std::size_t lastRow) {
+            std::vector<BasicComplex<T>> current(cols), next(cols);
+            std::vector<std::size_t> factorRows(factors.size());
+            for (std::size_t row = firstRow; row < lastRow; ++row) {
+                std::size_t rest = row;
+                for (std::size_t m = factors.size(); m-- > 0;) {
+                    factorRows[m] = rest % factors[m]->getRows();
+                    rest /= factors[m]->getRows();
+                }
+                current[0] = BasicComplex<T>(1, 0);
+                std::size_t length = 1;
+                for (std::size_t m = factors.size(); m-- > 0;) {
+                    const int c = factors[m]->getCols();
+                    const BasicComplex<T>* factorRow = factors[m]->data() + factorRows[m] * c;
+                    BasicComplex<T>* target = m == 0 ? out + row * cols : next.data();
+                    for (int j = 0; j < c; ++j) {
+                        for (std::size_t t = 0; t < length; ++t) {
+                            target[j * length + t] = factorRow[j] * current[t];
+                        }
+                    }
+                    length *= c;
+                    if (m > 0) {
+                        current.swap(next);
+                    }
+                }
+                if (factors.empty()) {
+                    out[row] = BasicComplex<T>(1, 0);
+                }
+            }
+        };
+        this->runRows(rows, pool, body);
+    }
+
+    BasicMatrix<T> evaluate(ThreadPool* pool = nullptr) const {
+        BasicMatrix<T> result(static_cast<int>(rows), static_cast<int>(cols));
+        evaluateInto(result.data(), pool);
+        return result;
+    }
+
+    // (F_0 (x) ... (x) F_k-1) x for square factors without forming the product: one pass over a
+    // copy of x per factor, O(sum of factor sizes * size of x), identity factors skipped
+    BasicMatrix<T> apply(const BasicMatrix<T>& x, ThreadPool* pool = nullptr) const {
+        if (rows != cols) {
+            throw std::invalid_argument("Lazy Kronecker products apply square factors only");
+        }
+        if (std::size_t(x.getRows()) != cols) {
+            throw std::invalid_argument("Matrix dimensions must match");
+        }
+        BasicMatrix<T> result(x);
+        BasicComplex<T>* data = result.data();
+        const std::size_t total = rows * x.getCols();
+
+        // Rows of x are (outer, i, inner) with i the factor's index; each fiber over i is
+        // multiplied by the factor in place
+        std::size_t inner = x.getCols();
+        for (std::size_t m = factors.size(); m-- > 0;) {
+            const BasicMatrix<T>& factor = *factors[m];
+            const std::size_t d = factor.getRows();
+            if (factor.getCols() != int(d)) {
+                throw std::invalid_argument("Lazy Kronecker products apply square factors only");
+            }
+            if (d > 1 && !isIdentity(factor)) {
+                std::vector<double> factorRe(d * d), factorIm(d * d);
+                for (std::size_t e = 0; e < d * d; ++e) {
+                    factorRe[e] = factor.data()[e].get_real();
+                    factorIm[e] = factor.data()[e].get_imag();
+                }
+                auto body = [&](std::size_t first, std::size_t last) {
+                    std::vector<double> re(d), im(d);
+                    for (std::size_t fiber = first; fiber < last; ++fiber) {
+                        const std::size_t base = (fiber / inner) * d * inner + fiber % inner;
+                        for (std::size_t j = 0; j < d; ++j) {
+                            re[j] = data[base + j * inner].get_real();
+                            im[j] = data[base + j * inner].get_imag();
+                        }
+                        for (std::size_t i = 0; i < d; ++i) {
+                            double sumRe = 0, sumIm = 0;
+                            for (std::size_t j = 0; j < d; ++j) {
+                                const double fr = factorRe[i * d + j], fi = factorIm[i * d + j];
+                                sumRe += fr * re[j] - fi * im[j];
+                                sumIm += fr * im[j] + fi * re[j];
+                            }
+                            data[base + i * inner] = BasicComplex<T>(T(sumRe), T(sumIm));
+                        }
+                    }
+                };
+                const std::size_t fibers = total / d;
+                if (pool && fibers > 4096) {
+                    pool->parallelFor(0, fibers, 4096, body);
+                } else {
+                    body(0, fibers);
+                }
+            }
+            inner *= d;
+        }
+        return result;
+    }
+};
+
+template <typename T>
+MatrixView<T> lazy(const BasicMatrix<T>& m) {
+    return MatrixView<T>(m);
+}
+
+template <typename T, typename... Rest>
+KroneckerExpression<T> kron(const BasicMatrix<T>& first, const Rest&... rest) {
+    return KroneckerExpression<T>({&first, &rest...});
+}
+
+template <typename T>
+BasicMatrix<T> operator*(const KroneckerExpression<T>& product, const BasicMatrix<T>& x) {
+    return product.apply(x);
+}
+
+template <typename L, typename R>
+ElementwiseExpression<L, R, AddElements> operator+(const MatrixExpression<L>& a, const MatrixExpression<R>& b) {
+    return {a.derived(), b.derived()};
+}
+
+template <typename L>
+ElementwiseExpression<L, MatrixView<typename L::Scalar>, AddElements> operator+(const MatrixExpression<L>& a, const BasicMatrix<typename L::Scalar>& b) {
+    return {a.derived(), MatrixView<typename L::Scalar>(b)};
+}
+
+template <typename R>
+ElementwiseExpression<MatrixView<typename R::Scalar>, R, AddElements> operator+(const BasicMatrix<typename R::Scalar>& a, const MatrixExpression<R>& b) {
+    return {MatrixView<typename R::Scalar>(a), b.derived()};
+}
+
+template <typename L, typename R>
+ElementwiseExpression<L, R, SubtractElements> operator-(const MatrixExpression<L>& a, const MatrixExpression<R>& b) {
+    return {a.derived(), b.derived()};
+}
+
+template <typename L>
+ElementwiseExpression<L, MatrixView<typename L::Scalar>, SubtractElements> operator-(const MatrixExpression<L>& a, const BasicMatrix<typename L::Scalar>& b) {
+    return {a.derived(), MatrixView<typename L::Scalar>(b)};
+}
+
+template <typename R>
+ElementwiseExpression<MatrixView<typename R::Scalar>, R, SubtractElements> operator-(const BasicMatrix<typename R::Scalar>& a, const MatrixExpression<R>& b) {
+    return {MatrixView<typename R::Scalar>(a), b.derived()};
+}
+
+template <typename E>
+ScaledExpression<E> operator*(const MatrixExpression<E>& a, const BasicComplex<typename E::Scalar>& scale) {
+    return {a.derived(), scale};
+}
+
+template <typename E>
+ScaledExpression<E> operator*(const BasicComplex<typename E::Scalar>& scale, const MatrixExpression<E>& a) {
+    return {a.derived(), scale};
+}
+
+// BasicMatrix members declared in Matrix.h
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>::BasicMatrix(const MatrixExpression<E>& expression)
+: BasicMatrix(expression.derived().getRows(), expression.derived().getCols()) {
+    expression.derived().evaluateInto(matrix_data, nullptr);
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>& BasicMatrix<T>::operator=(const MatrixExpression<E>& expression) {
+    const E& e = expression.derived();
+    if (rows == e.getRows() && cols == e.getCols()) {
+        e.evaluateInto(matrix_data, nullptr);
+    } else {
+        *this = BasicMatrix(expression);
+    }
+    return *this;
+}
+
+#endif // MATRIX_EXPRESSION_H
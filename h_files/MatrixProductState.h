@@ -0,0 +1,74 @@
+#ifndef MATRIX_PRODUCT_STATE_H
+#define MATRIX_PRODUCT_STATE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include "Matrix.h"
+#include "Gates.h"
+#include "Measurement.h"
+#include "ThreadPool.h"
+
+struct MPSStatistics {
+    int maxBond = 1;                // largest bond dimension reached
+    std::uint64_t truncations = 0;  // splits capped at maxBond
+    double discardedWeight = 0;     // sum over splits of the discarded squared singular values
+    double fidelity = 1;            // product of (1 - discarded weight), an estimate of |<exact|mps>|^2
+    std::uint64_t swaps = 0;        // nearest-neighbour swaps routing gates on distant qubits
+};
+
+std::ostream& operator<<(std::ostream& os, const MPSStatistics& stats);
+
+// State of a chain of qubits as a product of one tensor per qubit, linked by bonds of at most
+// maxBond dimensions. Weakly entangled states of hundreds of qubits stay small: memory is
+// O(n maxBond^2) and a two-qubit gate costs O(maxBond^3). Multi-qubit gates contract their
+// sites, apply the gate and split the result with truncated SVDs, so the state is exact until
+// a bond would exceed maxBond or a singular value falls below cutoff times the largest.
+// Gates on distant qubits are routed through nearest-neighbour swaps and swapped back.
+class MatrixProductState {
+private:
+    int qubits;
+    int maxBond;
+    double cutoff;
+    std::vector<Matrix> sites;  // site q: (left bond * 2) x right bond, row = left * 2 + bit of qubit q
+    int center;                 // sites left of it are left-orthonormal, sites right of it right-orthonormal
+    MPSStatistics stats;
+
+    void checkQubit(int qubit) const;
+    // Moves the orthogonality center by QR (rightwards) or LQ (leftwards) steps, without truncation
+    void moveCenter(int site);
+    // theta is (left * 2^count) x right with site `first` as the highest bit; splits it back into
+    // sites [first, first + count) and leaves the center on the last of them
+    void splitBlock(int first, int count, const Matrix& theta);
+    // Applies a 2^count x 2^count matrix to sites [first, first + count), site `first` as its highest bit
+    void applyBlock(int first, int count, const Matrix& block);
+    void swapSites(int site);  // exchanges the qubits on site and site + 1
+
+public:
+    // |0...0>
+    explicit MatrixProductState(int qubits = 0, int maxBond = 64, double cutoff = 1e-12);
+    // Decomposes 2^qubits amplitudes by successive SVDs, truncated like any gate
+    static MatrixProductState fromStateVector(const Complex* amplitudes, int qubits, int maxBond = 64, double cutoff = 1e-12);
+
+    int getQubits() const;
+    // Applies to later gates only
+    void setTruncation(int newMaxBond, double newCutoff);
+    std::vector<int> getBondDimensions() const;
+    const MPSStatistics& getStatistics() const;
+
+    void applyOperation(const GateOperation& op);
+
+    // Amplitude of a basis state written like the sampled outcomes, highest qubit leftmost
+    Complex amplitude(const std::string& bitstring) const;
+    // Shots drawn qubit by qubit from the conditional marginals, O(n maxBond^2) each, in fixed
+    // chunks with their own RNG streams so the counts do not depend on the number of threads
+    MeasurementCounts sample(std::uint64_t shots, std::uint64_t seed = 0, ThreadPool* pool = nullptr) const;
+    // 2^n x 1 state vector; at most 30 qubits
+    Matrix toStateVector() const;
+
+    // Bond dimensions along the chain
+    friend std::ostream& operator<<(std::ostream& os, const MatrixProductState& state);
+};
+
+#endif // MATRIX_PRODUCT_STATE_H
@@ -0,0 +1,40 @@
+#ifndef MEASUREMENT_H
+#define MEASUREMENT_H
+
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Complex.h"
+#include "ThreadPool.h"
+
+// Sampled bitstrings and how often each occurred; the highest measured qubit is leftmost
+using MeasurementCounts = std::map<std::string, std::uint64_t>;
+
+// Walker/Vose alias table over a discrete distribution. Built once in O(N), after which
+// every shot costs one random number and one table lookup.
+class MeasurementSampler {
+private:
+    int bits;
+    std::vector<double> threshold;
+    std::vector<std::uint64_t> alias;
+
+public:
+    // Distribution |amplitude|^2 over 2^qubits basis states
+    MeasurementSampler(const Complex* amplitudes, int qubits);
+    // Arbitrary distribution over 2^bits outcomes; it is renormalised
+    MeasurementSampler(const std::vector<double>& probabilities, int bits);
+
+    // Shots are drawn in fixed-size chunks, each with its own RNG stream derived from seed,
+    // so the counts are the same for any number of threads.
+    MeasurementCounts sample(std::uint64_t shots, std::uint64_t seed = 0, ThreadPool* pool = nullptr) const;
+    std::uint64_t draw(double uniform) const;
+
+    // Probabilities of the measured qubits alone, accumulated in one pass over the state.
+    // Bit i of the outcome index is measured[i].
+    static std::vector<double> marginalProbabilities(const Complex* amplitudes, int qubits, const std::vector<int>& measured);
+    static std::string toBitstring(std::uint64_t index, int bits);
+};
+
+#endif // MEASUREMENT_H
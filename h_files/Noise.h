@@ -0,0 +1,40 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <vector>
+#include <cstdint>
+#include <random>
+#include "Matrix.h"
+
+// Noise applied by the DensityMatrix mode and by Circuit::sampleTrajectories. Gate noise is a
+// list of single-qubit Kraus channels applied, in order, to every qubit an operation touches
+// right after that operation. Readout error flips measured bits independently.
+class NoiseModel {
+private:
+    std::vector<std::vector<Matrix>> gateChannels;
+    double flipZeroToOne;  // P(read 1 | qubit is 0)
+    double flipOneToZero;  // P(read 0 | qubit is 1)
+
+public:
+    NoiseModel();
+
+    // Kraus operators must be 2x2 and satisfy sum_k K^dagger K = I
+    void addGateChannel(const std::vector<Matrix>& kraus);
+    void setReadoutError(double zeroToOne, double oneToZero);
+
+    const std::vector<std::vector<Matrix>>& getGateChannels() const;
+    bool hasGateNoise() const;
+    bool hasReadoutError() const;
+
+    // Mixes a distribution over 2^qubits outcomes through the per-bit confusion matrix, O(n 2^n)
+    void applyReadoutError(std::vector<double>& probabilities, int qubits) const;
+    // Flips the bits of one sampled outcome
+    std::uint64_t applyReadoutError(std::uint64_t outcome, int qubits, std::mt19937_64& rng) const;
+
+    // rho -> (1 - p) rho + p I/2
+    static std::vector<Matrix> depolarizing(double p);
+    // |1> decays to |0> with probability gamma
+    static std::vector<Matrix> amplitudeDamping(double gamma);
+};
+
+#endif // NOISE_H
@@ -0,0 +1,71 @@
+#ifndef OBSERVABLE_H
+#define OBSERVABLE_H
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include "Matrix.h"
+#include "ThreadPool.h"
+
+// coefficient * P(n-1) ... P(0). Bit q of xMask is set where P(q) is X or Y and bit q of zMask
+// where it is Z or Y, so P|i> = i^(number of Y) (-1)^popcount(i & zMask) |i ^ xMask>.
+struct PauliTerm {
+    double coefficient;
+    std::uint64_t xMask;
+    std::uint64_t zMask;
+};
+
+// Hermitian observable given as a real-weighted sum of Pauli strings, evaluated directly on a
+// state vector without forming the 2^n x 2^n matrix. Terms with the same X mask pair the same
+// amplitudes, so they are evaluated together in one sweep over the state; all diagonal (Z-only)
+// terms form a single group. Within a block of the state a group's combined weight is a
+// Walsh-Hadamard transform of its Z masks, so large groups cost O(terms + block log block)
+// per block rather than O(terms * block).
+class PauliObservable {
+private:
+    std::vector<PauliTerm> terms;  // one entry per distinct string, coefficients summed
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::size_t> termIndex;  // (xMask, zMask) -> terms index
+
+    struct Group {
+        std::uint64_t xMask;
+        std::vector<std::uint64_t> zMasks;
+        std::vector<double> weightReal, weightImag;  // coefficient * i^(number of Y)
+    };
+    std::vector<Group> groups() const;
+    // w(high | low) = sum_t weight_t (-1)^popcount((high | low) & zMask_t) for every low < 2^bits,
+    // by a Walsh-Hadamard transform; smaller groups evaluate the sum per amplitude instead
+    static void blockWeights(const Group& group, std::uint64_t high, int bits, std::vector<double>& real, std::vector<double>& imag);
+    void checkQubits(int qubits) const;
+
+public:
+    PauliObservable() = default;
+
+    // Sum of terms such as "0.5*Z0Z1 + X2 - 1.5 Y0 X3 + 2". Factors are X, Y, Z or I followed by
+    // a qubit index and may be separated by spaces or '*'; a term without factors is a constant.
+    static PauliObservable parse(const std::string& text);
+
+    // paulis in the same factor notation, e.g. "Z0 Z1"
+    void addTerm(double coefficient, const std::string& paulis);
+    void addTerm(const PauliTerm& term);
+
+    const std::vector<PauliTerm>& getTerms() const;
+    // Highest qubit acted on + 1
+    int getQubits() const;
+    // Number of sweeps over the state one evaluation takes
+    std::size_t getGroupCount() const;
+
+    // <psi|H|psi> over 2^qubits amplitudes. Partial sums are kept per fixed block of the state,
+    // so the result does not depend on the number of threads.
+    double expectation(const Complex* amplitudes, int qubits, ThreadPool* pool = nullptr) const;
+    // output = H psi; output must not alias amplitudes
+    void apply(const Complex* amplitudes, Complex* output, int qubits, ThreadPool* pool = nullptr) const;
+    // Dense 2^qubits x 2^qubits matrix, for checking against the Matrix path
+    Matrix toMatrix(int qubits) const;
+
+    friend std::ostream& operator<<(std::ostream& os, const PauliObservable& observable);
+};
+
+#endif // OBSERVABLE_H
@@ -0,0 +1,69 @@
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include "Complex.h"
+#include "Gates.h"
+#include "ThreadPool.h"
+
+struct OutOfCoreStatistics {
+    std::uint64_t passes = 0;            // block-local sweeps over the state
+    std::uint64_t swaps = 0;             // block swaps that bring a high qubit into the block
+    std::uint64_t bytesRead = 0;         // state bytes streamed through memory by passes and swaps
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t diskBytesRead = 0;     // as counted by the OS; only page cache misses reach the disk
+    std::uint64_t diskBytesWritten = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const OutOfCoreStatistics& stats);
+
+// State vector kept in a memory-mapped file, for registers whose 16 * 2^n bytes exceed RAM.
+// The file is processed in blocks of 2^blockQubits amplitudes. Gates on the low
+// (block-local) qubits are grouped into passes, and each pass visits every block once and
+// applies the whole group to it before moving on. A gate whose target is a high qubit first
+// swaps that qubit with a low one, exchanging half of two blocks at a time. The evicted low
+// qubit is the one whose next use lies furthest ahead. Qubit q is bit q of the logical index.
+class OutOfCoreStateVector {
+public:
+    // Creates (or truncates) the file and initialises it to |0...0>
+    OutOfCoreStateVector(const std::string& path, int qubits, int blockQubits = 22);
+    ~OutOfCoreStateVector();
+
+    OutOfCoreStateVector(const OutOfCoreStateVector&) = delete;
+    OutOfCoreStateVector& operator=(const OutOfCoreStateVector&) = delete;
+
+    int getQubits() const;
+    int getBlockQubits() const;
+
+    // Applies the operations in order. With restoreOrder the qubits swapped out of place are
+    // swapped back at the end, so the file holds the amplitudes in logical order.
+    OutOfCoreStatistics run(const std::vector<GateOperation>& operations, ThreadPool* pool = nullptr, bool restoreOrder = true);
+
+    // Amplitude of a logical basis state, valid whether or not the order was restored
+    Complex amplitude(std::uint64_t index) const;
+    double norm() const;
+    // Undoes the block swaps left by run(..., restoreOrder = false)
+    void restoreQubitOrder(ThreadPool* pool = nullptr);
+
+private:
+    std::string path;
+    int qubits;
+    int blockQubits;
+    int fd;
+    std::size_t bytes;
+    Complex* amplitudes;           // mapped file
+    std::vector<int> position;     // physical bit of every logical qubit
+    std::vector<int> logicalAt;    // logical qubit held by every physical bit
+    std::vector<std::pair<int, int>> swapLog;  // physical (high, low) swaps since the order was last restored
+    OutOfCoreStatistics* current;
+
+    void applyPass(const std::vector<GateOperation>& pass, ThreadPool* pool);
+    void swapQubits(int high, int low, ThreadPool* pool);
+    std::uint64_t physicalIndex(std::uint64_t logical) const;
+};
+
+#endif // OUTOFCORE_H
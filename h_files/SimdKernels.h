@@ -0,0 +1,25 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>
+
+// Multiply-accumulate loops over split (separate real / imaginary) arrays. The vector
+// width is chosen at compile time: AVX-512 when built with -mavx512f, AVX2 with -mavx2,
+// and a plain scalar loop otherwise.
+class SimdKernels {
+public:
+    // y += a * x
+    static void complexAxpy(std::size_t n, double aReal, double aImag,
+                            const double* xReal, const double* xImag, double* yReal, double* yImag);
+    // out = a * x
+    static void complexScale(std::size_t n, double aReal, double aImag,
+                             const double* xReal, const double* xImag, double* outReal, double* outImag);
+    // (x0, x1) <- U (x0, x1) for n pairs; u holds u00, u01, u10, u11 as real, imag pairs
+    static void pairUpdate(std::size_t n, const double u[8],
+                           double* x0Real, double* x0Imag, double* x1Real, double* x1Imag);
+
+    // Name of the instruction set the kernels were compiled for
+    static const char* instructionSet();
+};
+
+#endif // SIMDKERNELS_H
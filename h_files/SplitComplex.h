@@ -0,0 +1,43 @@
+#ifndef SPLITCOMPLEX_H
+#define SPLITCOMPLEX_H
+
+#include <cstddef>
+#include "Complex.h"
+
+class MatrixAllocator;
+
+// Structure-of-arrays complex storage: real and imaginary parts live in separate
+// 64-byte aligned arrays so the SIMD kernels can load full vectors of either part.
+// Both come from MatrixAllocator::current() and go back to the allocator they came from.
+class SplitComplexArray {
+private:
+    std::size_t length;
+    MatrixAllocator* allocator;
+    double* realData;
+    double* imagData;
+
+    void releaseStorage();
+
+public:
+    explicit SplitComplexArray(std::size_t n = 0);
+    SplitComplexArray(const Complex* values, std::size_t n);
+    SplitComplexArray(const SplitComplexArray& other);
+    SplitComplexArray(SplitComplexArray&& other);
+    ~SplitComplexArray();
+
+    SplitComplexArray& operator=(const SplitComplexArray& other);
+    SplitComplexArray& operator=(SplitComplexArray&& other);
+
+    std::size_t size() const;
+    double* real();
+    double* imag();
+    const double* real() const;
+    const double* imag() const;
+
+    Complex get(std::size_t index) const;
+    void set(std::size_t index, const Complex& value);
+    // Writes the values back into interleaved storage
+    void copyTo(Complex* values) const;
+};
+
+#endif // SPLITCOMPLEX_H
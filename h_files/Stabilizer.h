@@ -0,0 +1,65 @@
+#ifndef STABILIZER_H
+#define STABILIZER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include "Matrix.h"
+#include "Gates.h"
+#include "Measurement.h"
+#include "ThreadPool.h"
+
+// Stabilizer state in the Aaronson-Gottesman tableau form: n destabilizer and n stabilizer
+// generators, each a signed Pauli string stored as bit-packed X and Z rows, 64 qubits per word.
+// Clifford gates update every row in O(n), so circuits of thousands of qubits stay cheap;
+// amplitudes are only available up to a global phase, and only for small registers.
+class StabilizerTableau {
+private:
+    int qubits;
+    int words;                         // 64-bit words per row
+    std::vector<std::uint64_t> xBits;  // 2n rows of `words` words; rows [0, n) destabilizers, [n, 2n) stabilizers
+    std::vector<std::uint64_t> zBits;
+    std::vector<std::uint8_t> phase;   // row sign is (-1)^phase
+
+    std::uint64_t* xRow(int row);
+    std::uint64_t* zRow(int row);
+    const std::uint64_t* xRow(int row) const;
+    const std::uint64_t* zRow(int row) const;
+    void checkQubit(int qubit) const;
+
+public:
+    // |0...0>
+    explicit StabilizerTableau(int qubits = 0);
+
+    int getQubits() const;
+
+    void hadamard(int qubit);
+    void phaseGate(int qubit);  // S
+    void pauliX(int qubit);
+    void pauliY(int qubit);
+    void pauliZ(int qubit);
+    void cnot(int control, int target);
+    void cz(int control, int target);
+    void cy(int control, int target);
+
+    // Single-qubit Cliffords (matched up to a global phase, so rotations by multiples of pi/2
+    // qualify) and X, Y or Z with one control
+    static bool isClifford(const GateOperation& op);
+    // Throws std::invalid_argument for an operation isClifford rejects
+    void applyOperation(const GateOperation& op);
+
+    // Computational-basis shots, highest qubit leftmost. The outcomes of a stabilizer state are
+    // uniform over an affine subspace, found once by Gaussian elimination; each shot then costs
+    // O(n^2 / 64). Shots are drawn in fixed chunks with their own RNG streams, so the counts do not
+    // depend on the number of threads.
+    MeasurementCounts sample(std::uint64_t shots, std::uint64_t seed = 0, ThreadPool* pool = nullptr) const;
+
+    // 2^n x 1 state vector, up to a global phase; at most 30 qubits
+    Matrix toStateVector() const;
+
+    // Stabilizer generators, one signed Pauli string per line with qubit 0 leftmost
+    friend std::ostream& operator<<(std::ostream& os, const StabilizerTableau& tableau);
+};
+
+#endif // STABILIZER_H
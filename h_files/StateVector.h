@@ -0,0 +1,54 @@
+#ifndef STATEVECTOR_H
+#define STATEVECTOR_H
+
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+#include "Matrix.h"
+#include "Gates.h"
+#include "Complex.h"
+#include "ThreadPool.h"
+#include "SplitComplex.h"
+
+// In-place gate kernels. Qubit q is bit q of the amplitude index, matching the
+// Kronecker ordering used by Circuit::calculateTimestepMatrix.
+class StateVectorSimulator {
+public:
+    // A null pool runs the kernels on the calling thread. The interleaved kernels are instantiated
+    // for Complex and ComplexF states; gate matrices stay in double and are rounded per call.
+    template <typename T>
+    static void applyOperation(BasicComplex<T>* amplitudes, int qubits, const GateOperation& op, ThreadPool* pool = nullptr);
+
+    // Strided amplitude-pair update, O(2^n) per gate
+    template <typename T>
+    static void applySingleQubitGate(BasicComplex<T>* amplitudes, int qubits, const Matrix& gate, int target, ThreadPool* pool = nullptr);
+    // Gathers the 2^k amplitudes of every target subspace, multiplies, scatters back
+    template <typename T>
+    static void applyMultiQubitGate(BasicComplex<T>* amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets, ThreadPool* pool = nullptr);
+
+    // Visits only the amplitudes whose control bits are all set; no enlarged matrix is formed
+    template <typename T>
+    static void applyControlledGate(BasicComplex<T>* amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets,
+                                    const std::vector<int>& controls, ThreadPool* pool = nullptr);
+    static void applyControlledGate(SplitComplexArray& amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets,
+                                    const std::vector<int>& controls, ThreadPool* pool = nullptr);
+
+    // Applies op to every column of a row-major 2^qubits x batch block of states. Each row is
+    // contiguous, so one amplitude update becomes a small matrix product over `batch` columns.
+    static void applyOperationBatch(Complex* block, int qubits, int batch, const GateOperation& op, ThreadPool* pool = nullptr);
+
+    // Same kernels over split real/imaginary storage; pair updates run through SimdKernels
+    static void applyOperation(SplitComplexArray& amplitudes, int qubits, const GateOperation& op, ThreadPool* pool = nullptr);
+    static void applySingleQubitGate(SplitComplexArray& amplitudes, int qubits, const Matrix& gate, int target, ThreadPool* pool = nullptr);
+    static void applyMultiQubitGate(SplitComplexArray& amplitudes, int qubits, const Matrix& gate, const std::vector<int>& targets, ThreadPool* pool = nullptr);
+
+    // Spreads the bits of index apart so that every bit listed in sortedBits is zero
+    static std::size_t insertZeroBits(std::size_t index, const std::vector<int>& sortedBits);
+
+    // Number of consecutive pair indices handed to one worker. Chunks are whole multiples of
+    // the target stride when the stride is small, so each chunk sweeps complete blocks.
+    static std::size_t chunkSize(std::size_t pairs, std::size_t stride, int threads);
+};
+
+#endif // STATEVECTOR_H
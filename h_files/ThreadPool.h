@@ -0,0 +1,52 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstddef>
+#include <algorithm>
+
+// Persistent pool of worker threads. Workers sleep between jobs, so a pool can be
+// reused for every gate of a circuit without paying thread start-up costs.
+class ThreadPool {
+public:
+    // threads <= 0 selects std::thread::hardware_concurrency()
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const;
+
+    // Splits [begin, end) into chunks of `chunk` indices and runs body(chunkBegin, chunkEnd)
+    // on the workers and the calling thread. Returns once every chunk has finished; the
+    // first exception thrown by body is rethrown here. Nested calls run serially.
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t chunk,
+                     const std::function<void(std::size_t, std::size_t)>& body);
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex submitMutex;  // one job at a time
+    std::mutex stateMutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable jobDone;
+
+    const std::function<void(std::size_t, std::size_t)>* job;
+    std::size_t jobEnd, jobChunk;
+    std::atomic<std::size_t> nextIndex;
+    std::size_t generation;
+    int busyWorkers;
+    bool stopping;
+    std::exception_ptr firstError;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,82 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Point-to-point byte transport between the worker processes of a distributed run. A transport
+// is constructed in the parent before the workers are forked, and each process then calls
+// attach(rank) once. send and receive block until the whole buffer has been moved. exchange
+// swaps equal-sized buffers with a peer without deadlocking when both sides send at once.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual void attach(int rank) = 0;
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    virtual void send(int peer, const void* data, std::size_t bytes) = 0;
+    virtual void receive(int peer, void* data, std::size_t bytes) = 0;
+    virtual void exchange(int peer, const void* sendData, void* receiveData, std::size_t bytes) = 0;
+    virtual void barrier() = 0;
+};
+
+// One single-slot mailbox per ordered pair of processes in an anonymous shared mapping.
+// Messages larger than a slot are streamed through it chunk by chunk.
+class SharedMemoryTransport : public Transport {
+public:
+    explicit SharedMemoryTransport(int processes, std::size_t slotBytes = std::size_t(1) << 17);
+    ~SharedMemoryTransport() override;
+
+    void attach(int rank) override;
+    int rank() const override;
+    int size() const override;
+
+    void send(int peer, const void* data, std::size_t bytes) override;
+    void receive(int peer, void* data, std::size_t bytes) override;
+    void exchange(int peer, const void* sendData, void* receiveData, std::size_t bytes) override;
+    void barrier() override;
+
+private:
+    struct Mailbox;
+    int processes;
+    int self;
+    std::size_t slotBytes;
+    std::size_t mailboxBytes;
+    std::size_t regionBytes;
+    void* region;
+
+    Mailbox* mailbox(int from, int to) const;
+    void putSlot(int peer, const char* data, std::size_t bytes);
+    void takeSlot(int peer, char* data, std::size_t bytes);
+};
+
+// TCP over loopback (or any reachable hosts later): the listening sockets are bound to
+// ephemeral ports before the fork, and attach connects every pair of processes.
+class TcpTransport : public Transport {
+public:
+    explicit TcpTransport(int processes, const std::string& host = "127.0.0.1");
+    ~TcpTransport() override;
+
+    void attach(int rank) override;
+    int rank() const override;
+    int size() const override;
+
+    void send(int peer, const void* data, std::size_t bytes) override;
+    void receive(int peer, void* data, std::size_t bytes) override;
+    void exchange(int peer, const void* sendData, void* receiveData, std::size_t bytes) override;
+    void barrier() override;
+
+private:
+    int processes;
+    int self;
+    std::string host;
+    std::vector<int> listeners;   // one per rank, bound before the fork
+    std::vector<int> ports;
+    std::vector<int> peers;       // connected socket per rank, -1 for self
+};
+
+#endif // TRANSPORT_H
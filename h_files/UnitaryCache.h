@@ -0,0 +1,53 @@
+#ifndef UNITARY_CACHE_H
+#define UNITARY_CACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <unordered_map>
+#include "Matrix.h"
+
+struct UnitaryCacheStatistics {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;  // matrix storage held
+};
+
+std::ostream& operator<<(std::ostream& os, const UnitaryCacheStatistics& stats);
+
+// Least-recently-used store of dense operators under a byte budget. Keys describe the
+// operator's content (e.g. a timestep's gates), so entries stay valid however the circuit
+// that produced them is edited; matrices are shared, so a hit costs no copy. Safe to use
+// from several threads.
+class UnitaryCache {
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const Matrix>>;
+    std::size_t capacity;
+    std::size_t bytes;
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    UnitaryCacheStatistics stats;
+    mutable std::mutex mutex;
+
+public:
+    explicit UnitaryCache(std::size_t capacityBytes = std::size_t(256) << 20);
+
+    // Null on a miss; a hit becomes the most recently used entry
+    std::shared_ptr<const Matrix> find(const std::string& key);
+    // Evicts least recently used entries until the budget holds; a matrix larger than the
+    // whole budget is not kept
+    void insert(const std::string& key, std::shared_ptr<const Matrix> matrix);
+    void clear();
+
+    std::size_t getCapacity() const;
+    UnitaryCacheStatistics getStatistics() const;
+};
+
+#endif // UNITARY_CACHE_H